@@ -0,0 +1,50 @@
+#!/bin/bash
+# release build of templateAlgo with profile guided and link time optimization
+# usage: ./pgoBuild.sh [session.csv|synthetic] [march]
+#
+# 1. baseline -O2 build, tick to order of the replayed session recorded to build-pgo/baseline.json
+# 2. LTO + -march build, recorded to build-pgo/lto.json
+# 3. instrumented build, trained by replaying the session through templateAlgo_bench
+# 4. build with the profile, tick to order reported against both previous builds
+# the module installed by the last stage is the optimized one
+
+SESSION=${1:-synthetic}
+MARCH=${2:-native}
+BIN_DIR=/root/Utrade/muTrade-1.0.0-Linux_I2
+BUILD_DIR=build-pgo
+
+set -e
+if [ "$SESSION" != "synthetic" ]; then
+	SESSION=$(readlink -f "$SESSION")
+fi
+BENCH="$BIN_DIR/templateAlgo_bench --filter replay --replay $SESSION"
+mkdir -p $BUILD_DIR
+cd $BUILD_DIR
+
+stage()
+{
+	cmake -DCMAKE_BUILD_TYPE="Release" -DTEMPLATE_BENCH=ON "$@" ..
+	make clean
+	make
+}
+
+medianOf()
+{
+	sed -n 's/.*"replay\/tickToOrder".*"median_ns": \([0-9.]*\).*/\1/p' $1
+}
+
+stage -DTEMPLATE_LTO=OFF -DTEMPLATE_MARCH="" -DTEMPLATE_PGO=""
+$BENCH --out baseline.json
+
+stage -DTEMPLATE_LTO=ON -DTEMPLATE_MARCH=$MARCH -DTEMPLATE_PGO=""
+$BENCH --out lto.json
+
+# make clean keeps the profile directory, drop the previous training
+rm -rf pgo
+stage -DTEMPLATE_LTO=ON -DTEMPLATE_MARCH=$MARCH -DTEMPLATE_PGO=GENERATE
+$BENCH --replay-passes 5 > /dev/null
+
+stage -DTEMPLATE_LTO=ON -DTEMPLATE_MARCH=$MARCH -DTEMPLATE_PGO=USE
+$BENCH --baseline baseline.json --out pgo.json
+
+echo "tick to order median ns: -O2 $(medianOf baseline.json), LTO -march=$MARCH $(medianOf lto.json), LTO+PGO $(medianOf pgo.json)"
@@ -0,0 +1,99 @@
+/**
+ * Allocation counting diagnostic mode, checking side.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include "allocationCounter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    namespace
+    {
+      const size_t MAX_SITES = 64;
+
+      // plain statics, nothing here may allocate
+      AllocationSite *sites[MAX_SITES];
+      size_t siteCount = 0;
+      uint64_t warmupCalls = 100;
+      bool isFailOnAllocation = true;
+
+      void writeStderr(const char *buffer, int length)
+      {
+        if (length <= 0)
+          return;
+        ssize_t ret = ::write(STDERR_FILENO, buffer, (size_t)length);
+        (void)ret;
+      }
+    }
+
+    AllocationScope::AllocationScope(AllocationSite &site) : _site(site), _begin(0)
+    {
+      if (!_site.isRegistered)
+      {
+        _site.isRegistered = true;
+        if (siteCount < MAX_SITES)
+          sites[siteCount++] = &_site;
+      }
+      if (api2AllocationCount)
+        _begin = api2AllocationCount();
+    }
+
+    AllocationScope::~AllocationScope()
+    {
+      ++_site.calls;
+      if (!api2AllocationCount)
+        return;
+
+      uint64_t allocations = api2AllocationCount() - _begin;
+      if (allocations == 0)
+        return;
+
+      ++_site.allocatingCalls;
+      _site.allocations += allocations;
+      if (_site.calls <= warmupCalls)
+        return;
+
+      char buffer[256];
+      int length = snprintf(buffer, sizeof(buffer), "ALLOCATION_COUNTING: %s allocated %llu times in steady state (call %llu)\n",
+                            _site.name, (unsigned long long)allocations, (unsigned long long)_site.calls);
+      writeStderr(buffer, length);
+      if (isFailOnAllocation)
+      {
+        report();
+        abort();
+      }
+    }
+
+    void AllocationScope::setWarmupCalls(uint64_t calls)
+    {
+      warmupCalls = calls;
+    }
+
+    void AllocationScope::setFailOnAllocation(bool isFail)
+    {
+      isFailOnAllocation = isFail;
+    }
+
+    void AllocationScope::report()
+    {
+      char buffer[256];
+      int length = snprintf(buffer, sizeof(buffer), "ALLOCATION_COUNTING: interposer %s, warmup calls %llu\n",
+                            api2AllocationCount ? "active" : "NOT preloaded", (unsigned long long)warmupCalls);
+      writeStderr(buffer, length);
+      for (size_t i = 0; i < siteCount; ++i)
+      {
+        length = snprintf(buffer, sizeof(buffer), "ALLOCATION_COUNTING: %-24s calls %llu, allocating calls %llu, allocations %llu\n",
+                          sites[i]->name, (unsigned long long)sites[i]->calls,
+                          (unsigned long long)sites[i]->allocatingCalls, (unsigned long long)sites[i]->allocations);
+        writeStderr(buffer, length);
+      }
+    }
+  }
+}
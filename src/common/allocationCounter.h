@@ -0,0 +1,82 @@
+#ifndef API2_ALLOCATION_COUNTER_H
+#define API2_ALLOCATION_COUNTER_H
+
+/**
+ * Allocation counting diagnostic mode.
+ * Build with -DALLOCATION_COUNTING=ON and preload the interposer library built alongside
+ * (LD_PRELOAD=liballocationInterposer.so), it counts malloc family calls per thread.
+ * ALLOCATION_SCOPE(name) at the top of a hot path callback checks that the callback did not allocate,
+ * once the site is past its warm up calls an allocating call is reported on stderr and aborts the run.
+ * Without ALLOCATION_COUNTING the macro compiles to nothing.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief allocations of the calling thread so far, defined by the interposer library, NULL when it is not preloaded
+ */
+extern "C" uint64_t api2AllocationCount() __attribute__((weak));
+
+namespace API2
+{
+  namespace COMMON
+  {
+    /**
+     * @brief statistics of one checked callback
+     */
+    struct AllocationSite
+    {
+      const char *name;
+      uint64_t calls;
+      uint64_t allocatingCalls;
+      uint64_t allocations;
+      bool isRegistered;
+    };
+
+    class AllocationScope
+    {
+      AllocationSite &_site;
+      uint64_t _begin;
+
+      AllocationScope(const AllocationScope &) = delete;
+      AllocationScope &operator=(const AllocationScope &) = delete;
+
+    public:
+      explicit AllocationScope(AllocationSite &site);
+      ~AllocationScope();
+
+      /**
+       * @brief calls of every site allowed to allocate before steady state, e.g. lazy initialisation
+       */
+      static void setWarmupCalls(uint64_t warmupCalls);
+
+      /**
+       * @brief abort on an allocating call after warm up (default), otherwise only report it
+       */
+      static void setFailOnAllocation(bool isFailOnAllocation);
+
+      static bool isActive() { return api2AllocationCount != NULL; }
+
+      /**
+       * @brief print statistics of all sites on stderr
+       */
+      static void report();
+    };
+  }
+}
+
+#ifdef ALLOCATION_COUNTING
+#define ALLOCATION_SCOPE_CONCAT_(a, b) a##b
+#define ALLOCATION_SCOPE_CONCAT(a, b) ALLOCATION_SCOPE_CONCAT_(a, b)
+#define ALLOCATION_SCOPE(name)                                                                                       \
+  static API2::COMMON::AllocationSite ALLOCATION_SCOPE_CONCAT(allocationSite_, __LINE__) = {name, 0, 0, 0, false}; \
+  API2::COMMON::AllocationScope ALLOCATION_SCOPE_CONCAT(allocationScope_, __LINE__)(ALLOCATION_SCOPE_CONCAT(allocationSite_, __LINE__))
+#else
+#define ALLOCATION_SCOPE(name)
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+/**
+ * malloc family interposer of the allocation counting diagnostic mode, preload it with LD_PRELOAD.
+ * Every call is forwarded to glibc and counted per thread, operator new ends up in malloc so it is counted too.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+extern "C"
+{
+  void *__libc_malloc(size_t size);
+  void *__libc_calloc(size_t count, size_t size);
+  void *__libc_realloc(void *pointer, size_t size);
+  void *__libc_memalign(size_t alignment, size_t size);
+  void __libc_free(void *pointer);
+}
+
+namespace
+{
+  // initial-exec keeps TLS access free of allocation
+  __thread uint64_t threadAllocationCount __attribute__((tls_model("initial-exec"))) = 0;
+}
+
+extern "C"
+{
+  uint64_t api2AllocationCount()
+  {
+    return threadAllocationCount;
+  }
+
+  void *malloc(size_t size)
+  {
+    ++threadAllocationCount;
+    return __libc_malloc(size);
+  }
+
+  void *calloc(size_t count, size_t size)
+  {
+    ++threadAllocationCount;
+    return __libc_calloc(count, size);
+  }
+
+  void *realloc(void *pointer, size_t size)
+  {
+    ++threadAllocationCount;
+    return __libc_realloc(pointer, size);
+  }
+
+  void *memalign(size_t alignment, size_t size)
+  {
+    ++threadAllocationCount;
+    return __libc_memalign(alignment, size);
+  }
+
+  void *aligned_alloc(size_t alignment, size_t size)
+  {
+    ++threadAllocationCount;
+    return __libc_memalign(alignment, size);
+  }
+
+  int posix_memalign(void **pointer, size_t alignment, size_t size)
+  {
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0)
+      return EINVAL;
+    ++threadAllocationCount;
+    void *memory = __libc_memalign(alignment, size);
+    if (memory == NULL)
+      return ENOMEM;
+    *pointer = memory;
+    return 0;
+  }
+
+  void free(void *pointer)
+  {
+    __libc_free(pointer);
+  }
+}
@@ -0,0 +1,212 @@
+#ifndef API2_BAR_AGGREGATOR_H
+#define API2_BAR_AGGREGATOR_H
+
+/**
+ * In process multi timeframe OHLCV bars of one symbol, built incrementally from trade ticks and book mids.
+ * Every timeframe keeps a fixed size ring of closed bars, memory is allocated once at construction.
+ * Bars are closed by the first update past their end or by onTimer, closed bars are handed to the strategy by
+ * dispatchClosedBars, typically from onTimerEvent.
+ * A bar with trades has OHLC of trade prices, a bar without any trade falls back to OHLC of book mids.
+ * Intervals without any update produce no bar.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <apiDataTypes.h>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    class BarAggregator
+    {
+    public:
+      struct Bar
+      {
+        int64_t startTime;
+        API2::DATA_TYPES::PRICE open;
+        API2::DATA_TYPES::PRICE high;
+        API2::DATA_TYPES::PRICE low;
+        API2::DATA_TYPES::PRICE close;
+        int64_t volume;
+        double notional;
+        uint32_t tradeCount;
+
+        double getVwap() const { return volume > 0 ? notional / volume : close; }
+      };
+
+    private:
+      struct Timeframe
+      {
+        int64_t length;
+        std::vector<Bar> history;
+        uint64_t closedCount;     // bars closed so far, history index is closedCount % history.size()
+        uint64_t dispatchedCount; // bars already handed to dispatchClosedBars
+        Bar current;
+        bool isOpen;
+      };
+
+      std::vector<Timeframe> _timeframes;
+
+      static void startBar(Timeframe &timeframe, int64_t timestamp, API2::DATA_TYPES::PRICE price)
+      {
+        Bar &bar = timeframe.current;
+        bar.startTime = timestamp - timestamp % timeframe.length;
+        bar.open = bar.high = bar.low = bar.close = price;
+        bar.volume = 0;
+        bar.notional = 0;
+        bar.tradeCount = 0;
+        timeframe.isOpen = true;
+      }
+
+      static void closeBar(Timeframe &timeframe)
+      {
+        timeframe.history[timeframe.closedCount % timeframe.history.size()] = timeframe.current;
+        ++timeframe.closedCount;
+        timeframe.isOpen = false;
+      }
+
+      static void roll(Timeframe &timeframe, int64_t timestamp, API2::DATA_TYPES::PRICE price)
+      {
+        if (timeframe.isOpen && timestamp >= timeframe.current.startTime + timeframe.length)
+          closeBar(timeframe);
+        if (!timeframe.isOpen)
+          startBar(timeframe, timestamp, price);
+      }
+
+    public:
+      /**
+       * @brief BarAggregator
+       * @param lengths - bar length of each timeframe, in unit of the timestamps passed in (e.g. nanoseconds)
+       * @param historySize - closed bars kept per timeframe
+       */
+      BarAggregator(const std::vector<int64_t> &lengths, size_t historySize)
+      {
+        _timeframes.resize(lengths.size());
+        for (size_t i = 0; i < lengths.size(); ++i)
+        {
+          Timeframe &timeframe = _timeframes[i];
+          timeframe.length = lengths[i] > 0 ? lengths[i] : 1;
+          timeframe.history.resize(historySize > 0 ? historySize : 1);
+          timeframe.closedCount = 0;
+          timeframe.dispatchedCount = 0;
+          timeframe.isOpen = false;
+        }
+      }
+
+      /**
+       * @brief add a trade to all timeframes
+       */
+      void onTrade(API2::DATA_TYPES::PRICE price, API2::DATA_TYPES::QTY qty, int64_t timestamp)
+      {
+        for (size_t i = 0; i < _timeframes.size(); ++i)
+        {
+          Timeframe &timeframe = _timeframes[i];
+          roll(timeframe, timestamp, price);
+          Bar &bar = timeframe.current;
+          if (bar.tradeCount == 0)
+          {
+            // first trade replaces OHLC built from mids
+            bar.open = bar.high = bar.low = price;
+          }
+          if (price > bar.high)
+            bar.high = price;
+          if (price < bar.low)
+            bar.low = price;
+          bar.close = price;
+          bar.volume += qty;
+          bar.notional += (double)price * qty;
+          ++bar.tradeCount;
+        }
+      }
+
+      /**
+       * @brief add a book mid to all timeframes, only moves OHLC of bars without trades
+       */
+      void onMid(API2::DATA_TYPES::PRICE midPrice, int64_t timestamp)
+      {
+        if (midPrice <= 0)
+          return;
+        for (size_t i = 0; i < _timeframes.size(); ++i)
+        {
+          Timeframe &timeframe = _timeframes[i];
+          roll(timeframe, timestamp, midPrice);
+          Bar &bar = timeframe.current;
+          if (bar.tradeCount != 0)
+            continue;
+          if (midPrice > bar.high)
+            bar.high = midPrice;
+          if (midPrice < bar.low)
+            bar.low = midPrice;
+          bar.close = midPrice;
+        }
+      }
+
+      /**
+       * @brief close bars whose interval ended before now even without a new update
+       */
+      void onTimer(int64_t now)
+      {
+        for (size_t i = 0; i < _timeframes.size(); ++i)
+        {
+          Timeframe &timeframe = _timeframes[i];
+          if (timeframe.isOpen && now >= timeframe.current.startTime + timeframe.length)
+            closeBar(timeframe);
+        }
+      }
+
+      /**
+       * @brief hand every bar closed since last call to handler, oldest first per timeframe.
+       *        If more than historySize bars closed in between, only the last historySize are delivered.
+       * @param handler - callable as handler(size_t timeframe, const Bar &bar)
+       * @return number of bars delivered
+       */
+      template <typename Handler>
+      size_t dispatchClosedBars(Handler &&handler)
+      {
+        size_t count = 0;
+        for (size_t i = 0; i < _timeframes.size(); ++i)
+        {
+          Timeframe &timeframe = _timeframes[i];
+          if (timeframe.closedCount - timeframe.dispatchedCount > timeframe.history.size())
+            timeframe.dispatchedCount = timeframe.closedCount - timeframe.history.size();
+          for (; timeframe.dispatchedCount < timeframe.closedCount; ++timeframe.dispatchedCount, ++count)
+            handler(i, timeframe.history[timeframe.dispatchedCount % timeframe.history.size()]);
+        }
+        return count;
+      }
+
+      size_t getTimeframeCount() const { return _timeframes.size(); }
+      int64_t getLength(size_t timeframe) const { return _timeframes[timeframe].length; }
+
+      /**
+       * @brief number of closed bars available in history of a timeframe
+       */
+      size_t getHistorySize(size_t timeframe) const
+      {
+        const Timeframe &t = _timeframes[timeframe];
+        return t.closedCount < t.history.size() ? (size_t)t.closedCount : t.history.size();
+      }
+
+      /**
+       * @brief closed bar of a timeframe, ago 0 is the latest closed bar. ago must be below getHistorySize
+       */
+      const Bar &getBar(size_t timeframe, size_t ago) const
+      {
+        const Timeframe &t = _timeframes[timeframe];
+        return t.history[(t.closedCount - 1 - ago) % t.history.size()];
+      }
+
+      /**
+       * @brief bar being built, valid if isBarOpen
+       */
+      const Bar &getCurrentBar(size_t timeframe) const { return _timeframes[timeframe].current; }
+      bool isBarOpen(size_t timeframe) const { return _timeframes[timeframe].isOpen; }
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,354 @@
+/**
+ * Batched persistence of table rows, escaped into reusable buffers, written as multi-row INSERTs or CSV by a writer thread.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include "batchedRowWriter.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#ifdef TEMPLATE_SQLITE
+#include <sqlite3.h>
+#endif
+
+namespace API2
+{
+  namespace COMMON
+  {
+    namespace
+    {
+      // digits of value right aligned in buffer, returns the first one
+      char *formatUnsigned(uint64_t value, char *end)
+      {
+        char *p = end;
+        do
+        {
+          *--p = (char)('0' + value % 10);
+          value /= 10;
+        } while (value != 0);
+        return p;
+      }
+
+      // "name TYPE, name TYPE" to "name,name"
+      std::string getColumnNames(const std::string &columns)
+      {
+        std::string names;
+        size_t begin = 0;
+        while (begin < columns.size())
+        {
+          size_t end = columns.find(',', begin);
+          if (end == std::string::npos)
+            end = columns.size();
+          size_t name = columns.find_first_not_of(' ', begin);
+          if (name < end)
+          {
+            size_t nameEnd = columns.find(' ', name);
+            if (!names.empty())
+              names += ',';
+            names.append(columns, name, std::min(nameEnd, end) - name);
+          }
+          begin = end + 1;
+        }
+        return names;
+      }
+
+      bool writeAll(int fd, const char *data, size_t size)
+      {
+        while (size > 0)
+        {
+          ssize_t written = ::write(fd, data, size);
+          if (written < 0)
+          {
+            if (errno == EINTR)
+              continue;
+            return false;
+          }
+          data += written;
+          size -= written;
+        }
+        return true;
+      }
+    }
+
+    void RowBuffer::addInt(int64_t value)
+    {
+      separate();
+      char buffer[24];
+      char *end = buffer + sizeof(buffer);
+      char *begin = formatUnsigned(value < 0 ? 0 - (uint64_t)value : (uint64_t)value, end);
+      if (value < 0)
+        *--begin = '-';
+      _text.append(begin, end - begin);
+    }
+
+    void RowBuffer::addUnsigned(uint64_t value)
+    {
+      separate();
+      char buffer[24];
+      char *end = buffer + sizeof(buffer);
+      char *begin = formatUnsigned(value, end);
+      _text.append(begin, end - begin);
+    }
+
+    void RowBuffer::addDouble(double value)
+    {
+      if (!isfinite(value))
+      {
+        addNull();
+        return;
+      }
+      separate();
+      char buffer[32];
+      int length = snprintf(buffer, sizeof(buffer), "%.17g", value);
+      _text.append(buffer, length);
+    }
+
+    // quotes doubled inside the quotes of the target, SQL '' and CSV "", nul bytes would end the statement and are dropped
+    void RowBuffer::addText(const char *text, size_t length)
+    {
+      separate();
+      char quote = _target == RowWriterTarget_SQLITE ? '\'' : '"';
+      _text += quote;
+      size_t begin = 0;
+      for (size_t i = 0; i < length; ++i)
+      {
+        if (text[i] != quote && text[i] != 0)
+          continue;
+        _text.append(text + begin, i - begin);
+        if (text[i] == quote)
+          _text.append(2, quote);
+        begin = i + 1;
+      }
+      _text.append(text + begin, length - begin);
+      _text += quote;
+    }
+
+    void RowBuffer::addText(const char *text)
+    {
+      if (text == NULL)
+        addNull();
+      else
+        addText(text, strlen(text));
+    }
+
+    void RowBuffer::addNull()
+    {
+      separate();
+      if (_target == RowWriterTarget_SQLITE)
+        _text += "NULL";
+    }
+
+    BatchedRowWriter::BatchedRowWriter() : _active(&_buffers[0]), _isStopping(false), _isOpen(false), _database(NULL), _fd(-1),
+                                           _writtenRowCount(0), _batchCount(0), _blockedCount(0), _errorCount(0)
+    {
+    }
+
+    BatchedRowWriter::~BatchedRowWriter() { close(); }
+
+    bool BatchedRowWriter::open(const RowWriterConfig &config, const ThreadPlacement &placement, std::string &error)
+    {
+      if (isOpen())
+      {
+        error = "already open";
+        return false;
+      }
+      _config = config;
+      if (_config.maxRows == 0)
+        _config.maxRows = 1;
+      if (_config.maxBytes == 0)
+        _config.maxBytes = 1;
+      if (_config.target == RowWriterTarget_SQLITE ? !openSqlite(error) : !openCsv(error))
+        return false;
+
+      // steady state appends and writes never allocate, a writer behind grows the buffers once up to the limit append waits at
+      for (int i = 0; i < 2; ++i)
+      {
+        _buffers[i].reset(_config.target);
+        _buffers[i].reserve(_config.maxBytes + _config.maxBytes / 4, _config.maxRows + _config.maxRows / 4);
+      }
+      _statement.reserve(_config.maxBytes + _config.maxBytes / 4 + 64 * (_config.maxRows / SQLITE_ROWS_PER_INSERT + 2));
+      _active = &_buffers[0];
+      _isStopping = false;
+      _isOpen.store(true);
+      _writer = std::thread(&BatchedRowWriter::run, this);
+      _placementError.clear();
+      placement.apply(_writer.native_handle(), _placementError);
+      return true;
+    }
+
+    bool BatchedRowWriter::openSqlite(std::string &error)
+    {
+#ifdef TEMPLATE_SQLITE
+      sqlite3 *database = NULL;
+      if (sqlite3_open_v2(_config.path.c_str(), &database, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, NULL) != SQLITE_OK)
+      {
+        error = "sqlite3_open " + _config.path + ": " + (database ? sqlite3_errmsg(database) : "out of memory");
+        sqlite3_close(database);
+        return false;
+      }
+      // WAL with synchronous NORMAL, a batch is one fsync-free transaction, readers do not block the writer
+      std::string setup = "PRAGMA journal_mode=WAL;PRAGMA synchronous=NORMAL;CREATE TABLE IF NOT EXISTS " + _config.table + " (" + _config.columns + ");";
+      char *message = NULL;
+      if (sqlite3_exec(database, setup.c_str(), NULL, NULL, &message) != SQLITE_OK)
+      {
+        error = "sqlite3 " + _config.path + ": " + (message ? message : "setup failed");
+        sqlite3_free(message);
+        sqlite3_close(database);
+        return false;
+      }
+      _database = database;
+      _insertPrefix = "INSERT INTO " + _config.table + " VALUES ";
+      return true;
+#else
+      error = "built without TEMPLATE_SQLITE, " + _config.path + " not opened";
+      return false;
+#endif
+    }
+
+    bool BatchedRowWriter::openCsv(std::string &error)
+    {
+      _fd = ::open(_config.path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+      if (_fd < 0)
+      {
+        error = "open " + _config.path + ": " + strerror(errno);
+        return false;
+      }
+      struct stat fileStat;
+      if (fstat(_fd, &fileStat) == 0 && fileStat.st_size == 0)
+      {
+        std::string header = getColumnNames(_config.columns) + "\n";
+        if (!writeAll(_fd, header.data(), header.size()))
+        {
+          error = "write " + _config.path + ": " + strerror(errno);
+          ::close(_fd);
+          _fd = -1;
+          return false;
+        }
+      }
+      return true;
+    }
+
+    void BatchedRowWriter::close()
+    {
+      if (!isOpen())
+        return;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _isStopping = true;
+      }
+      _wakeup.notify_one();
+      if (_writer.joinable())
+        _writer.join();
+      _isOpen.store(false);
+      closeTarget();
+    }
+
+    void BatchedRowWriter::closeTarget()
+    {
+#ifdef TEMPLATE_SQLITE
+      if (_database)
+        sqlite3_close((sqlite3 *)_database);
+#endif
+      _database = NULL;
+      if (_fd >= 0)
+        ::close(_fd);
+      _fd = -1;
+    }
+
+    std::string BatchedRowWriter::getLastError()
+    {
+      std::lock_guard<std::mutex> lock(_errorMutex);
+      return _lastError;
+    }
+
+    bool BatchedRowWriter::writeSqlite(const RowBuffer &batch, std::string &error)
+    {
+#ifdef TEMPLATE_SQLITE
+      const std::string &text = batch.getText();
+      _statement.assign("BEGIN;");
+      size_t begin = 0;
+      for (size_t row = 0; row < batch.getRowCount(); row += SQLITE_ROWS_PER_INSERT)
+      {
+        size_t last = std::min(row + SQLITE_ROWS_PER_INSERT, batch.getRowCount()) - 1;
+        size_t end = batch.getRowEnd(last);
+        _statement += _insertPrefix;
+        _statement.append(text, begin, end - 1 - begin); // trailing comma of the last row
+        _statement += ';';
+        begin = end;
+      }
+      _statement += "COMMIT;";
+      char *message = NULL;
+      if (sqlite3_exec((sqlite3 *)_database, _statement.c_str(), NULL, NULL, &message) == SQLITE_OK)
+        return true;
+      error = std::string("sqlite3 ") + (message ? message : "insert failed");
+      sqlite3_free(message);
+      sqlite3_exec((sqlite3 *)_database, "ROLLBACK;", NULL, NULL, NULL);
+      return false;
+#else
+      error = "built without TEMPLATE_SQLITE";
+      return false;
+#endif
+    }
+
+    bool BatchedRowWriter::writeCsv(const RowBuffer &batch, std::string &error)
+    {
+      if (writeAll(_fd, batch.getText().data(), batch.size()))
+        return true;
+      error = "write " + _config.path + ": " + strerror(errno);
+      return false;
+    }
+
+    void BatchedRowWriter::write(RowBuffer &batch)
+    {
+      std::string error;
+      bool isWritten = _config.target == RowWriterTarget_SQLITE ? writeSqlite(batch, error) : writeCsv(batch, error);
+      if (isWritten)
+      {
+        _writtenRowCount.fetch_add(batch.getRowCount(), std::memory_order_relaxed);
+        _batchCount.fetch_add(1, std::memory_order_relaxed);
+      }
+      else
+      {
+        _errorCount.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(_errorMutex);
+        _lastError = error;
+      }
+      batch.clear();
+    }
+
+    void BatchedRowWriter::run()
+    {
+      std::chrono::microseconds flushInterval(_config.flushIntervalMicros);
+      std::unique_lock<std::mutex> lock(_mutex);
+      for (;;)
+      {
+        if (_active->getRowCount() == 0)
+        {
+          if (_isStopping)
+            break;
+          _wakeup.wait(lock);
+          continue;
+        }
+        std::chrono::steady_clock::time_point deadline = _batchStart + flushInterval;
+        if (!_isStopping && _active->getRowCount() < _config.maxRows && _active->size() < _config.maxBytes && std::chrono::steady_clock::now() < deadline)
+        {
+          _wakeup.wait_until(lock, deadline);
+          continue;
+        }
+        RowBuffer *batch = _active;
+        _active = batch == &_buffers[0] ? &_buffers[1] : &_buffers[0];
+        lock.unlock();
+        _batchTaken.notify_all();
+        write(*batch);
+        lock.lock();
+      }
+    }
+  }
+}
@@ -0,0 +1,262 @@
+#ifndef API2_BATCHED_ROW_WRITER_H
+#define API2_BATCHED_ROW_WRITER_H
+
+/**
+ * Batched persistence of table rows.
+ * Fields are escaped straight into the text of the current batch, a reusable buffer, instead of a std::string per field
+ * as API2::DBConverter::getDBString returns. A writer thread takes the batch once it holds maxRows rows, maxBytes of text or
+ * is flushIntervalMicros old, hands an empty buffer back and writes the batch as multi-row INSERTs in one transaction
+ * (SQLite file, the local stand-in of the database) or appends it to a CSV bulk-load file.
+ * Rows are appended under a lock the writer only takes to swap buffers, call append from a worker thread (e.g. the formatter of
+ * a DeferredLog), never from the strategy thread. The writer drops no row, while it is behind by more than MAX_BATCHES_BEHIND
+ * batches append waits for it to take the current batch, so backpressure stays on the appending worker. A worker blocked here
+ * stops draining its own ring though, e.g. a full DeferredLog ring then drops confirmations in claim() upstream.
+ * SQLite is available when built with TEMPLATE_SQLITE.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include "threadPlacement.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    enum RowWriterTarget
+    {
+      RowWriterTarget_SQLITE = 0,
+      RowWriterTarget_CSV,
+      RowWriterTarget_MAX
+    };
+
+    inline const char *RowWriterTargetStr(RowWriterTarget v)
+    {
+      switch (v)
+      {
+      case RowWriterTarget_SQLITE:
+        return "SQLITE";
+      case RowWriterTarget_CSV:
+        return "CSV";
+      default:
+        return "[Unknown RowWriterTarget]";
+      }
+    }
+
+    /**
+     * @brief target of a config name
+     * @return RowWriterTarget_MAX if name is unknown
+     */
+    inline RowWriterTarget getRowWriterTarget(const std::string &name)
+    {
+      for (int i = 0; i < RowWriterTarget_MAX; ++i)
+        if (name == RowWriterTargetStr((RowWriterTarget)i))
+          return (RowWriterTarget)i;
+      return RowWriterTarget_MAX;
+    }
+
+    /**
+     * @brief rows of a batch as SQL values "(1,'a''b',NULL)," or CSV lines "1,\"a\"\"b\",\n", escaped while appended
+     */
+    class RowBuffer
+    {
+      std::string _text;
+      std::vector<size_t> _rowEnds;
+      RowWriterTarget _target;
+      bool _isFirstField;
+
+      void separate()
+      {
+        if (!_isFirstField)
+          _text += ',';
+        _isFirstField = false;
+      }
+
+    public:
+      explicit RowBuffer(RowWriterTarget target = RowWriterTarget_SQLITE) : _target(target), _isFirstField(true) {}
+
+      /**
+       * @brief empty the buffer for another target, capacity is kept
+       */
+      void reset(RowWriterTarget target)
+      {
+        clear();
+        _target = target;
+      }
+
+      void reserve(size_t bytes, size_t rows)
+      {
+        _text.reserve(bytes);
+        _rowEnds.reserve(rows);
+      }
+
+      void clear()
+      {
+        _text.clear();
+        _rowEnds.clear();
+        _isFirstField = true;
+      }
+
+      void beginRow()
+      {
+        if (_target == RowWriterTarget_SQLITE)
+          _text += '(';
+        _isFirstField = true;
+      }
+
+      void endRow()
+      {
+        _text += _target == RowWriterTarget_SQLITE ? ")," : "\n";
+        _rowEnds.push_back(_text.size());
+      }
+
+      void addInt(int64_t value);
+      void addUnsigned(uint64_t value);
+      // nan and inf are stored as NULL / empty
+      void addDouble(double value);
+      void addText(const char *text, size_t length);
+      void addText(const char *text);
+      void addText(const std::string &text) { addText(text.data(), text.size()); }
+      void addNull();
+
+      const std::string &getText() const { return _text; }
+      size_t size() const { return _text.size(); }
+      size_t getRowCount() const { return _rowEnds.size(); }
+      size_t getRowEnd(size_t row) const { return _rowEnds[row]; }
+    };
+
+    struct RowWriterConfig
+    {
+      RowWriterTarget target = RowWriterTarget_SQLITE;
+      std::string path;
+      std::string table;
+      std::string columns; // "name TYPE, name TYPE ..." in row order, CSV header is the names
+      size_t maxRows = 500;
+      size_t maxBytes = 1 << 20;
+      int flushIntervalMicros = 1000000;
+    };
+
+    class BatchedRowWriter
+    {
+    public:
+      static const size_t MAX_BATCHES_BEHIND = 4;
+      static const size_t SQLITE_ROWS_PER_INSERT = 500; // rows of a VALUES list older SQLite versions accept
+
+      BatchedRowWriter();
+
+      /**
+       * @brief writes pending rows and closes
+       */
+      ~BatchedRowWriter();
+
+      /**
+       * @brief open target (SQLite table is created if missing, CSV file gets a header when empty) and start the writer thread
+       * @param config
+       * @param placement - cpu affinity and priority of the writer
+       * @param error - reason if failed
+       * @return false if target can not be opened. Writer still runs if placement fails, see getPlacementError
+       */
+      bool open(const RowWriterConfig &config, const ThreadPlacement &placement, std::string &error);
+
+      /**
+       * @brief write pending rows and stop the writer. Rows must not be appended while it closes
+       */
+      void close();
+
+      bool isOpen() const { return _isOpen.load(std::memory_order_relaxed); }
+
+      /**
+       * @brief append a row to the current batch
+       * @param fill - callable as fill(RowBuffer &), adds the fields of the row in column order
+       * @return false if not open. Waits while the writer is behind, see getBlockedCount
+       */
+      template <typename Fill>
+      bool append(Fill fill)
+      {
+        if (!isOpen())
+          return false;
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_active->size() >= _config.maxBytes * MAX_BATCHES_BEHIND || _active->getRowCount() >= _config.maxRows * MAX_BATCHES_BEHIND)
+        {
+          _blockedCount.fetch_add(1, std::memory_order_relaxed);
+          _wakeup.notify_one();
+          while (!_isStopping && (_active->size() >= _config.maxBytes * MAX_BATCHES_BEHIND || _active->getRowCount() >= _config.maxRows * MAX_BATCHES_BEHIND))
+            _batchTaken.wait(lock);
+        }
+        bool isFirstRow = _active->getRowCount() == 0;
+        if (isFirstRow)
+          _batchStart = std::chrono::steady_clock::now();
+        _active->beginRow();
+        fill(*_active);
+        _active->endRow();
+        bool isFull = _active->getRowCount() >= _config.maxRows || _active->size() >= _config.maxBytes;
+        lock.unlock();
+        // an idle writer waits without deadline, the first row starts its flushIntervalMicros wait
+        if (isFirstRow || isFull)
+          _wakeup.notify_one();
+        return true;
+      }
+
+      const std::string &getPlacementError() const { return _placementError; }
+
+      /**
+       * @brief error of the last batch not written, empty if none
+       */
+      std::string getLastError();
+
+      uint64_t getWrittenRowCount() const { return _writtenRowCount.load(std::memory_order_relaxed); }
+      uint64_t getBatchCount() const { return _batchCount.load(std::memory_order_relaxed); }
+      // appends that waited for the writer
+      uint64_t getBlockedCount() const { return _blockedCount.load(std::memory_order_relaxed); }
+      uint64_t getErrorCount() const { return _errorCount.load(std::memory_order_relaxed); }
+
+    private:
+      RowWriterConfig _config;
+      RowBuffer _buffers[2];
+      RowBuffer *_active; // rows are appended here, the other buffer is the batch being written
+      std::chrono::steady_clock::time_point _batchStart;
+      bool _isStopping;
+      std::mutex _mutex;
+      std::condition_variable _wakeup;
+      std::condition_variable _batchTaken; // appends waiting while the writer is behind
+      std::atomic<bool> _isOpen;
+      std::thread _writer;
+      std::string _placementError;
+
+      // writer thread only
+      void *_database; // sqlite3
+      int _fd;
+      std::string _statement;
+      std::string _insertPrefix;
+
+      std::mutex _errorMutex;
+      std::string _lastError;
+      std::atomic<uint64_t> _writtenRowCount;
+      std::atomic<uint64_t> _batchCount;
+      std::atomic<uint64_t> _blockedCount;
+      std::atomic<uint64_t> _errorCount;
+
+      BatchedRowWriter(const BatchedRowWriter &) = delete;
+      BatchedRowWriter &operator=(const BatchedRowWriter &) = delete;
+
+      bool openSqlite(std::string &error);
+      bool openCsv(std::string &error);
+      bool writeSqlite(const RowBuffer &batch, std::string &error);
+      bool writeCsv(const RowBuffer &batch, std::string &error);
+      void write(RowBuffer &batch);
+      void closeTarget();
+      void run();
+    };
+  }
+}
+
+#endif
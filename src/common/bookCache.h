@@ -0,0 +1,203 @@
+#ifndef API2_BOOK_CACHE_H
+#define API2_BOOK_CACHE_H
+
+/**
+ * Process wide cache of the market depth of each symbol, shared by all strategies of the library.
+ * A depth update is copied out of MktData by the first strategy that sees it and published under a seqlock,
+ * other strategies trading the same symbol and monitoring threads copy the cached depth without locks instead of
+ * reading MktData level by level again. Memory and MktData reads are per symbol, not per strategy.
+ * An update is identified by its MktData timestamp and index counter, two updates within one nanosecond differ in the
+ * counter. An update without timestamp (0) is never served from the cache, and an entry is never replaced by an older
+ * update, so a strategy that lags behind reads MktData itself instead of rolling the cache back.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <sharedDefines.h>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    template <typename Snapshot>
+    class BookCache
+    {
+      static_assert(std::is_trivially_copyable<Snapshot>::value, "BookCache snapshots must be trivially copyable");
+
+    public:
+      /**
+       * @brief depth of one symbol, address is stable for the life of the cache
+       */
+      struct alignas(64) Entry
+      {
+        std::atomic<uint64_t> sequence; // odd while a writer copies, 0 until first publish
+        int64_t updateTimestamp;        // MktData timestamp of snapshot, written under sequence
+        uint64_t updateIndex;           // MktData index counter of snapshot, written under sequence
+        Snapshot snapshot;
+        DATA_TYPES::SYMBOL_ID symbolId;
+
+        explicit Entry(DATA_TYPES::SYMBOL_ID symbolId_) : sequence(0), updateTimestamp(0), updateIndex(0), snapshot(), symbolId(symbolId_) {}
+      };
+
+    private:
+      std::vector<Entry *> _entries;
+      std::mutex _mutex;
+
+      static void pause()
+      {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+      }
+
+      BookCache(const BookCache &) = delete;
+      BookCache &operator=(const BookCache &) = delete;
+
+    public:
+      BookCache() {}
+
+      /**
+       * @brief entries still referenced by strategies must not be used after cache goes away
+       */
+      ~BookCache()
+      {
+        for (size_t i = 0; i < _entries.size(); ++i)
+        {
+          _entries[i]->~Entry();
+          free(_entries[i]);
+        }
+      }
+
+      /**
+       * @brief process wide cache shared by all strategies of the library
+       */
+      static BookCache &shared()
+      {
+        static BookCache cache;
+        return cache;
+      }
+
+      /**
+       * @brief entry of symbol, created on first request. Takes a lock, call it at setup and keep the entry
+       */
+      Entry *acquire(DATA_TYPES::SYMBOL_ID symbolId)
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (size_t i = 0; i < _entries.size(); ++i)
+          if (_entries[i]->symbolId == symbolId)
+            return _entries[i];
+        // entry is over-aligned, which plain new does not honour before C++17
+        void *memory = NULL;
+        if (posix_memalign(&memory, alignof(Entry), sizeof(Entry)) != 0)
+          throw std::bad_alloc();
+        _entries.push_back(new (memory) Entry(symbolId));
+        return _entries.back();
+      }
+
+      size_t size()
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _entries.size();
+      }
+
+      /**
+       * @brief copy the cached snapshot if it is of the given update
+       * @param entry
+       * @param updateTimestamp - MktData timestamp of the update the caller is processing
+       * @param updateIndex - MktData index counter of that update
+       * @param snapshot - content is undefined when false is returned
+       * @return false if the update is not cached yet, caller reads MktData and publishes
+       */
+      static bool read(const Entry *entry, int64_t updateTimestamp, uint64_t updateIndex, Snapshot &snapshot)
+      {
+        if (updateTimestamp == 0)
+          return false;
+        for (;;)
+        {
+          uint64_t sequence = entry->sequence.load(std::memory_order_acquire);
+          if (sequence & 1)
+          {
+            pause();
+            continue;
+          }
+          if (sequence == 0 || entry->updateTimestamp != updateTimestamp || entry->updateIndex != updateIndex)
+          {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (entry->sequence.load(std::memory_order_relaxed) == sequence)
+              return false;
+            continue;
+          }
+          memcpy(&snapshot, &entry->snapshot, sizeof(Snapshot));
+          std::atomic_thread_fence(std::memory_order_acquire);
+          if (entry->sequence.load(std::memory_order_relaxed) == sequence)
+            return true;
+        }
+      }
+
+      /**
+       * @brief copy the latest snapshot whatever update it is of, for monitoring threads
+       * @return MktData timestamp of the copied update, 0 if nothing was published yet
+       */
+      static int64_t readLatest(const Entry *entry, Snapshot &snapshot)
+      {
+        for (;;)
+        {
+          uint64_t sequence = entry->sequence.load(std::memory_order_acquire);
+          if (sequence & 1)
+          {
+            pause();
+            continue;
+          }
+          if (sequence == 0)
+            return 0;
+          memcpy(&snapshot, &entry->snapshot, sizeof(Snapshot));
+          int64_t updateTimestamp = entry->updateTimestamp;
+          std::atomic_thread_fence(std::memory_order_acquire);
+          if (entry->sequence.load(std::memory_order_relaxed) == sequence)
+            return updateTimestamp;
+        }
+      }
+
+      /**
+       * @brief publish snapshot of an update, skipped if another strategy already published it or a newer one
+       * @return false if skipped
+       */
+      static bool publish(Entry *entry, int64_t updateTimestamp, uint64_t updateIndex, const Snapshot &snapshot)
+      {
+        uint64_t sequence = entry->sequence.load(std::memory_order_relaxed);
+        for (;;)
+        {
+          if (sequence & 1)
+          {
+            pause();
+            sequence = entry->sequence.load(std::memory_order_relaxed);
+            continue;
+          }
+          // racy peek, a writer that changes it also changes sequence and the exchange below fails
+          if (sequence != 0 && updateTimestamp != 0 &&
+              (entry->updateTimestamp > updateTimestamp || (entry->updateTimestamp == updateTimestamp && entry->updateIndex >= updateIndex)))
+            return false;
+          if (entry->sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed))
+            break;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        entry->updateTimestamp = updateTimestamp;
+        entry->updateIndex = updateIndex;
+        memcpy(&entry->snapshot, &snapshot, sizeof(Snapshot));
+        entry->sequence.store(sequence + 2, std::memory_order_release);
+        return true;
+      }
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,171 @@
+/**
+ * Binary checkpoint of strategy state in a memory mapped file.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include "checkpointFile.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    namespace
+    {
+      const uint64_t CHECKPOINT_MAGIC = 0x31544b4332495041ULL; // "API2CKT1"
+      const size_t CHECKPOINT_ALIGNMENT = 64;
+
+      size_t alignUp(size_t size, size_t alignment = CHECKPOINT_ALIGNMENT)
+      {
+        return (size + alignment - 1) & ~(alignment - 1);
+      }
+    }
+
+    struct CheckpointFile::Header
+    {
+      uint64_t magic;
+      uint32_t version;
+      uint32_t payloadSize;
+    };
+
+    // sequence is written again after the payload, a copy is intact when both match,
+    // no checksum so save stays a plain copy, the sequence check covers a writer dying mid save
+    struct CheckpointFile::Copy
+    {
+      uint64_t sequence; // 0 while the copy is being written
+      char payload[1];
+    };
+
+    CheckpointFile::CheckpointFile() : _mapping(NULL), _mappingSize(0), _payloadSize(0), _sequence(0)
+    {
+    }
+
+    CheckpointFile::~CheckpointFile()
+    {
+      close();
+    }
+
+    bool CheckpointFile::open(const std::string &path, uint32_t version, size_t payloadSize, std::string &error)
+    {
+      close();
+      size_t copySize = alignUp(offsetof(Copy, payload) + alignUp(payloadSize, sizeof(uint64_t)) + sizeof(uint64_t));
+      size_t mappingSize = alignUp(sizeof(Header)) + 2 * copySize;
+
+      int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+      if (fd < 0)
+      {
+        error = "open " + path + ": " + strerror(errno);
+        return false;
+      }
+      struct stat fileStat;
+      if (fstat(fd, &fileStat) != 0)
+      {
+        error = "stat " + path + ": " + strerror(errno);
+        ::close(fd);
+        return false;
+      }
+      bool isNew = (size_t)fileStat.st_size != mappingSize;
+      if (isNew && (ftruncate(fd, 0) != 0 || ftruncate(fd, mappingSize) != 0))
+      {
+        error = "truncate " + path + ": " + strerror(errno);
+        ::close(fd);
+        return false;
+      }
+      void *mapping = mmap(NULL, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      ::close(fd);
+      if (mapping == MAP_FAILED)
+      {
+        error = "mmap " + path + ": " + strerror(errno);
+        return false;
+      }
+
+      _mapping = (char *)mapping;
+      _mappingSize = mappingSize;
+      _payloadSize = payloadSize;
+
+      Header *header = (Header *)_mapping;
+      if (isNew || header->magic != CHECKPOINT_MAGIC || header->version != version || header->payloadSize != payloadSize)
+      {
+        memset(_mapping, 0, _mappingSize);
+        header->magic = CHECKPOINT_MAGIC;
+        header->version = version;
+        header->payloadSize = (uint32_t)payloadSize;
+      }
+
+      _sequence = 0;
+      for (int i = 0; i < 2; ++i)
+      {
+        const Copy *copy = getCopy(i);
+        if (isIntact(copy) && copy->sequence > _sequence)
+          _sequence = copy->sequence;
+      }
+      return true;
+    }
+
+    void CheckpointFile::close()
+    {
+      if (_mapping == NULL)
+        return;
+      msync(_mapping, _mappingSize, MS_ASYNC);
+      munmap(_mapping, _mappingSize);
+      _mapping = NULL;
+      _mappingSize = 0;
+      _payloadSize = 0;
+      _sequence = 0;
+    }
+
+    bool CheckpointFile::load(void *payload) const
+    {
+      if (_mapping == NULL || _sequence == 0)
+        return false;
+      const Copy *copy = getCopy(_sequence & 1);
+      if (!isIntact(copy))
+        return false;
+      memcpy(payload, copy->payload, _payloadSize);
+      return true;
+    }
+
+    void CheckpointFile::save(const void *payload)
+    {
+      if (_mapping == NULL)
+        return;
+      uint64_t sequence = _sequence + 1;
+      Copy *copy = getCopy(sequence & 1);
+      __atomic_store_n(&copy->sequence, 0, __ATOMIC_RELEASE);
+      memcpy(copy->payload, payload, _payloadSize);
+      __atomic_store_n(getEndSequence(copy), sequence, __ATOMIC_RELEASE);
+      __atomic_store_n(&copy->sequence, sequence, __ATOMIC_RELEASE);
+      _sequence = sequence;
+    }
+
+    void CheckpointFile::flush()
+    {
+      if (_mapping != NULL)
+        msync(_mapping, _mappingSize, MS_ASYNC);
+    }
+
+    CheckpointFile::Copy *CheckpointFile::getCopy(int index) const
+    {
+      size_t copySize = alignUp(offsetof(Copy, payload) + alignUp(_payloadSize, sizeof(uint64_t)) + sizeof(uint64_t));
+      return (Copy *)(_mapping + alignUp(sizeof(Header)) + index * copySize);
+    }
+
+    uint64_t *CheckpointFile::getEndSequence(Copy *copy) const
+    {
+      return (uint64_t *)(copy->payload + alignUp(_payloadSize, sizeof(uint64_t)));
+    }
+
+    bool CheckpointFile::isIntact(const Copy *copy) const
+    {
+      uint64_t sequence = __atomic_load_n(&copy->sequence, __ATOMIC_ACQUIRE);
+      return sequence != 0 && sequence == __atomic_load_n(getEndSequence(const_cast<Copy *>(copy)), __ATOMIC_ACQUIRE);
+    }
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef API2_CHECKPOINT_FILE_H
+#define API2_CHECKPOINT_FILE_H
+
+/**
+ * Binary checkpoint of strategy state in a memory mapped file, used for warm restart.
+ * The file keeps two copies of a fixed size POD payload, save writes the older copy and publishes it
+ * with a sequence number written before and after the payload, so a process dying in the middle of save leaves the previous copy intact.
+ * save is a memcpy into the mapping, no system call and no allocation, it can be called from callbacks.
+ * Data reaches the disk through the page cache (flush schedules it), only a process crash is covered by save alone.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    class CheckpointFile
+    {
+    public:
+      CheckpointFile();
+      ~CheckpointFile();
+
+      /**
+       * @brief map the file, created if missing. A file of another version or payload size is reinitialized.
+       * @param path
+       * @param version - layout version of the payload, bump it whenever the payload struct changes
+       * @param payloadSize
+       * @param error - reason if failed
+       * @return false if the file can not be mapped
+       */
+      bool open(const std::string &path, uint32_t version, size_t payloadSize, std::string &error);
+
+      void close();
+
+      bool isOpen() const { return _mapping != NULL; }
+
+      /**
+       * @brief copy the latest intact payload
+       * @return false if nothing was saved yet
+       */
+      bool load(void *payload) const;
+
+      /**
+       * @brief write payload to the older copy and publish it
+       */
+      void save(const void *payload);
+
+      /**
+       * @brief schedule write back of the mapping to disk (msync MS_ASYNC)
+       */
+      void flush();
+
+      /**
+       * @brief sequence of the latest saved copy, 0 if none
+       */
+      uint64_t getSequence() const { return _sequence; }
+
+    private:
+      struct Header;
+      struct Copy;
+
+      CheckpointFile(const CheckpointFile &);
+      CheckpointFile &operator=(const CheckpointFile &);
+
+      Copy *getCopy(int index) const;
+      uint64_t *getEndSequence(Copy *copy) const;
+      bool isIntact(const Copy *copy) const;
+
+      char *_mapping;
+      size_t _mappingSize;
+      size_t _payloadSize;
+      uint64_t _sequence;
+    };
+  }
+}
+
+#endif
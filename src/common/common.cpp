@@ -174,6 +174,124 @@ namespace API2
       return true;
     }
 
+    bool getBestPrices(SIGNED_LONG symbolId,
+                       BestPriceRequest *requests,
+                       size_t count,
+                       SGContext *context)
+    {
+      MktData *mkData = context->reqQryMarketData(symbolId);
+      if (mkData == NULL)
+      {
+        DEBUG_VARSHOW(context->reqQryDebugLog(), "----GOT NULL MARKET DATA FOR-----", symbolId);
+        context->reqTerminateStrategy();
+        return false;
+      }
+
+      BestPriceBook book;
+      for (int i = 0; i < BestPriceBook::DEPTH; i++)
+      {
+        book.price[CONSTANTS::CMD_OrderMode_BUY][i] = mkData->getPrice(i, CONSTANTS::CMD_OrderMode_BUY);
+        book.qty[CONSTANTS::CMD_OrderMode_BUY][i] = mkData->getQty(i, CONSTANTS::CMD_OrderMode_BUY);
+        book.price[CONSTANTS::CMD_OrderMode_SELL][i] = mkData->getPrice(i, CONSTANTS::CMD_OrderMode_SELL);
+        book.qty[CONSTANTS::CMD_OrderMode_SELL][i] = mkData->getQty(i, CONSTANTS::CMD_OrderMode_SELL);
+      }
+      getBestPrices(book, requests, count);
+      return true;
+    }
+
+    void getBestPrices(const BestPriceBook &book,
+                       BestPriceRequest *requests,
+                       size_t count)
+    {
+      //tick size is read again only when instrument changes between requests
+      API2::COMMON::Instrument *lastInstrument = NULL;
+      SIGNED_LONG tickSize = 0;
+
+      for (size_t r = 0; r < count; r++)
+      {
+        BestPriceRequest &request = requests[r];
+        OrderWrapper &orderWrapper = *request.orderWrapper;
+        int tickFactor = request.tickFactor;
+        int mode = 0;
+        int side = 0;
+        int oppSide = 0;
+
+        if (request.side == CONSTANTS::CMD_OrderMode_BUY)
+        {
+          mode = 1;
+          side = CONSTANTS::CMD_OrderMode_BUY;
+          oppSide = CONSTANTS::CMD_OrderMode_SELL;
+        }
+        else
+        {
+          mode = -1;
+          tickFactor = -tickFactor;
+          side = CONSTANTS::CMD_OrderMode_SELL;
+          oppSide = CONSTANTS::CMD_OrderMode_BUY;
+        }
+
+        if (request.pickOpportunityEnabled)
+        {
+          if (book.qty[oppSide][0])
+            if ((mode * request.opportunityPrice) >= (mode * book.price[oppSide][0]))
+            {
+              request.price = request.opportunityPrice;
+              request.pickedOpportunity = true;
+              continue;
+            }
+        }
+
+        const SIGNED_LONG restingQty = orderWrapper.getLastQuantity() - orderWrapper.getLastFilledQuantity();
+        const SIGNED_LONG lastQuotedPrice = orderWrapper.getLastQuotedPrice();
+        bool done = false;
+        for (int i = 0; i < BestPriceBook::DEPTH && !done; i++)
+        {
+          //skip level made up only of our own order
+          if (lastQuotedPrice == book.price[side][i] && restingQty == book.qty[side][i])
+            continue;
+
+          // using qty here as we can get price = 0 as in spread contracts
+          if (book.qty[side][i])
+          {
+            if (orderWrapper._instrument != lastInstrument)
+            {
+              lastInstrument = orderWrapper._instrument;
+              tickSize = lastInstrument->getStaticData()->tickSize;
+            }
+            request.price = book.price[side][i] + tickFactor * tickSize;
+          }
+          else
+          {
+            request.price = request.notBestBid ? request.basePrice : 0;
+            done = true;
+            continue;
+          }
+
+          if (!request.useBasePrice)
+          {
+            done = true;
+            continue;
+          }
+          if ((mode * request.basePrice) > (mode * request.price))
+          {
+            done = true;
+            continue;
+          }
+          request.price = 0;
+
+          if (!request.bidInTop5)
+          {
+            if (request.notBestBid)
+              request.price = request.basePrice;
+            done = true;
+          }
+        }
+
+        if (!done && request.notBestBid)
+          request.price = request.basePrice;
+      }
+    }
+
     bool isCurrencyExchange(API2::DATA_TYPES::ExchangeId exchangeId)
     {
       switch (exchangeId)
@@ -81,6 +81,76 @@ namespace API2
                       bool notBestBid = false);
     bool isCurrencyExchange(API2::DATA_TYPES::ExchangeId exchangeId);
 
+    /**
+     * @brief Top levels of one symbol read once (from MktData or a book snapshot), shared by all wrappers priced in a batch.
+     *        Indexed by order mode (CMD_OrderMode_BUY / CMD_OrderMode_SELL) and level.
+     */
+    struct BestPriceBook
+    {
+      static const int DEPTH = 5;
+      SIGNED_LONG price[2][DEPTH];
+      SIGNED_LONG qty[2][DEPTH];
+    };
+
+    /**
+     * @brief One wrapper priced by getBestPrices, arguments have the same meaning as in getBestPrice.
+     *        price and pickedOpportunity are in/out exactly like the reference arguments of getBestPrice.
+     */
+    struct BestPriceRequest
+    {
+      OrderWrapper *orderWrapper;
+      DATA_TYPES::OrderMode side;
+      int tickFactor;
+      bool pickOpportunityEnabled;
+      SIGNED_LONG opportunityPrice;
+      bool useBasePrice;
+      SIGNED_LONG basePrice;
+      bool bidInTop5;
+      bool notBestBid;
+
+      SIGNED_LONG price;
+      bool pickedOpportunity;
+
+      BestPriceRequest() : orderWrapper(NULL),
+                           side(CONSTANTS::CMD_OrderMode_BUY),
+                           tickFactor(0),
+                           pickOpportunityEnabled(false),
+                           opportunityPrice(0),
+                           useBasePrice(false),
+                           basePrice(0),
+                           bidInTop5(false),
+                           notBestBid(false),
+                           price(0),
+                           pickedOpportunity(false)
+      {
+      }
+    };
+
+    /**
+     *@brief  batched getBestPrice : reads market data of symbolId once and computes target price of every request in one pass,
+     *@brief  results are identical to calling getBestPrice for each request. All wrappers must belong to symbolId.
+     *@Params symbolId
+     *@Params requests
+     *@Params count
+     *@Params context
+     *@Return false if market data is not available (strategy is terminated as in getBestPrice)
+     **/
+    bool getBestPrices(SIGNED_LONG symbolId,
+                       BestPriceRequest *requests,
+                       size_t count,
+                       SGContext *context);
+
+    /**
+     *@brief  getBestPrices against levels the caller already holds (e.g. the book snapshot a quote is computed from),
+     *@brief  so every request sees the same update. All wrappers must belong to the symbol of book.
+     *@Params book
+     *@Params requests
+     *@Params count
+     **/
+    void getBestPrices(const BestPriceBook &book,
+                       BestPriceRequest *requests,
+                       size_t count);
+
     /*
      * to check if profitInTicks need to be hopped due to hopTradedLots exceeding hopLots,
      * if the hopTradedLots are more than hopLots, we check for number of hops, and increase the profitInTicks by that much
@@ -0,0 +1,148 @@
+#ifndef API2_CONFLATING_LOG_H
+#define API2_CONFLATING_LOG_H
+
+/**
+ * Deferred logging of the latest state only.
+ * Strategy thread fills a POD record in place and publishes it, a worker thread formats the latest published record.
+ * Three preallocated records are rotated (triple buffer), so neither side ever waits or copies a record twice.
+ * When the worker falls behind, a record published before the previous one was formatted replaces it and is counted as merged,
+ * the strategy can also check hasUnread and skip capturing until the worker caught up.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include "threadPlacement.h"
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    template <typename Record>
+    class ConflatingLog
+    {
+      static_assert(std::is_trivially_copyable<Record>::value, "ConflatingLog records must be trivially copyable");
+
+      static const uint8_t INDEX_MASK = 3;
+      static const uint8_t UNREAD = 4;
+
+      Record _records[3];
+      uint8_t _writeIndex;                 // producer only
+      uint64_t _mergedCount;               // producer only
+      alignas(64) std::atomic<uint8_t> _middle; // record between producer and worker, UNREAD until the worker takes it
+      alignas(64) uint8_t _readIndex;      // worker only
+
+      std::function<void(const Record &)> _formatter;
+      ThreadPlacement _placement;
+      std::string _placementError;
+      std::atomic<bool> _isRunning;
+      std::thread _worker;
+
+      void run()
+      {
+        while (_isRunning.load(std::memory_order_relaxed))
+        {
+          if (drain() == 0)
+            _placement.idle();
+        }
+      }
+
+      ConflatingLog(const ConflatingLog &) = delete;
+      ConflatingLog &operator=(const ConflatingLog &) = delete;
+
+    public:
+      ConflatingLog() : _records(), _writeIndex(0), _mergedCount(0), _middle(1), _readIndex(2), _isRunning(false) {}
+
+      /**
+       * @brief stops the worker, a record still unread is formatted
+       */
+      ~ConflatingLog() { stop(); }
+
+      /**
+       * @brief start the worker thread
+       * @param formatter - callable as formatter(const Record &), runs on the worker thread only
+       * @param placement - cpu affinity, priority and idle policy of the worker
+       * @return false if already running. Worker still runs if placement fails, see getPlacementError
+       */
+      template <typename Formatter>
+      bool start(Formatter formatter, const ThreadPlacement &placement)
+      {
+        if (_isRunning.load())
+          return false;
+        _formatter = formatter;
+        _placement = placement;
+        _isRunning.store(true);
+        _worker = std::thread(&ConflatingLog::run, this);
+        _placementError.clear();
+        _placement.apply(_worker.native_handle(), _placementError);
+        return true;
+      }
+
+      /**
+       * @brief stop the worker and format an unread record on the calling thread
+       */
+      void stop()
+      {
+        _isRunning.store(false);
+        if (_worker.joinable())
+          _worker.join();
+        if (_formatter)
+          drain();
+      }
+
+      bool isRunning() const { return _isRunning.load(std::memory_order_relaxed); }
+
+      const std::string &getPlacementError() const { return _placementError; }
+
+      /**
+       * @brief producer side, record to fill, same record until publish
+       */
+      Record &claim() { return _records[_writeIndex]; }
+
+      /**
+       * @brief producer side, hand the claimed record to the worker
+       * @return false if it replaced a record the worker had not formatted yet
+       */
+      bool publish()
+      {
+        uint8_t previous = _middle.exchange(_writeIndex | UNREAD, std::memory_order_acq_rel);
+        _writeIndex = previous & INDEX_MASK;
+        if (previous & UNREAD)
+        {
+          ++_mergedCount;
+          return false;
+        }
+        return true;
+      }
+
+      /**
+       * @brief a published record is not formatted yet
+       */
+      bool hasUnread() const { return (_middle.load(std::memory_order_acquire) & UNREAD) != 0; }
+
+      /**
+       * @brief consumer side, format the latest record if it is unread
+       * @return number of records formatted, 0 or 1
+       */
+      size_t drain()
+      {
+        if ((_middle.load(std::memory_order_acquire) & UNREAD) == 0)
+          return 0;
+        uint8_t previous = _middle.exchange(_readIndex, std::memory_order_acq_rel);
+        _readIndex = previous & INDEX_MASK;
+        _formatter(_records[_readIndex]);
+        return 1;
+      }
+
+      uint64_t getMergedCount() const { return _mergedCount; }
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef API2_DEFERRED_LOG_H
+#define API2_DEFERRED_LOG_H
+
+/**
+ * Deferred logging of POD records.
+ * Strategy thread claims a slot of a fixed single producer / single consumer ring, fills the record in place and publishes it,
+ * a worker thread drains the ring and hands every record to a formatter, so formatting and I/O never run on the strategy thread.
+ * When the ring is full the record is dropped and counted, the strategy thread never waits for the worker.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include "threadPlacement.h"
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    template <typename Record>
+    class DeferredLog
+    {
+      static_assert(std::is_trivially_copyable<Record>::value, "DeferredLog records must be trivially copyable");
+
+      std::vector<Record> _records;
+      uint64_t _mask;
+      alignas(64) std::atomic<uint64_t> _head; // written by producer
+      alignas(64) std::atomic<uint64_t> _tail; // written by consumer
+      alignas(64) uint64_t _overflowCount;     // producer only
+
+      std::function<void(const Record &)> _formatter;
+      ThreadPlacement _placement;
+      std::string _placementError;
+      std::atomic<bool> _isRunning;
+      std::thread _worker;
+
+      void run()
+      {
+        while (_isRunning.load(std::memory_order_relaxed))
+        {
+          if (drain() == 0)
+            _placement.idle();
+        }
+      }
+
+      DeferredLog(const DeferredLog &) = delete;
+      DeferredLog &operator=(const DeferredLog &) = delete;
+
+    public:
+      /**
+       * @brief DeferredLog
+       * @param capacity - rounded up to a power of two, allocated here once
+       */
+      explicit DeferredLog(size_t capacity) : _mask(0), _head(0), _tail(0), _overflowCount(0), _isRunning(false)
+      {
+        size_t size = 1;
+        while (size < capacity)
+          size <<= 1;
+        _records.resize(size);
+        _mask = size - 1;
+      }
+
+      /**
+       * @brief stops the worker, queued records are still formatted
+       */
+      ~DeferredLog() { stop(); }
+
+      /**
+       * @brief start the worker thread
+       * @param formatter - callable as formatter(const Record &), runs on the worker thread only
+       * @param placement - cpu affinity, priority and idle policy of the worker
+       * @return false if already running. Worker still runs if placement fails, see getPlacementError
+       */
+      template <typename Formatter>
+      bool start(Formatter formatter, const ThreadPlacement &placement)
+      {
+        if (_isRunning.load())
+          return false;
+        _formatter = formatter;
+        _placement = placement;
+        _isRunning.store(true);
+        _worker = std::thread(&DeferredLog::run, this);
+        _placementError.clear();
+        _placement.apply(_worker.native_handle(), _placementError);
+        return true;
+      }
+
+      /**
+       * @brief stop the worker and format what is left on the calling thread
+       */
+      void stop()
+      {
+        _isRunning.store(false);
+        if (_worker.joinable())
+          _worker.join();
+        if (_formatter)
+          drain();
+      }
+
+      bool isRunning() const { return _isRunning.load(std::memory_order_relaxed); }
+
+      const std::string &getPlacementError() const { return _placementError; }
+
+      /**
+       * @brief producer side, slot of the next record, fill it then publish
+       * @return NULL if ring is full, record is dropped
+       */
+      Record *claim()
+      {
+        uint64_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) > _mask)
+        {
+          ++_overflowCount;
+          return NULL;
+        }
+        return &_records[head & _mask];
+      }
+
+      /**
+       * @brief producer side, hand the claimed record to the worker
+       */
+      void publish()
+      {
+        _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+      }
+
+      /**
+       * @brief consumer side, format all queued records
+       * @return number of records formatted
+       */
+      size_t drain()
+      {
+        uint64_t tail = _tail.load(std::memory_order_relaxed);
+        uint64_t head = _head.load(std::memory_order_acquire);
+        for (uint64_t i = tail; i != head; ++i)
+          _formatter(_records[i & _mask]);
+        _tail.store(head, std::memory_order_release);
+        return (size_t)(head - tail);
+      }
+
+      size_t size() const { return (size_t)(_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire)); }
+      size_t capacity() const { return _records.size(); }
+      uint64_t getOverflowCount() const { return _overflowCount; }
+    };
+  }
+}
+
+#endif
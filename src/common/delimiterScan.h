@@ -0,0 +1,146 @@
+#ifndef API2_DELIMITER_SCAN_H
+#define API2_DELIMITER_SCAN_H
+
+/**
+ * Vectorized search of delimiter bytes in a text buffer, for parsers of large log files.
+ * A block of 64 bytes is compared against all delimiters at once into a mask with a bit per delimiter byte, AVX2 when the build
+ * targets it (-march), SSE2 otherwise on x86, byte by byte elsewhere. The scanner keeps the mask of its current block and hands out
+ * delimiters in order by clearing its lowest bit, so a block is compared once however many delimiters it holds.
+ * Nothing is read outside [begin, end), the last partial block is compared byte by byte.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace API2
+{
+  namespace COMMON
+  {
+    class DelimiterScanner
+    {
+    public:
+      static const int MAX_DELIMITERS = 4;
+      static const size_t BLOCK_SIZE = 64;
+
+    private:
+      char _delimiters[MAX_DELIMITERS];
+      int _count;
+      const char *_block; // block of _mask
+      const char *_end;
+      uint64_t _mask; // delimiters of the block not handed out yet
+
+      uint64_t scalarMask(const char *block, size_t length) const
+      {
+        uint64_t mask = 0;
+        for (size_t i = 0; i < length; ++i)
+          for (int d = 0; d < _count; ++d)
+            if (block[i] == _delimiters[d])
+            {
+              mask |= (uint64_t)1 << i;
+              break;
+            }
+        return mask;
+      }
+
+      uint64_t blockMask(const char *block) const
+      {
+#if defined(__AVX2__)
+        __m256i low = _mm256_loadu_si256((const __m256i *)block);
+        __m256i high = _mm256_loadu_si256((const __m256i *)(block + 32));
+        __m256i lowMatch = _mm256_setzero_si256();
+        __m256i highMatch = _mm256_setzero_si256();
+        for (int d = 0; d < _count; ++d)
+        {
+          __m256i delimiter = _mm256_set1_epi8(_delimiters[d]);
+          lowMatch = _mm256_or_si256(lowMatch, _mm256_cmpeq_epi8(low, delimiter));
+          highMatch = _mm256_or_si256(highMatch, _mm256_cmpeq_epi8(high, delimiter));
+        }
+        return (uint64_t)(uint32_t)_mm256_movemask_epi8(lowMatch) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(highMatch) << 32);
+#elif defined(__SSE2__)
+        uint64_t mask = 0;
+        for (int part = 0; part < 4; ++part)
+        {
+          __m128i bytes = _mm_loadu_si128((const __m128i *)(block + 16 * part));
+          __m128i match = _mm_setzero_si128();
+          for (int d = 0; d < _count; ++d)
+            match = _mm_or_si128(match, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(_delimiters[d])));
+          mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(match) << (16 * part);
+        }
+        return mask;
+#else
+        return scalarMask(block, BLOCK_SIZE);
+#endif
+      }
+
+      void load(const char *block)
+      {
+        _block = block;
+        size_t length = block < _end ? (size_t)(_end - block) : 0;
+        _mask = length >= BLOCK_SIZE ? blockMask(block) : scalarMask(block, length);
+      }
+
+    public:
+      /**
+       * @brief DelimiterScanner
+       * @param delimiters - 1 to MAX_DELIMITERS bytes, nul terminated, extra bytes are ignored
+       */
+      explicit DelimiterScanner(const char *delimiters) : _count(0), _block(NULL), _end(NULL), _mask(0)
+      {
+        while (_count < MAX_DELIMITERS && delimiters[_count] != 0)
+        {
+          _delimiters[_count] = delimiters[_count];
+          ++_count;
+        }
+      }
+
+      /**
+       * @brief scan a new buffer from its start
+       */
+      void reset(const char *begin, const char *end)
+      {
+        _end = end;
+        load(begin);
+      }
+
+      /**
+       * @brief next delimiter after the last one handed out
+       * @return end of the buffer if none is left
+       */
+      const char *next()
+      {
+        while (_mask == 0)
+        {
+          if (_block + BLOCK_SIZE >= _end)
+            return _end;
+          load(_block + BLOCK_SIZE);
+        }
+        const char *delimiter = _block + __builtin_ctzll(_mask);
+        _mask &= _mask - 1;
+        return delimiter;
+      }
+
+      /**
+       * @brief continue at position, delimiters before it are skipped
+       */
+      void seek(const char *position)
+      {
+        if (position >= _block && position < _block + BLOCK_SIZE)
+          _mask &= ~(uint64_t)0 << (position - _block);
+        else
+          load(position < _end ? position : _end);
+      }
+
+      const char *getEnd() const { return _end; }
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,363 @@
+#ifndef API2_FIXED_LAYOUT_H
+#define API2_FIXED_LAYOUT_H
+
+/**
+ * Typed fixed layout encoding of strategy structs, shared by checkpoints, journals and messages between strategies.
+ * A struct is described once by specializing FixedLayout with a type id, a schema version and its fields in wire order:
+ *
+ *   template <> struct FixedLayout<wsc::NetPositionDetails>
+ *   {
+ *     static const uint32_t TYPE_ID = 3;
+ *     static const uint32_t VERSION = 1;
+ *     typedef FixedFields<API2_FIXED_FIELD(wsc::NetPositionDetails, contractId), ...> Fields;
+ *   };
+ *
+ * Size and offset of every field are compile time constants, encode / decode are copies at fixed offsets, nothing is
+ * allocated except std::string members on decode. Unlike API2::Serialization::serialize every call is checked against
+ * the buffer size, and an encoded buffer starts with a header (type id, version, payload size) that decode and view
+ * check before reading, so a buffer of another struct or another version of the same struct is refused.
+ * Numbers are stored little endian without padding, std::string members take a length and a fixed capacity.
+ * FixedView reads single fields of an encoded buffer in place, decode copies all of them.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "fixedLayout.h encodes in host byte order, which must be little endian"
+#endif
+
+namespace API2
+{
+  namespace COMMON
+  {
+    /**
+     * @brief description of T, specialize with TYPE_ID, VERSION and Fields
+     */
+    template <typename T>
+    struct FixedLayout;
+
+    template <typename T>
+    class FixedView;
+
+    template <typename T, size_t N>
+    class FixedArrayView;
+
+    /**
+     * @brief string field of an encoded buffer, not nul terminated
+     */
+    struct FixedStringRef
+    {
+      const char *data;
+      size_t size;
+
+      std::string str() const { return std::string(data, size); }
+    };
+
+    /**
+     * @brief encoding of a value, scalars as is, arrays element by element, other structs by their FixedLayout
+     */
+    template <typename T, bool IS_SCALAR = std::is_arithmetic<T>::value || std::is_enum<T>::value>
+    struct FixedWire
+    {
+      static const size_t SIZE = sizeof(T);
+      static const bool IS_RAW = true; // wire bytes are the memory bytes
+      typedef T View;
+
+      static bool encode(char *data, const T &value)
+      {
+        memcpy(data, &value, SIZE);
+        return true;
+      }
+      static void decode(const char *data, T &value) { memcpy(&value, data, SIZE); }
+      static View view(const char *data)
+      {
+        T value;
+        memcpy(&value, data, SIZE);
+        return value;
+      }
+    };
+
+    // one byte, any value but 0 reads as true
+    template <>
+    struct FixedWire<bool, true>
+    {
+      static const size_t SIZE = 1;
+      static const bool IS_RAW = false;
+      typedef bool View;
+
+      static bool encode(char *data, bool value)
+      {
+        *data = value ? 1 : 0;
+        return true;
+      }
+      static void decode(const char *data, bool &value) { value = *data != 0; }
+      static View view(const char *data) { return *data != 0; }
+    };
+
+    template <typename T, size_t N>
+    struct FixedWire<T[N], false>
+    {
+      typedef FixedWire<T> Element;
+      static const size_t SIZE = N * Element::SIZE;
+      static const bool IS_RAW = Element::IS_RAW;
+      typedef FixedArrayView<T, N> View;
+
+      static bool encode(char *data, const T (&value)[N])
+      {
+        if (IS_RAW)
+        {
+          memcpy(data, value, SIZE);
+          return true;
+        }
+        bool isEncoded = true;
+        for (size_t i = 0; i < N; ++i)
+          isEncoded &= Element::encode(data + i * Element::SIZE, value[i]);
+        return isEncoded;
+      }
+      static void decode(const char *data, T (&value)[N])
+      {
+        if (IS_RAW)
+          memcpy(value, data, SIZE);
+        else
+          for (size_t i = 0; i < N; ++i)
+            Element::decode(data + i * Element::SIZE, value[i]);
+      }
+      static View view(const char *data) { return View(data); }
+    };
+
+    template <typename T>
+    struct FixedWire<T, false>
+    {
+      typedef typename FixedLayout<T>::Fields Fields;
+      static const size_t SIZE = Fields::SIZE;
+      static const bool IS_RAW = false;
+      typedef FixedView<T> View;
+
+      static bool encode(char *data, const T &value) { return Fields::encode(data, value); }
+      static void decode(const char *data, T &value) { Fields::decode(data, value); }
+      static View view(const char *data) { return View(data); }
+    };
+
+    /**
+     * @brief member of C, see API2_FIXED_FIELD
+     */
+    template <typename C, typename V, V C::*MEMBER>
+    struct FixedField
+    {
+      typedef C Class;
+      typedef FixedWire<V> Wire;
+      typedef typename Wire::View View;
+      static const size_t SIZE = Wire::SIZE;
+
+      static bool encode(char *data, const C &value) { return Wire::encode(data, value.*MEMBER); }
+      static void decode(const char *data, C &value) { Wire::decode(data, value.*MEMBER); }
+      static View view(const char *data) { return Wire::view(data); }
+    };
+
+    /**
+     * @brief std::string member of C stored as uint16_t length and CAPACITY bytes, encode fails if it is longer
+     */
+    template <typename C, std::string C::*MEMBER, size_t CAPACITY>
+    struct FixedStringField
+    {
+      static_assert(CAPACITY <= UINT16_MAX, "string capacity must fit uint16_t length");
+      typedef C Class;
+      typedef FixedStringRef View;
+      static const size_t SIZE = sizeof(uint16_t) + CAPACITY;
+
+      static bool encode(char *data, const C &value)
+      {
+        const std::string &text = value.*MEMBER;
+        uint16_t length = text.size() <= CAPACITY ? (uint16_t)text.size() : 0;
+        memcpy(data, &length, sizeof(length));
+        memcpy(data + sizeof(length), text.data(), length);
+        memset(data + sizeof(length) + length, 0, CAPACITY - length);
+        return text.size() <= CAPACITY;
+      }
+      static void decode(const char *data, C &value)
+      {
+        View text = view(data);
+        (value.*MEMBER).assign(text.data, text.size);
+      }
+      static View view(const char *data)
+      {
+        uint16_t length;
+        memcpy(&length, data, sizeof(length));
+        View text = {data + sizeof(length), length <= CAPACITY ? length : CAPACITY};
+        return text;
+      }
+    };
+
+#define API2_FIXED_FIELD(Class, member) API2::COMMON::FixedField<Class, decltype(Class::member), &Class::member>
+#define API2_FIXED_STRING_FIELD(Class, member, capacity) API2::COMMON::FixedStringField<Class, &Class::member, capacity>
+
+    /**
+     * @brief fields of a layout in wire order, each one starts where the previous one ends
+     */
+    template <typename... F>
+    struct FixedFields;
+
+    template <>
+    struct FixedFields<>
+    {
+      static const size_t SIZE = 0;
+
+      template <typename C>
+      static bool encode(char *, const C &) { return true; }
+      template <typename C>
+      static void decode(const char *, C &) {}
+    };
+
+    template <typename F, typename... R>
+    struct FixedFields<F, R...>
+    {
+      typedef FixedFields<R...> Rest;
+      static const size_t SIZE = F::SIZE + Rest::SIZE;
+
+      template <typename C>
+      static bool encode(char *data, const C &value)
+      {
+        bool isEncoded = F::encode(data, value);
+        return Rest::encode(data + F::SIZE, value) && isEncoded;
+      }
+      template <typename C>
+      static void decode(const char *data, C &value)
+      {
+        F::decode(data, value);
+        Rest::decode(data + F::SIZE, value);
+      }
+    };
+
+    /**
+     * @brief offset of field F in Fields, does not compile if F is not one of them
+     */
+    template <typename Fields, typename F>
+    struct FixedFieldOffset;
+
+    template <typename F, typename... R>
+    struct FixedFieldOffset<FixedFields<F, R...>, F>
+    {
+      static const size_t VALUE = 0;
+    };
+
+    template <typename G, typename... R, typename F>
+    struct FixedFieldOffset<FixedFields<G, R...>, F>
+    {
+      static const size_t VALUE = G::SIZE + FixedFieldOffset<FixedFields<R...>, F>::VALUE;
+    };
+
+    /**
+     * @brief encoded T read in place, the buffer must outlive the view
+     */
+    template <typename T>
+    class FixedView
+    {
+      const char *_data;
+
+    public:
+      typedef typename FixedLayout<T>::Fields Fields;
+
+      explicit FixedView(const char *data = NULL) : _data(data) {}
+
+      /**
+       * @brief field of the layout, e.g. view.get<API2_FIXED_FIELD(wsc::BookSnapshot, timestamp)>()
+       * @return value of a scalar, FixedView of a struct, FixedArrayView of an array, FixedStringRef of a string
+       */
+      template <typename F>
+      typename F::View get() const
+      {
+        static_assert(std::is_same<typename F::Class, T>::value, "field of another struct");
+        return F::view(_data + FixedFieldOffset<Fields, F>::VALUE);
+      }
+
+      /**
+       * @brief copy of all fields
+       */
+      void decode(T &value) const { Fields::decode(_data, value); }
+
+      const char *data() const { return _data; }
+    };
+
+    template <typename T, size_t N>
+    class FixedArrayView
+    {
+      typedef FixedWire<T> Element;
+      const char *_data;
+
+    public:
+      explicit FixedArrayView(const char *data) : _data(data) {}
+
+      size_t size() const { return N; }
+      typename Element::View operator[](size_t i) const { return Element::view(_data + i * Element::SIZE); }
+    };
+
+    /**
+     * @brief encode / decode of T with header, T needs a FixedLayout
+     */
+    template <typename T>
+    class FixedCodec
+    {
+      typedef FixedLayout<T> Layout;
+      typedef typename Layout::Fields Fields;
+
+      static bool isHeaderValid(const char *buffer, size_t size)
+      {
+        if (buffer == NULL || size < ENCODED_SIZE)
+          return false;
+        uint32_t header[3];
+        memcpy(header, buffer, HEADER_SIZE);
+        return header[0] == Layout::TYPE_ID && header[1] == Layout::VERSION && header[2] == PAYLOAD_SIZE;
+      }
+
+    public:
+      static const size_t HEADER_SIZE = 3 * sizeof(uint32_t);
+      static const size_t PAYLOAD_SIZE = Fields::SIZE;
+      static const size_t ENCODED_SIZE = HEADER_SIZE + PAYLOAD_SIZE;
+
+      /**
+       * @brief write header and fields of value
+       * @return bytes written (ENCODED_SIZE), 0 if capacity is less or a string field is longer than its capacity
+       */
+      static size_t encode(const T &value, char *buffer, size_t capacity)
+      {
+        if (buffer == NULL || capacity < ENCODED_SIZE)
+          return 0;
+        uint32_t header[3] = {Layout::TYPE_ID, Layout::VERSION, (uint32_t)PAYLOAD_SIZE};
+        memcpy(buffer, header, HEADER_SIZE);
+        return Fields::encode(buffer + HEADER_SIZE, value) ? ENCODED_SIZE : 0;
+      }
+
+      /**
+       * @brief read all fields
+       * @return false if size is less than ENCODED_SIZE or the header is not of this type and version, value is untouched then
+       */
+      static bool decode(const char *buffer, size_t size, T &value)
+      {
+        if (!isHeaderValid(buffer, size))
+          return false;
+        Fields::decode(buffer + HEADER_SIZE, value);
+        return true;
+      }
+
+      /**
+       * @brief view of the fields in buffer, same checks as decode
+       */
+      static bool view(const char *buffer, size_t size, FixedView<T> &view)
+      {
+        if (!isHeaderValid(buffer, size))
+          return false;
+        view = FixedView<T>(buffer + HEADER_SIZE);
+        return true;
+      }
+    };
+  }
+}
+
+#endif
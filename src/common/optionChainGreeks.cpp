@@ -0,0 +1,361 @@
+/**
+ * Batch Black-Scholes engine for a whole option chain of one underlying.
+ *
+ * Options are processed LANES at a time with GCC vector extensions, exp and the normal CDF are
+ * evaluated branch free on the whole vector (no libm call per option). A vector is one register of the
+ * target architecture of the build, SSE2 by default, AVX with TEMPLATE_MARCH, so no helper passes it in memory.
+ * compute takes the greeks from the last evaluation of the IV solve, a warm started chain evaluates once per block.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include "optionChainGreeks.h"
+#include <math.h>
+#include <string.h>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    namespace
+    {
+      typedef double VecD __attribute__((vector_size(OptionChainGreeks::LANES * sizeof(double))));
+      typedef long long VecL __attribute__((vector_size(OptionChainGreeks::LANES * sizeof(long long))));
+
+      const double MIN_IV = 1e-4;
+      const double MAX_IV = 5.0;
+      const double SQRT_2PI = 2.50662827463100050242;
+
+      inline VecD splat(double x)
+      {
+        VecD v;
+        for (size_t i = 0; i < OptionChainGreeks::LANES; ++i)
+          v[i] = x;
+        return v;
+      }
+
+      inline VecD load(const double *p)
+      {
+        VecD v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+      }
+
+      inline void store(double *p, const VecD &v)
+      {
+        memcpy(p, &v, sizeof(v));
+      }
+
+      inline VecD vmin(const VecD &a, const VecD &b) { return a < b ? a : b; }
+      inline VecD vmax(const VecD &a, const VecD &b) { return a > b ? a : b; }
+      inline VecD vabs(const VecD &a) { return a < splat(0) ? -a : a; }
+
+      inline bool allTrue(const VecL &mask)
+      {
+        for (size_t i = 0; i < OptionChainGreeks::LANES; ++i)
+          if (!mask[i])
+            return false;
+        return true;
+      }
+
+      inline bool anyTrue(const VecL &mask)
+      {
+        for (size_t i = 0; i < OptionChainGreeks::LANES; ++i)
+          if (mask[i])
+            return true;
+        return false;
+      }
+
+      inline VecD vsqrt(const VecD &x)
+      {
+        VecD r;
+        for (size_t i = 0; i < OptionChainGreeks::LANES; ++i)
+          r[i] = sqrt(x[i]);
+        return r;
+      }
+
+      /**
+       * exp with range reduction to |r| <= ln2/2 and a degree 11 Taylor polynomial, relative error ~1e-15
+       */
+      inline VecD vexp(VecD x)
+      {
+        const VecD magic = splat(6755399441055744.0); // 1.5 * 2^52, rounds to nearest integer
+        x = vmin(vmax(x, splat(-708.0)), splat(709.0));
+        VecD n = (x * splat(1.44269504088896340736) + magic) - magic;
+        VecD r = x - n * splat(6.93147180369123816490e-01) - n * splat(1.90821492927058770002e-10);
+
+        VecD p = splat(1.0 / 39916800.0);
+        p = p * r + splat(1.0 / 3628800.0);
+        p = p * r + splat(1.0 / 362880.0);
+        p = p * r + splat(1.0 / 40320.0);
+        p = p * r + splat(1.0 / 5040.0);
+        p = p * r + splat(1.0 / 720.0);
+        p = p * r + splat(1.0 / 120.0);
+        p = p * r + splat(1.0 / 24.0);
+        p = p * r + splat(1.0 / 6.0);
+        p = p * r + splat(0.5);
+        p = p * r + splat(1.0);
+        p = p * r + splat(1.0);
+
+        VecL bits = (__builtin_convertvector(n, VecL) + 1023) << 52;
+        return p * (VecD)bits;
+      }
+
+      /**
+       * cumulative normal distribution, Hart's double precision approximation (West, 2005)
+       */
+      inline VecD vncdf(const VecD &x)
+      {
+        VecD ax = vabs(x);
+        VecD e = vexp(splat(-0.5) * ax * ax);
+
+        VecD num = splat(3.52624965998911E-02) * ax + splat(0.700383064443688);
+        num = num * ax + splat(6.37396220353165);
+        num = num * ax + splat(33.912866078383);
+        num = num * ax + splat(112.079291497871);
+        num = num * ax + splat(221.213596169931);
+        num = num * ax + splat(220.206867912376);
+        VecD den = splat(8.83883476483184E-02) * ax + splat(1.75566716318264);
+        den = den * ax + splat(16.064177579207);
+        den = den * ax + splat(86.7807322029461);
+        den = den * ax + splat(296.564248779674);
+        den = den * ax + splat(637.333633378831);
+        den = den * ax + splat(793.826512519948);
+        den = den * ax + splat(440.413735824752);
+        VecD c = e * num / den;
+
+        // continued fraction of the tail only when a lane is in it, rare for quoted options
+        if (anyTrue(ax >= splat(7.07106781186547)))
+        {
+          VecD b = ax + splat(0.65);
+          b = ax + splat(4.0) / b;
+          b = ax + splat(3.0) / b;
+          b = ax + splat(2.0) / b;
+          b = ax + splat(1.0) / b;
+          VecD large = e / b / splat(SQRT_2PI);
+          c = ax < splat(7.07106781186547) ? c : large;
+          c = ax > splat(37.0) ? splat(0) : c;
+        }
+        return x > splat(0) ? splat(1.0) - c : c;
+      }
+
+      /**
+       * @brief normal terms of a block at one sigma, shared by the price, vega and all greeks
+       */
+      struct Evaluation
+      {
+        VecD d1;
+        VecD d2;
+        VecD nd1; // N(sign * d1)
+        VecD nd2; // N(sign * d2)
+        VecD pdf; // n(d1)
+      };
+
+      /**
+       * @brief per block values independent of IV
+       */
+      struct Block
+      {
+        VecD spot;
+        VecD strike;
+        VecD timeToExpire;
+        VecD sqrtT;
+        VecD sign; // +1 call, -1 put
+        VecD dividendDisc; // exp(-qT)
+        VecD spotDisc;     // S * exp(-qT)
+        VecD strikeDisc;   // K * exp(-rT)
+        VecD logMoneyness;
+        VecD drift; // (r - q) * T
+        VecD rate;
+        VecD dividend;
+        VecL isValid;
+
+        Block(double s, double logSpot, double r, double q, const double *k, const double *logK, const double *t, const double *isCall)
+        {
+          spot = splat(s);
+          strike = load(k);
+          timeToExpire = vmax(load(t), splat(0));
+          sqrtT = vsqrt(timeToExpire);
+          sign = load(isCall) * splat(2.0) - splat(1.0);
+          rate = splat(r);
+          dividend = splat(q);
+          dividendDisc = vexp(-dividend * timeToExpire);
+          spotDisc = spot * dividendDisc;
+          strikeDisc = strike * vexp(-rate * timeToExpire);
+          logMoneyness = splat(logSpot) - load(logK);
+          drift = (rate - dividend) * timeToExpire;
+          isValid = (timeToExpire > splat(0)) & (strike > splat(0)) & (spot > splat(0));
+        }
+
+        void d1d2(const VecD &sigma, VecD &d1, VecD &d2) const
+        {
+          VecD sst = sigma * sqrtT;
+          d1 = (logMoneyness + drift + splat(0.5) * sigma * sigma * timeToExpire) / sst;
+          d2 = d1 - sst;
+        }
+
+        void evaluate(const VecD &sigma, Evaluation &eval) const
+        {
+          d1d2(sigma, eval.d1, eval.d2);
+          eval.nd1 = vncdf(sign * eval.d1);
+          eval.nd2 = vncdf(sign * eval.d2);
+          eval.pdf = vexp(splat(-0.5) * eval.d1 * eval.d1) / splat(SQRT_2PI);
+        }
+
+        VecD price(const Evaluation &eval) const { return sign * (spotDisc * eval.nd1 - strikeDisc * eval.nd2); }
+        VecD vega(const Evaluation &eval) const { return spotDisc * eval.pdf * sqrtT; }
+      };
+
+      /**
+       * @brief greeks of a block from an evaluation at sigma, 0 in lanes without IV
+       */
+      inline void storeGreeks(const Block &block, const VecD &sigma, const VecL &hasIv, const Evaluation &eval,
+                              double *delta, double *gamma, double *theta, double *vega, double *rho)
+      {
+        VecD d = block.sign * block.dividendDisc * eval.nd1;
+        VecD g = block.spotDisc * eval.pdf / (block.spot * block.spot * sigma * block.sqrtT);
+        VecD v = block.vega(eval);
+        VecD t = -block.spotDisc * eval.pdf * sigma / (splat(2.0) * block.sqrtT) -
+                 block.sign * block.rate * block.strikeDisc * eval.nd2 +
+                 block.sign * block.dividend * block.spotDisc * eval.nd1;
+        VecD r = block.sign * block.strikeDisc * block.timeToExpire * eval.nd2;
+
+        store(delta, hasIv ? d : splat(0));
+        store(gamma, hasIv ? g : splat(0));
+        store(vega, hasIv ? v : splat(0));
+        store(theta, hasIv ? t : splat(0));
+        store(rho, hasIv ? r : splat(0));
+      }
+    }
+
+    OptionChainGreeks::OptionChainGreeks(size_t capacity, int maxIterations, double tolerance)
+        : _size(0),
+          _maxIterations(maxIterations),
+          _tolerance(tolerance)
+    {
+      size_t padded = (capacity + LANES - 1) / LANES * LANES;
+      _strike.reserve(padded);
+      _logStrike.reserve(padded);
+      _timeToExpire.reserve(padded);
+      _isCall.reserve(padded);
+      _optionPrice.reserve(padded);
+      _iv.reserve(padded);
+      _delta.reserve(padded);
+      _gamma.reserve(padded);
+      _theta.reserve(padded);
+      _vega.reserve(padded);
+      _rho.reserve(padded);
+      _status.reserve(padded);
+    }
+
+    void OptionChainGreeks::resizeForIndex(size_t index)
+    {
+      if (index < _strike.size())
+        return;
+      // padding lanes are valid but unpriced options, their outputs are never read
+      size_t padded = (index + LANES) / LANES * LANES;
+      _strike.resize(padded, 1.0);
+      _logStrike.resize(padded, 0.0);
+      _timeToExpire.resize(padded, 1.0);
+      _isCall.resize(padded, 1.0);
+      _optionPrice.resize(padded, 0.0);
+      _iv.resize(padded, 0.0);
+      _delta.resize(padded, 0.0);
+      _gamma.resize(padded, 0.0);
+      _theta.resize(padded, 0.0);
+      _vega.resize(padded, 0.0);
+      _rho.resize(padded, 0.0);
+      _status.resize(padded, IvStatus_INVALID_INPUT);
+    }
+
+    size_t OptionChainGreeks::addOption(bool isCall, double strike, double timeToExpire, double initialIv)
+    {
+      size_t index = _size++;
+      resizeForIndex(index);
+      _strike[index] = strike;
+      _logStrike[index] = strike > 0 ? log(strike) : 0;
+      _timeToExpire[index] = timeToExpire;
+      _isCall[index] = isCall ? 1.0 : 0.0;
+      _optionPrice[index] = 0;
+      _iv[index] = initialIv;
+      return index;
+    }
+
+    void OptionChainGreeks::compute(double spot, double interestRate, double dividend)
+    {
+      const double logSpot = spot > 0 ? log(spot) : 0;
+      for (size_t i = 0; i < _size; i += LANES)
+      {
+        Block block(spot, logSpot, interestRate, dividend, &_strike[i], &_logStrike[i], &_timeToExpire[i], &_isCall[i]);
+        VecD target = load(&_optionPrice[i]);
+        VecD previousIv = load(&_iv[i]);
+
+        // no-arbitrage bounds of the option price
+        VecD forwardIntrinsic = block.sign * (block.spotDisc - block.strikeDisc);
+        VecD upperBound = block.sign > splat(0) ? block.spotDisc : block.strikeDisc;
+        VecL isValid = block.isValid & (target > vmax(forwardIntrinsic, splat(0))) & (target < upperBound);
+
+        // warm start from previous IV, else Brenner-Subrahmanyam ATM approximation on the time value
+        VecD timeValue = target - vmax(forwardIntrinsic, splat(0));
+        VecD guess = vsqrt(splat(2.0 * M_PI) / vmax(block.timeToExpire, splat(1e-8))) * timeValue / block.spot;
+        guess = vmin(vmax(guess, splat(0.01)), splat(2.0));
+        VecD sigma = (previousIv > splat(MIN_IV)) & (previousIv < splat(MAX_IV)) ? previousIv : guess;
+        VecD lo = splat(MIN_IV);
+        VecD hi = splat(MAX_IV);
+        VecL isDone = ~isValid;
+        Evaluation eval;
+        bool isEvaluated = false; // eval is at the final sigma of every lane
+
+        for (int it = 0; it < _maxIterations; ++it)
+        {
+          block.evaluate(sigma, eval);
+          VecD diff = block.price(eval) - target;
+          VecD vega = block.vega(eval);
+          isDone |= vabs(diff) < splat(_tolerance);
+          if (allTrue(isDone))
+          {
+            isEvaluated = true;
+            break;
+          }
+
+          // price is increasing in sigma, keep a bracket and bisect when Newton leaves it
+          hi = diff > splat(0) ? sigma : hi;
+          lo = diff < splat(0) ? sigma : lo;
+          VecD newton = sigma - diff / vmax(vega, splat(1e-300));
+          VecL useBisection = (newton <= lo) | (newton >= hi) | (vega < splat(1e-12));
+          VecD next = useBisection ? splat(0.5) * (lo + hi) : newton;
+          sigma = isDone ? sigma : next;
+        }
+
+        VecD solved = isValid ? sigma : previousIv;
+        store(&_iv[i], solved);
+        for (size_t l = 0; l < LANES; ++l)
+          _status[i + l] = !isValid[l] ? IvStatus_INVALID_INPUT : (isDone[l] ? IvStatus_OK : IvStatus_NOT_CONVERGED);
+
+        // greeks from the last evaluation of the solve when it was at the IV of every lane, a warm started solve stops there
+        VecL hasIv = block.isValid & (solved > splat(0));
+        VecD greekSigma = hasIv ? solved : splat(MIN_IV);
+        if (!isEvaluated || !allTrue((greekSigma == sigma) | ~hasIv))
+          block.evaluate(greekSigma, eval);
+        storeGreeks(block, greekSigma, hasIv, eval, &_delta[i], &_gamma[i], &_theta[i], &_vega[i], &_rho[i]);
+      }
+    }
+
+    void OptionChainGreeks::computeGreeks(double spot, double interestRate, double dividend)
+    {
+      const double logSpot = spot > 0 ? log(spot) : 0;
+      for (size_t i = 0; i < _size; i += LANES)
+      {
+        Block block(spot, logSpot, interestRate, dividend, &_strike[i], &_logStrike[i], &_timeToExpire[i], &_isCall[i]);
+        VecD iv = load(&_iv[i]);
+        VecL hasIv = block.isValid & (iv > splat(0));
+        VecD sigma = hasIv ? iv : splat(MIN_IV);
+
+        Evaluation eval;
+        block.evaluate(sigma, eval);
+        storeGreeks(block, sigma, hasIv, eval, &_delta[i], &_gamma[i], &_theta[i], &_vega[i], &_rho[i]);
+      }
+    }
+  }
+}
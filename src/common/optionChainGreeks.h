@@ -0,0 +1,134 @@
+#ifndef API2_OPTION_CHAIN_GREEKS_H
+#define API2_OPTION_CHAIN_GREEKS_H
+
+/**
+ * Batch Black-Scholes engine for a whole option chain (strikes x expiries) of one underlying.
+ * Unlike IvGreekInterface, which prices one instrument per call and fetches spot internally,
+ * the chain is kept in SoA form and every underlying tick re-solves IV and all greeks for all options
+ * in SIMD lanes. IV solve is a safeguarded Newton warm started from the IV of the previous call.
+ *
+ * Units: spot, strike and option price must share the same unit (e.g. scrip precision),
+ * interest rate, dividend and IV are decimal (25% = 0.25), time to expire is in years.
+ * Output greeks are raw derivatives: theta per year, vega per 1.0 IV, rho per 1.0 interest rate.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    class OptionChainGreeks
+    {
+    public:
+      /**
+       * @brief number of options priced together, chain arrays are padded to a multiple of it.
+       *        One native vector register of doubles: 4 when the build enables AVX (TEMPLATE_MARCH), else 2 (SSE2)
+       */
+#ifdef __AVX__
+      static const size_t LANES = 4;
+#else
+      static const size_t LANES = 2;
+#endif
+
+      /**
+       * @brief IV solve status of an option
+       */
+      enum IvStatus
+      {
+        IvStatus_OK = 0,
+        IvStatus_NOT_CONVERGED,
+        IvStatus_INVALID_INPUT, // missing price, expired, or price outside no-arbitrage bounds
+      };
+
+    private:
+      // inputs
+      std::vector<double> _strike;
+      std::vector<double> _logStrike;
+      std::vector<double> _timeToExpire;
+      std::vector<double> _isCall; // 1.0 call, 0.0 put
+      std::vector<double> _optionPrice;
+
+      // outputs, _iv is also the warm start of next compute
+      std::vector<double> _iv;
+      std::vector<double> _delta;
+      std::vector<double> _gamma;
+      std::vector<double> _theta;
+      std::vector<double> _vega;
+      std::vector<double> _rho;
+      std::vector<uint8_t> _status;
+
+      size_t _size;
+      int _maxIterations;
+      double _tolerance;
+
+      void resizeForIndex(size_t index);
+
+    public:
+      /**
+       * @brief OptionChainGreeks
+       * @param capacity - expected number of options, arrays grow if exceeded
+       * @param maxIterations - max Newton iterations per compute
+       * @param tolerance - absolute price tolerance of the IV solve
+       */
+      explicit OptionChainGreeks(size_t capacity = 0, int maxIterations = 12, double tolerance = 1e-6);
+
+      /**
+       * @brief add an option to the chain
+       * @param isCall
+       * @param strike
+       * @param timeToExpire - in years
+       * @param initialIv - start point of first solve, 0 uses an ATM approximation
+       * @return index of the option in the chain
+       */
+      size_t addOption(bool isCall, double strike, double timeToExpire, double initialIv = 0);
+
+      /**
+       * @brief update time to expire of an option, typically once per timer tick for every option of an expiry
+       */
+      void setTimeToExpire(size_t index, double timeToExpire) { _timeToExpire[index] = timeToExpire; }
+
+      /**
+       * @brief set the market price (e.g. mid) IV is solved for, 0 marks price as unavailable
+       */
+      void setOptionPrice(size_t index, double optionPrice) { _optionPrice[index] = optionPrice; }
+
+      /**
+       * @brief solve IV from option prices and compute all greeks of the chain
+       * @param spot - underlying price
+       * @param interestRate
+       * @param dividend
+       */
+      void compute(double spot, double interestRate, double dividend);
+
+      /**
+       * @brief compute greeks from the current IVs without solving, e.g. after editing IVs from a fitted surface
+       */
+      void computeGreeks(double spot, double interestRate, double dividend);
+
+      /**
+       * @brief set IV of an option, used as warm start / input of computeGreeks
+       */
+      void setIv(size_t index, double iv) { _iv[index] = iv; }
+
+      size_t size() const { return _size; }
+      double getStrike(size_t index) const { return _strike[index]; }
+      double getTimeToExpire(size_t index) const { return _timeToExpire[index]; }
+      bool isCall(size_t index) const { return _isCall[index] != 0; }
+      double getIv(size_t index) const { return _iv[index]; }
+      double getDelta(size_t index) const { return _delta[index]; }
+      double getGamma(size_t index) const { return _gamma[index]; }
+      double getTheta(size_t index) const { return _theta[index]; }
+      double getVega(size_t index) const { return _vega[index]; }
+      double getRho(size_t index) const { return _rho[index]; }
+      IvStatus getStatus(size_t index) const { return (IvStatus)_status[index]; }
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef API2_ORDER_STATE_MACHINE_H
+#define API2_ORDER_STATE_MACHINE_H
+
+/**
+ * Lifecycle of order wrappers as a transition table, state x event -> new state, action.
+ * Order requests and each confirmation callback drive the machine with their own event, what happened to the order is known from
+ * one indexed lookup instead of being worked out again from wrapper flags after the confirmation is applied.
+ * A transition the table does not allow (e.g. fill of an order never sent) is counted and answered with OrderAction_RESYNC,
+ * the caller then takes the state from the wrapper.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <stdint.h>
+#include <vector>
+#include "orderWrapper.h"
+
+namespace API2
+{
+  namespace COMMON
+  {
+    enum OrderState
+    {
+      OrderState_IDLE = 0, // wrapper is reset, no order at exchange
+      OrderState_PENDING_NEW,
+      OrderState_OPEN,
+      OrderState_PENDING_REPLACE,
+      OrderState_PENDING_CANCEL,
+      OrderState_MAX
+    };
+
+    inline const char *OrderStateStr(OrderState v)
+    {
+      switch (v)
+      {
+      case OrderState_IDLE:
+        return "IDLE";
+      case OrderState_PENDING_NEW:
+        return "PENDING_NEW";
+      case OrderState_OPEN:
+        return "OPEN";
+      case OrderState_PENDING_REPLACE:
+        return "PENDING_REPLACE";
+      case OrderState_PENDING_CANCEL:
+        return "PENDING_CANCEL";
+      default:
+        return "[Unknown OrderState]";
+      }
+    }
+
+    /**
+     * @brief request sent by the strategy or confirmation callback received, named after the call producing it
+     */
+    enum OrderEvent
+    {
+      OrderEvent_NEW_REQUEST = 0,
+      OrderEvent_REPLACE_REQUEST,
+      OrderEvent_CANCEL_REQUEST,
+      OrderEvent_CONFIRMED,
+      OrderEvent_NEW_REJECT,
+      OrderEvent_IOC_CANCELED,
+      OrderEvent_FILLED,
+      OrderEvent_PARTIAL_FILL,
+      OrderEvent_CANCELED,
+      OrderEvent_REPLACED,
+      OrderEvent_REPLACE_REJECTED,
+      OrderEvent_CANCEL_REJECTED,
+      OrderEvent_MAX
+    };
+
+    inline const char *OrderEventStr(OrderEvent v)
+    {
+      switch (v)
+      {
+      case OrderEvent_NEW_REQUEST:
+        return "newOrder";
+      case OrderEvent_REPLACE_REQUEST:
+        return "replaceOrder";
+      case OrderEvent_CANCEL_REQUEST:
+        return "cancelOrder";
+      case OrderEvent_CONFIRMED:
+        return "onConfirmed";
+      case OrderEvent_NEW_REJECT:
+        return "onNewReject";
+      case OrderEvent_IOC_CANCELED:
+        return "onIOCCanceled";
+      case OrderEvent_FILLED:
+        return "onFilled";
+      case OrderEvent_PARTIAL_FILL:
+        return "onPartialFill";
+      case OrderEvent_CANCELED:
+        return "onCanceled";
+      case OrderEvent_REPLACED:
+        return "onReplaced";
+      case OrderEvent_REPLACE_REJECTED:
+        return "onReplaceRejected";
+      case OrderEvent_CANCEL_REJECTED:
+        return "onCancelRejected";
+      default:
+        return "[Unknown OrderEvent]";
+      }
+    }
+
+    /**
+     * @brief what the caller does with the wrapper once the event is applied to it
+     */
+    enum OrderAction
+    {
+      OrderAction_NONE = 0,
+      OrderAction_RESET,  // order is gone from the exchange, reset the wrapper for the next new order
+      OrderAction_RESYNC, // transition not allowed, take the state from the wrapper
+      OrderAction_MAX
+    };
+
+    struct OrderTransition
+    {
+      uint8_t state;
+      uint8_t action;
+    };
+
+    /**
+     * @brief transition of state on event, one lookup in a static table
+     */
+    inline OrderTransition getOrderTransition(OrderState state, OrderEvent event)
+    {
+#define TR(STATE, ACTION) {OrderState_##STATE, OrderAction_##ACTION}
+      // rows in OrderState order, columns in OrderEvent order. Late rejects of a replace / cancel that crossed a fill are allowed on IDLE
+      static const OrderTransition transitions[OrderState_MAX][OrderEvent_MAX] = {
+          // IDLE
+          {TR(PENDING_NEW, NONE), TR(IDLE, RESYNC), TR(IDLE, RESYNC),
+           TR(IDLE, RESYNC), TR(IDLE, RESYNC), TR(IDLE, RESYNC), TR(IDLE, RESYNC), TR(IDLE, RESYNC),
+           TR(IDLE, RESYNC), TR(IDLE, RESYNC), TR(IDLE, RESET), TR(IDLE, RESET)},
+          // PENDING_NEW
+          {TR(PENDING_NEW, RESYNC), TR(PENDING_NEW, RESYNC), TR(PENDING_NEW, RESYNC),
+           TR(OPEN, NONE), TR(IDLE, RESET), TR(IDLE, RESET), TR(IDLE, RESET), TR(OPEN, NONE),
+           TR(IDLE, RESET), TR(PENDING_NEW, RESYNC), TR(PENDING_NEW, RESYNC), TR(PENDING_NEW, RESYNC)},
+          // OPEN
+          {TR(OPEN, RESYNC), TR(PENDING_REPLACE, NONE), TR(PENDING_CANCEL, NONE),
+           TR(OPEN, RESYNC), TR(OPEN, RESYNC), TR(IDLE, RESET), TR(IDLE, RESET), TR(OPEN, NONE),
+           TR(IDLE, RESET), TR(OPEN, RESYNC), TR(OPEN, RESYNC), TR(OPEN, RESYNC)},
+          // PENDING_REPLACE
+          {TR(PENDING_REPLACE, RESYNC), TR(PENDING_REPLACE, RESYNC), TR(PENDING_REPLACE, RESYNC),
+           TR(PENDING_REPLACE, RESYNC), TR(PENDING_REPLACE, RESYNC), TR(IDLE, RESET), TR(IDLE, RESET), TR(PENDING_REPLACE, NONE),
+           TR(IDLE, RESET), TR(OPEN, NONE), TR(OPEN, NONE), TR(PENDING_REPLACE, RESYNC)},
+          // PENDING_CANCEL
+          {TR(PENDING_CANCEL, RESYNC), TR(PENDING_CANCEL, RESYNC), TR(PENDING_CANCEL, RESYNC),
+           TR(PENDING_CANCEL, RESYNC), TR(PENDING_CANCEL, RESYNC), TR(IDLE, RESET), TR(IDLE, RESET), TR(PENDING_CANCEL, NONE),
+           TR(IDLE, RESET), TR(PENDING_CANCEL, RESYNC), TR(PENDING_CANCEL, RESYNC), TR(OPEN, NONE)},
+      };
+#undef TR
+      return transitions[state][event];
+    }
+
+    /**
+     * @brief state of an order wrapper from its flags, for wrappers set up outside the machine (warm restart) and RESYNC
+     */
+    inline OrderState getOrderState(const OrderWrapper &orderWrapper)
+    {
+      if (orderWrapper._isReset)
+        return OrderState_IDLE;
+      if (orderWrapper._isPendingCancel)
+        return OrderState_PENDING_CANCEL;
+      if (orderWrapper._isPendingReplace)
+        return OrderState_PENDING_REPLACE;
+      if (orderWrapper._isPendingNew)
+        return OrderState_PENDING_NEW;
+      return OrderState_OPEN;
+    }
+
+    /**
+     * @brief states of a ladder of order wrappers, indexed as the strategy indexes its wrappers
+     */
+    class OrderStateMachine
+    {
+      std::vector<uint8_t> _states;
+      uint64_t _illegalCount;
+
+    public:
+      OrderStateMachine() : _illegalCount(0) {}
+
+      /**
+       * @brief add a wrapper in IDLE
+       * @return its index
+       */
+      size_t add()
+      {
+        _states.push_back(OrderState_IDLE);
+        return _states.size() - 1;
+      }
+
+      size_t size() const { return _states.size(); }
+
+      OrderState getState(size_t index) const { return (OrderState)_states[index]; }
+
+      void setState(size_t index, OrderState state) { _states[index] = (uint8_t)state; }
+
+      /**
+       * @brief move wrapper index on event
+       * @return action for the caller, RESYNC transitions are counted
+       */
+      OrderAction onEvent(size_t index, OrderEvent event)
+      {
+        OrderTransition transition = getOrderTransition((OrderState)_states[index], event);
+        _states[index] = transition.state;
+        if (transition.action == OrderAction_RESYNC)
+          ++_illegalCount;
+        return (OrderAction)transition.action;
+      }
+
+      /**
+       * @brief move wrapper index on a request sent through orderWrapper, a request not expected in the state takes the state from the wrapper
+       */
+      void onRequest(size_t index, OrderEvent event, const OrderWrapper &orderWrapper)
+      {
+        if (onEvent(index, event) == OrderAction_RESYNC)
+          _states[index] = (uint8_t)getOrderState(orderWrapper);
+      }
+
+      uint64_t getIllegalCount() const { return _illegalCount; }
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,142 @@
+#pragma once
+
+/**
+ * Arena of OrderWrapper objects with stable addresses.
+ * Wrappers are constructed in place inside fixed size, cache line aligned chunks which are never moved,
+ * so pointers / references handed out stay valid while strategies grow or shrink their ladders.
+ * Released wrappers go to a free list and their slots are reused by the next acquire, also by
+ * strategies started later in the same process when the shared pool is used.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ */
+
+#include <stdlib.h>
+#include <new>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "orderWrapper.h"
+
+namespace API2
+{
+  namespace COMMON
+  {
+    class OrderWrapperPool
+    {
+    public:
+      static const size_t CHUNK_SIZE = 64;
+
+    private:
+      /**
+       * @brief one wrapper per slot, slot is cache line aligned so wrappers of different strategies never share a line
+       */
+      union alignas(64) Slot
+      {
+        Slot *next;
+        unsigned char storage[sizeof(OrderWrapper)];
+      };
+
+      std::vector<Slot *> _chunks;
+      Slot *_freeList;
+      size_t _inUse;
+      std::mutex _mutex;
+
+      void addChunk()
+      {
+        void *memory = NULL;
+        if (posix_memalign(&memory, alignof(Slot), sizeof(Slot) * CHUNK_SIZE) != 0)
+          throw std::bad_alloc();
+
+        Slot *chunk = static_cast<Slot *>(memory);
+        // keep lower addresses first so wrappers acquired together are adjacent
+        for (size_t i = CHUNK_SIZE; i > 0; --i)
+        {
+          chunk[i - 1].next = _freeList;
+          _freeList = &chunk[i - 1];
+        }
+        _chunks.push_back(chunk);
+      }
+
+      OrderWrapperPool(const OrderWrapperPool &) = delete;
+      OrderWrapperPool &operator=(const OrderWrapperPool &) = delete;
+
+    public:
+      /**
+       * @brief OrderWrapperPool
+       * @param initialCapacity - slots allocated upfront, rounded up to CHUNK_SIZE
+       */
+      explicit OrderWrapperPool(size_t initialCapacity = CHUNK_SIZE) : _freeList(NULL), _inUse(0)
+      {
+        for (size_t capacity = 0; capacity < initialCapacity; capacity += CHUNK_SIZE)
+          addChunk();
+      }
+
+      /**
+       * @brief wrappers still acquired are not destructed, owner must release them before pool goes away
+       */
+      ~OrderWrapperPool()
+      {
+        for (size_t i = 0; i < _chunks.size(); ++i)
+          free(_chunks[i]);
+      }
+
+      /**
+       * @brief process wide pool shared by all strategies of the library
+       */
+      static OrderWrapperPool &shared()
+      {
+        static OrderWrapperPool pool;
+        return pool;
+      }
+
+      /**
+       * @brief construct a wrapper in a free slot, arguments are forwarded to OrderWrapper constructor
+       * @return wrapper with stable address until release
+       */
+      template <typename... Args>
+      OrderWrapper *acquire(Args &&... args)
+      {
+        Slot *slot = NULL;
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          if (_freeList == NULL)
+            addChunk();
+          slot = _freeList;
+          _freeList = slot->next;
+          ++_inUse;
+        }
+        try
+        {
+          return new (slot->storage) OrderWrapper(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          slot->next = _freeList;
+          _freeList = slot;
+          --_inUse;
+          throw;
+        }
+      }
+
+      /**
+       * @brief destruct wrapper and return its slot to the free list
+       * @param orderWrapper - must have been acquired from this pool
+       */
+      void release(OrderWrapper *orderWrapper)
+      {
+        if (orderWrapper == NULL)
+          return;
+        orderWrapper->~OrderWrapper();
+        Slot *slot = reinterpret_cast<Slot *>(orderWrapper);
+        std::lock_guard<std::mutex> lock(_mutex);
+        slot->next = _freeList;
+        _freeList = slot;
+        --_inUse;
+      }
+
+      size_t size() const { return _inUse; }
+      size_t capacity() const { return _chunks.size() * CHUNK_SIZE; }
+    };
+  }
+}
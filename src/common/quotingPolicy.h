@@ -0,0 +1,238 @@
+#ifndef API2_QUOTING_POLICY_H
+#define API2_QUOTING_POLICY_H
+
+/**
+ * Quote price computation of a strategy, resolved at compile time.
+ * A policy derives from QuotingPolicy<Policy> (CRTP) and implements openTargets for new position quotes, it may implement closeTargets
+ * for square-off quotes, by default they are quoted at the new position prices. The strategy compiles its quoting code once per policy
+ * and picks the instantiation from config, computing targets on a tick is an inlined call, never a virtual one.
+ * Book is any depth snapshot with bidPriceLevels / askPriceLevels of { price, quantity }, best level first, prices in scrip precision.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <stdint.h>
+#include <string>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    /**
+     * @brief quoting policy selected by config, name as returned by QuotingPolicyTypeStr
+     */
+    enum QuotingPolicyType
+    {
+      QuotingPolicy_FIXED_LEVEL = 0,
+      QuotingPolicy_JOIN_IMPROVE,
+      QuotingPolicy_INVENTORY_SKEW,
+      QuotingPolicy_MICROPRICE_OFFSET,
+      QuotingPolicy_MAX
+    };
+
+    inline const char *QuotingPolicyTypeStr(QuotingPolicyType v)
+    {
+      switch (v)
+      {
+      case QuotingPolicy_FIXED_LEVEL:
+        return "FIXED_LEVEL";
+      case QuotingPolicy_JOIN_IMPROVE:
+        return "JOIN_IMPROVE";
+      case QuotingPolicy_INVENTORY_SKEW:
+        return "INVENTORY_SKEW";
+      case QuotingPolicy_MICROPRICE_OFFSET:
+        return "MICROPRICE_OFFSET";
+      default:
+        return "[Unknown QuotingPolicyType]";
+      }
+    }
+
+    /**
+     * @brief policy of a config name
+     * @return QuotingPolicy_MAX if name is unknown
+     */
+    inline QuotingPolicyType getQuotingPolicyType(const std::string &name)
+    {
+      for (int i = 0; i < QuotingPolicy_MAX; ++i)
+        if (name == QuotingPolicyTypeStr((QuotingPolicyType)i))
+          return (QuotingPolicyType)i;
+      return QuotingPolicy_MAX;
+    }
+
+    /**
+     * @brief parameters of all policies, filled once from config, each policy reads its own
+     */
+    struct QuotingParams
+    {
+      int tickSize = 1;
+      int maxPos = 0;       // position of full inventory skew
+      int level = 2;        // FIXED_LEVEL, depth level of new position quotes
+      int closeLevel = 2;   // FIXED_LEVEL, depth level of square-off quotes
+      int improveTicks = 0; // JOIN_IMPROVE, ticks inside the best price while the spread allows
+      int skewTicks = 0;    // INVENTORY_SKEW, shift of both quotes at maxPos, against the position
+      int offsetTicks = 1;  // MICROPRICE_OFFSET, distance of both quotes from the microprice
+    };
+
+    /**
+     * @brief prices of new position and square-off quotes
+     */
+    struct QuoteTargets
+    {
+      int openBid;
+      int openAsk;
+      int closeBid;
+      int closeAsk;
+    };
+
+    template <typename Derived>
+    class QuotingPolicy
+    {
+    protected:
+      const QuotingParams &_params;
+
+      explicit QuotingPolicy(const QuotingParams &params) : _params(params) {}
+
+      int getTick() const { return _params.tickSize > 0 ? _params.tickSize : 1; }
+
+      int floorToTick(int64_t price) const { return (int)(price - price % getTick()); }
+
+      int ceilToTick(int64_t price) const
+      {
+        int64_t remainder = price % getTick();
+        return (int)(remainder == 0 ? price : price - remainder + getTick());
+      }
+
+      /**
+       * @brief a quote inside the spread must not reach the other side, bid stays below best ask and ask above best bid
+       */
+      template <typename Book>
+      void keepPassive(const Book &book, int &bid, int &ask) const
+      {
+        if (bid > book.askPriceLevels[0].price - getTick())
+          bid = book.askPriceLevels[0].price - getTick();
+        if (ask < book.bidPriceLevels[0].price + getTick())
+          ask = book.bidPriceLevels[0].price + getTick();
+      }
+
+    public:
+      /**
+       * @brief quote prices for the current book
+       * @param book
+       * @param netPosition - signed, positive when long
+       * @param targets
+       */
+      template <typename Book>
+      void computeTargets(const Book &book, int netPosition, QuoteTargets &targets) const
+      {
+        const Derived &policy = static_cast<const Derived &>(*this);
+        policy.openTargets(book, netPosition, targets);
+        policy.closeTargets(book, netPosition, targets);
+      }
+
+      /**
+       * @brief square-off quotes at the new position prices, a policy hides it to price them apart
+       */
+      template <typename Book>
+      void closeTargets(const Book &, int, QuoteTargets &targets) const
+      {
+        targets.closeBid = targets.openBid;
+        targets.closeAsk = targets.openAsk;
+      }
+    };
+
+    /**
+     * @brief quotes at fixed depth levels, level 2 for both kinds by default
+     */
+    class FixedLevelQuoting : public QuotingPolicy<FixedLevelQuoting>
+    {
+    public:
+      explicit FixedLevelQuoting(const QuotingParams &params) : QuotingPolicy<FixedLevelQuoting>(params) {}
+
+      template <typename Book>
+      void openTargets(const Book &book, int, QuoteTargets &targets) const
+      {
+        targets.openBid = book.bidPriceLevels[_params.level].price;
+        targets.openAsk = book.askPriceLevels[_params.level].price;
+      }
+
+      template <typename Book>
+      void closeTargets(const Book &book, int, QuoteTargets &targets) const
+      {
+        targets.closeBid = book.bidPriceLevels[_params.closeLevel].price;
+        targets.closeAsk = book.askPriceLevels[_params.closeLevel].price;
+      }
+    };
+
+    /**
+     * @brief joins the best prices, improves them by improveTicks when the spread leaves room for both quotes
+     */
+    class JoinImproveQuoting : public QuotingPolicy<JoinImproveQuoting>
+    {
+    public:
+      explicit JoinImproveQuoting(const QuotingParams &params) : QuotingPolicy<JoinImproveQuoting>(params) {}
+
+      template <typename Book>
+      void openTargets(const Book &book, int, QuoteTargets &targets) const
+      {
+        int improvement = _params.improveTicks * getTick();
+        targets.openBid = book.bidPriceLevels[0].price + improvement;
+        targets.openAsk = book.askPriceLevels[0].price - improvement;
+        if (targets.openBid >= targets.openAsk)
+        {
+          targets.openBid = book.bidPriceLevels[0].price;
+          targets.openAsk = book.askPriceLevels[0].price;
+        }
+      }
+    };
+
+    /**
+     * @brief best prices shifted against the position, up to skewTicks at maxPos, so a long quotes lower and a short higher
+     */
+    class InventorySkewQuoting : public QuotingPolicy<InventorySkewQuoting>
+    {
+    public:
+      explicit InventorySkewQuoting(const QuotingParams &params) : QuotingPolicy<InventorySkewQuoting>(params) {}
+
+      template <typename Book>
+      void openTargets(const Book &book, int netPosition, QuoteTargets &targets) const
+      {
+        int skew = 0;
+        if (_params.maxPos > 0)
+        {
+          int position = netPosition > _params.maxPos ? _params.maxPos : (netPosition < -_params.maxPos ? -_params.maxPos : netPosition);
+          skew = (int)((int64_t)_params.skewTicks * position / _params.maxPos) * getTick();
+        }
+        targets.openBid = book.bidPriceLevels[0].price - skew;
+        targets.openAsk = book.askPriceLevels[0].price - skew;
+        keepPassive(book, targets.openBid, targets.openAsk);
+      }
+    };
+
+    /**
+     * @brief quotes offsetTicks around the size weighted mid of the best level, rounded away from it to the tick
+     */
+    class MicropriceOffsetQuoting : public QuotingPolicy<MicropriceOffsetQuoting>
+    {
+    public:
+      explicit MicropriceOffsetQuoting(const QuotingParams &params) : QuotingPolicy<MicropriceOffsetQuoting>(params) {}
+
+      template <typename Book>
+      void openTargets(const Book &book, int, QuoteTargets &targets) const
+      {
+        int64_t bidPrice = book.bidPriceLevels[0].price;
+        int64_t askPrice = book.askPriceLevels[0].price;
+        int64_t bidQty = book.bidPriceLevels[0].quantity;
+        int64_t askQty = book.askPriceLevels[0].quantity;
+        // a larger bid than ask means the next trade is more likely up, weight of each price is the size on the other side
+        int64_t microprice = bidQty + askQty > 0 ? (bidPrice * askQty + askPrice * bidQty) / (bidQty + askQty) : (bidPrice + askPrice) / 2;
+        int64_t offset = (int64_t)_params.offsetTicks * getTick();
+        targets.openBid = floorToTick(microprice - offset);
+        targets.openAsk = ceilToTick(microprice + offset);
+        keepPassive(book, targets.openBid, targets.openAsk);
+      }
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,163 @@
+#pragma once
+
+/**
+ * Pre-trade risk limits of an instrument, kept in one cache line.
+ * The block is filled once from SymbolStaticData when the instrument is created and refreshed
+ * when static data may have changed (e.g. on timer), so the per-order check never touches
+ * getStaticData() and never logs.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ */
+
+#include <stdint.h>
+#include <limits>
+#include <sgSymbolDataDefines.h>
+#include <sharedUtilities.h>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    /**
+     * @brief reason code returned by checkRiskLimits, RiskCheck_OK when order can be sent
+     */
+    enum RiskCheckResult
+    {
+      RiskCheck_OK = 0,
+      RiskCheck_DPR_BREACHED,
+      RiskCheck_TER_BREACHED,
+      RiskCheck_FREEZE_QTY_BREACHED,
+      RiskCheck_MAX_ORDER_VALUE_BREACHED,
+      RiskCheck_MAX_OPEN_QTY_BREACHED,
+      RiskCheck_COLLAR_BREACHED,
+      RiskCheck_MAX
+    };
+
+    inline const char *RiskCheckResultStr(RiskCheckResult v)
+    {
+      switch (v)
+      {
+      case RiskCheck_OK:
+        return "OK";
+      case RiskCheck_DPR_BREACHED:
+        return "DPR Breached";
+      case RiskCheck_TER_BREACHED:
+        return "TER Breached";
+      case RiskCheck_FREEZE_QTY_BREACHED:
+        return "Order Quantity Entered is Above Freeze Quantity";
+      case RiskCheck_MAX_ORDER_VALUE_BREACHED:
+        return "Max Order Value Breached";
+      case RiskCheck_MAX_OPEN_QTY_BREACHED:
+        return "Max Open Quantity Breached";
+      case RiskCheck_COLLAR_BREACHED:
+        return "Price Collar Breached";
+      default:
+        return "[Unknown RiskCheckResult]";
+      }
+    }
+
+    /**
+     * @brief Risk limits of one instrument. A limit set to 0 is disabled.
+     * Prices and values are in scrip precision (same unit as order price).
+     * Quantities and collar width are 32 bit, saturated when set, so the block fits one cache line.
+     */
+    struct alignas(64) RiskLimits
+    {
+      SIGNED_LONG lowerBandPrice = 0;          // lower DPR
+      SIGNED_LONG upperBandPrice = 0;          // upper DPR
+      SIGNED_LONG lowTradeExecutionRange = 0;  // lower TER
+      SIGNED_LONG highTradeExecutionRange = 0; // upper TER
+      SIGNED_LONG maxOrderValue = 0;
+      int32_t freezeQty = 0;
+      int32_t maxOpenQty[2] = {0, 0};          // indexed by CMD_OrderMode_BUY / CMD_OrderMode_SELL
+      int32_t collarWidth = 0;                 // max distance from mid, in price
+
+      static int32_t saturate(const SIGNED_LONG value)
+      {
+        if (value > std::numeric_limits<int32_t>::max())
+          return std::numeric_limits<int32_t>::max();
+        if (value < 0)
+          return 0;
+        return (int32_t)value;
+      }
+
+      /**
+       * @brief refresh exchange driven limits (DPR, TER, freeze qty) from static data
+       * @param staticData
+       * @return false if staticData is NULL
+       */
+      bool refresh(const API2::SymbolStaticData *staticData)
+      {
+        if (staticData == NULL)
+          return false;
+        lowerBandPrice = staticData->lowerBandPrice;
+        upperBandPrice = staticData->upperBandPrice;
+        lowTradeExecutionRange = staticData->lowTradeExecutionRange;
+        highTradeExecutionRange = staticData->highTradeExecutionRange;
+        freezeQty = saturate(staticData->freezeQuantity);
+        return true;
+      }
+
+      /**
+       * @brief set strategy driven limits, called once when instrument is created
+       * @param staticData
+       * @param maxOrderValueInRupees - 0 to disable
+       * @param maxOpenLots - max open lots per side, 0 to disable
+       * @param collarTicks - max distance from mid in ticks, 0 to disable
+       * @return false if staticData is NULL
+       */
+      bool initialize(API2::SymbolStaticData *staticData,
+                      const double maxOrderValueInRupees,
+                      const SIGNED_LONG maxOpenLots,
+                      const SIGNED_LONG collarTicks)
+      {
+        if (!refresh(staticData))
+          return false;
+        maxOrderValue = API2::SharedUtilities::decreasePrecision(maxOrderValueInRupees, staticData);
+        maxOpenQty[API2::CONSTANTS::CMD_OrderMode_BUY] = saturate(maxOpenLots * staticData->marketLot);
+        maxOpenQty[API2::CONSTANTS::CMD_OrderMode_SELL] = saturate(maxOpenLots * staticData->marketLot);
+        collarWidth = saturate(collarTicks * staticData->tickSize);
+        return true;
+      }
+    };
+    static_assert(sizeof(RiskLimits) <= 64, "RiskLimits must fit one cache line");
+
+    /**
+     *@brief  checks order against the precomputed limits without branching per limit
+     *@Params limits
+     *@Params mode - CMD_OrderMode_BUY / CMD_OrderMode_SELL
+     *@Params price
+     *@Params qty
+     *@Params openQty - qty already open on this side excluding this order
+     *@Params midPrice - 0 skips the collar check
+     *@Return RiskCheck_OK or first breached limit
+     **/
+    inline RiskCheckResult checkRiskLimits(const RiskLimits &limits,
+                                           const API2::DATA_TYPES::OrderMode mode,
+                                           const SIGNED_LONG price,
+                                           const SIGNED_LONG qty,
+                                           const SIGNED_LONG openQty,
+                                           const SIGNED_LONG midPrice)
+    {
+      const SIGNED_LONG maxOpenQty = limits.maxOpenQty[mode & 1];
+      const SIGNED_LONG distance = price > midPrice ? price - midPrice : midPrice - price;
+
+      // each bit is set when the limit is enabled and breached, bit order is the reason code order
+      unsigned breached =
+          ((unsigned)((limits.upperBandPrice != 0 && limits.lowerBandPrice != 0) &
+                      ((price >= limits.upperBandPrice) | (price <= limits.lowerBandPrice)))
+           << 0) |
+          ((unsigned)((limits.highTradeExecutionRange != 0 && limits.lowTradeExecutionRange != 0) &
+                      ((price >= limits.highTradeExecutionRange) | (price <= limits.lowTradeExecutionRange)))
+           << 1) |
+          ((unsigned)((limits.freezeQty != 0) & (qty >= limits.freezeQty)) << 2) |
+          ((unsigned)((limits.maxOrderValue != 0) & (price * qty > limits.maxOrderValue)) << 3) |
+          ((unsigned)((maxOpenQty != 0) & (openQty + qty > maxOpenQty)) << 4) |
+          ((unsigned)((limits.collarWidth != 0) & (midPrice != 0) & (distance > limits.collarWidth)) << 5);
+
+      if (__builtin_expect(breached == 0, 1))
+        return RiskCheck_OK;
+      return (RiskCheckResult)(__builtin_ctz(breached) + 1);
+    }
+  }
+}
@@ -0,0 +1,379 @@
+/**
+ * Debug log backend, per thread slabs of line slots, lock-free queue to a writev writer thread.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include "slabLog.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <new>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    namespace
+    {
+      const size_t WRITE_BATCH = 64; // lines per writev
+      const size_t PREFIX_SIZE = 32; // "YYYYMMDD HH:MM:SS.uuuuuu | "
+
+      std::atomic<uint64_t> nextLogId(1);
+
+      // streambuf over the text of the current slot, writes past the slot fail instead of growing
+      class SlotBuffer : public std::streambuf
+      {
+      public:
+        void reset(char *text, size_t capacity) { setp(text, text + capacity); }
+        size_t size() const { return pptr() - pbase(); }
+      };
+
+      // slots and slabs are over-aligned, which plain new does not honour before C++17, freed with free()
+      void *allocateAligned(size_t alignment, size_t size)
+      {
+        void *memory = NULL;
+        if (posix_memalign(&memory, alignment, size) != 0)
+          throw std::bad_alloc();
+        return memory;
+      }
+    }
+
+    // one line, published to the writer through next
+    struct alignas(64) SlabLog::Slot
+    {
+      std::atomic<Slot *> next;
+      Slab *slab;
+      uint64_t sequence; // claim order in slab
+      int64_t timestamp;
+      uint32_t length;
+      char text[SLOT_SIZE - 36];
+    };
+
+    // ring of slots owned by one logging thread, the writer gives slots back in claim order through released
+    struct SlabLog::Slab
+    {
+      Slot *slots;
+      uint64_t mask;
+      uint64_t claimed; // owner thread only
+      alignas(64) std::atomic<uint64_t> released;
+      std::atomic<uint64_t> dropCount;
+      std::thread::id owner;
+      Slot *current;
+      SlotBuffer buffer;
+      std::ostream stream;
+
+      Slab(size_t size, std::thread::id owner_) : slots(static_cast<Slot *>(allocateAligned(alignof(Slot), sizeof(Slot) * size))), mask(size - 1), claimed(0), released(0), dropCount(0),
+                                                   owner(owner_), current(NULL), stream(&buffer)
+      {
+        for (size_t i = 0; i < size; ++i)
+        {
+          new (&slots[i]) Slot();
+          slots[i].slab = this;
+        }
+      }
+
+      ~Slab()
+      {
+        for (size_t i = 0; i <= mask; ++i)
+          slots[i].~Slot();
+        free(slots);
+      }
+    };
+
+    SlabLog::SlabLog(size_t slotsPerThread) : _id(nextLogId.fetch_add(1)), _slotsPerThread(1), _fallback(NULL), _stub(new (allocateAligned(alignof(Slot), sizeof(Slot))) Slot()),
+                                              _fd(-1), _isOpen(false), _isRunning(false), _writeErrorCount(0), _prefixSecond(-1)
+    {
+      static_assert(sizeof(Slot) == SLOT_SIZE, "slot is one SLOT_SIZE block");
+      size_t size = 1;
+      while (size < slotsPerThread)
+        size <<= 1;
+      _slotsPerThread = size;
+
+      _stub->next.store(NULL, std::memory_order_relaxed);
+      _queueHead.store(_stub, std::memory_order_relaxed);
+      _queueTail = _stub;
+      _prefixSecondText[0] = 0;
+    }
+
+    SlabLog::~SlabLog()
+    {
+      close();
+      for (size_t i = 0; i < _slabs.size(); ++i)
+      {
+        _slabs[i]->~Slab();
+        free(_slabs[i]);
+      }
+      _stub->~Slot();
+      free(_stub);
+    }
+
+    bool SlabLog::open(const std::string &path, const ThreadPlacement &placement, std::string &error)
+    {
+      if (isOpen())
+      {
+        error = "already open";
+        return false;
+      }
+      int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+      if (fd < 0)
+      {
+        error = "open " + path + ": " + strerror(errno);
+        return false;
+      }
+      _fd = fd;
+      _placement = placement;
+      _isRunning.store(true);
+      _writer = std::thread(&SlabLog::run, this);
+      _placementError.clear();
+      _placement.apply(_writer.native_handle(), _placementError);
+      _isOpen.store(true, std::memory_order_release);
+      return true;
+    }
+
+    void SlabLog::close()
+    {
+      if (!isOpen())
+        return;
+      _isOpen.store(false, std::memory_order_release);
+      _isRunning.store(false);
+      if (_writer.joinable())
+        _writer.join();
+      ::close(_fd);
+      _fd = -1;
+    }
+
+    void SlabLog::message(const char *debugMessage)
+    {
+      if (!isOpen())
+      {
+        if (_fallback)
+          _fallback->message(debugMessage);
+        return;
+      }
+      if (Slab *slab = beginLine())
+      {
+        getStream(slab) << debugMessage;
+        endLine(slab);
+      }
+    }
+
+    void SlabLog::message(const std::string &debugMessage)
+    {
+      if (!isOpen())
+      {
+        if (_fallback)
+          _fallback->message(debugMessage);
+        return;
+      }
+      if (Slab *slab = beginLine())
+      {
+        getStream(slab) << debugMessage;
+        endLine(slab);
+      }
+    }
+
+    void SlabLog::flushLog(bool printNextLine)
+    {
+      if (!isOpen() && _fallback)
+        _fallback->flushLog(printNextLine);
+    }
+
+    uint64_t SlabLog::getDropCount()
+    {
+      std::lock_guard<std::mutex> lock(_slabsMutex);
+      uint64_t dropCount = 0;
+      for (size_t i = 0; i < _slabs.size(); ++i)
+        dropCount += _slabs[i]->dropCount.load(std::memory_order_relaxed);
+      return dropCount;
+    }
+
+    // slab of the calling thread, a thread remembers the last log it wrote to, lookup under lock only when that changes
+    SlabLog::Slab *SlabLog::getSlab()
+    {
+      static thread_local uint64_t cachedLogId = 0;
+      static thread_local Slab *cachedSlab = NULL;
+      if (cachedLogId == _id)
+        return cachedSlab;
+
+      std::lock_guard<std::mutex> lock(_slabsMutex);
+      std::thread::id self = std::this_thread::get_id();
+      Slab *slab = NULL;
+      for (size_t i = 0; i < _slabs.size() && slab == NULL; ++i)
+        if (_slabs[i]->owner == self)
+          slab = _slabs[i];
+      if (slab == NULL)
+      {
+        void *memory = allocateAligned(alignof(Slab), sizeof(Slab));
+        try
+        {
+          slab = new (memory) Slab(_slotsPerThread, self);
+        }
+        catch (...)
+        {
+          free(memory);
+          throw;
+        }
+        _slabs.push_back(slab);
+      }
+      cachedLogId = _id;
+      cachedSlab = slab;
+      return slab;
+    }
+
+    SlabLog::Slab *SlabLog::beginLine()
+    {
+      Slab *slab = getSlab();
+      if (slab->claimed - slab->released.load(std::memory_order_acquire) > slab->mask)
+      {
+        slab->dropCount.store(slab->dropCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return NULL;
+      }
+      Slot *slot = &slab->slots[slab->claimed & slab->mask];
+      slot->sequence = slab->claimed++;
+      struct timespec now;
+      clock_gettime(CLOCK_REALTIME, &now);
+      slot->timestamp = (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+      slab->current = slot;
+      slab->buffer.reset(slot->text, sizeof(slot->text) - 1); // room for the new line
+      slab->stream.clear();
+      return slab;
+    }
+
+    void SlabLog::endLine(Slab *slab)
+    {
+      Slot *slot = slab->current;
+      size_t length = slab->buffer.size();
+      slot->text[length++] = '\n';
+      slot->length = (uint32_t)length;
+      push(slot);
+    }
+
+    std::ostream &SlabLog::getStream(Slab *slab)
+    {
+      return slab->stream;
+    }
+
+    // intrusive MPSC queue (Vyukov), a producer is one exchange and one store, never waits for the writer
+    void SlabLog::push(Slot *slot)
+    {
+      slot->next.store(NULL, std::memory_order_relaxed);
+      Slot *prev = _queueHead.exchange(slot, std::memory_order_acq_rel);
+      prev->next.store(slot, std::memory_order_release);
+    }
+
+    // NULL if empty or the next producer has not linked its slot yet
+    SlabLog::Slot *SlabLog::pop()
+    {
+      Slot *tail = _queueTail;
+      Slot *next = tail->next.load(std::memory_order_acquire);
+      if (tail == _stub)
+      {
+        if (next == NULL)
+          return NULL;
+        _queueTail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+      }
+      if (next != NULL)
+      {
+        _queueTail = next;
+        return tail;
+      }
+      if (tail != _queueHead.load(std::memory_order_acquire))
+        return NULL;
+      push(_stub);
+      next = tail->next.load(std::memory_order_acquire);
+      if (next != NULL)
+      {
+        _queueTail = next;
+        return tail;
+      }
+      return NULL;
+    }
+
+    void SlabLog::run()
+    {
+      while (_isRunning.load(std::memory_order_relaxed))
+      {
+        if (writeBatch() == 0)
+          _placement.idle();
+      }
+      while (writeBatch() != 0)
+        ;
+    }
+
+    size_t SlabLog::writeBatch()
+    {
+      Slot *batch[WRITE_BATCH];
+      size_t count = 0;
+      while (count < WRITE_BATCH && (batch[count] = pop()) != NULL)
+        ++count;
+      if (count == 0)
+        return 0;
+
+      char prefixes[WRITE_BATCH][PREFIX_SIZE];
+      struct iovec iov[2 * WRITE_BATCH];
+      for (size_t i = 0; i < count; ++i)
+      {
+        iov[2 * i].iov_base = prefixes[i];
+        iov[2 * i].iov_len = formatPrefix(batch[i]->timestamp, prefixes[i]);
+        iov[2 * i + 1].iov_base = batch[i]->text;
+        iov[2 * i + 1].iov_len = batch[i]->length;
+      }
+      if (!writeAll(iov, (int)(2 * count)))
+        _writeErrorCount.fetch_add(1, std::memory_order_relaxed);
+
+      for (size_t i = 0; i < count; ++i)
+        batch[i]->slab->released.store(batch[i]->sequence + 1, std::memory_order_release);
+      return count;
+    }
+
+    bool SlabLog::writeAll(struct iovec *iov, int count)
+    {
+      while (count > 0)
+      {
+        ssize_t written = writev(_fd, iov, count);
+        if (written < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          return false;
+        }
+        while (count > 0 && (size_t)written >= iov->iov_len)
+        {
+          written -= iov->iov_len;
+          ++iov;
+          --count;
+        }
+        if (count > 0)
+        {
+          iov->iov_base = (char *)iov->iov_base + written;
+          iov->iov_len -= written;
+        }
+      }
+      return true;
+    }
+
+    // date and time are formatted once per second, only the microseconds per line
+    size_t SlabLog::formatPrefix(int64_t timestamp, char *prefix)
+    {
+      int64_t second = timestamp / 1000000000LL;
+      if (second != _prefixSecond)
+      {
+        time_t seconds = (time_t)second;
+        struct tm local;
+        localtime_r(&seconds, &local);
+        strftime(_prefixSecondText, sizeof(_prefixSecondText), "%Y%m%d %H:%M:%S", &local);
+        _prefixSecond = second;
+      }
+      int length = snprintf(prefix, PREFIX_SIZE, "%s.%06d | ", _prefixSecondText, (int)((timestamp % 1000000000LL) / 1000));
+      return length < (int)PREFIX_SIZE ? (size_t)length : PREFIX_SIZE - 1;
+    }
+  }
+}
@@ -0,0 +1,195 @@
+#ifndef API2_SLAB_LOG_H
+#define API2_SLAB_LOG_H
+
+/**
+ * Debug log backend with the interface of API2::DebugLog, DEBUG_MESSAGE / DEBUG_VARSHOW / DEBUG_VARSHOW2 / DEBUG_ARRAYSHOW /
+ * DEBUG_VALUE_OF / DEBUG_FLUSH work on a SlabLog pointer as they are.
+ * The calling thread formats a line into a fixed size slot of its own slab (allocated on the first line of the thread, reused afterwards),
+ * slots are published through a lock-free multi producer / single consumer queue and one writer thread hands them to the file
+ * with writev in batches. No line costs a heap allocation or a lock, a line of a thread whose slab is full is dropped and counted,
+ * a line longer than a slot is truncated.
+ * While the log is not open every call goes to the fallback API2::DebugLog.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include "threadPlacement.h"
+#include <sgDebugLogDefines.h>
+#include <stdint.h>
+#include <sys/uio.h>
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    class SlabLog
+    {
+    public:
+      static const size_t SLOT_SIZE = 512;
+
+      /**
+       * @brief SlabLog
+       * @param slotsPerThread - slab size of every logging thread, rounded up to a power of two
+       */
+      explicit SlabLog(size_t slotsPerThread = 1024);
+      ~SlabLog();
+
+      /**
+       * @brief lines are passed to fallback while the log is not open, NULL drops them
+       */
+      void setFallback(API2::DebugLog *fallback) { _fallback = fallback; }
+
+      /**
+       * @brief open file for append and start the writer thread
+       * @param path
+       * @param placement - cpu affinity, priority and idle policy of the writer
+       * @param error - reason if failed
+       * @return false if the file can not be opened. Writer still runs if placement fails, see getPlacementError
+       */
+      bool open(const std::string &path, const ThreadPlacement &placement, std::string &error);
+
+      /**
+       * @brief stop the writer after it wrote all published lines. Threads must not log to it while it closes
+       */
+      void close();
+
+      bool isOpen() const { return _isOpen.load(std::memory_order_acquire); }
+
+      void message(const char *debugMessage);
+
+      void message(const std::string &debugMessage);
+
+      template <class T>
+      void value_of(const std::string &name, const T &value)
+      {
+        if (!isOpen())
+        {
+          if (_fallback)
+            _fallback->value_of(name, value);
+          return;
+        }
+        if (Slab *slab = beginLine())
+        {
+          getStream(slab) << name << " = " << value;
+          endLine(slab);
+        }
+      }
+
+      template <class T>
+      void printToLog(const char *debugMessage, const T &debugVar)
+      {
+        if (!isOpen())
+        {
+          if (_fallback)
+            _fallback->printToLog(debugMessage, debugVar);
+          return;
+        }
+        if (Slab *slab = beginLine())
+        {
+          getStream(slab) << debugMessage << " " << debugVar;
+          endLine(slab);
+        }
+      }
+
+      template <class T, class K>
+      void printToLog2(const char *debugMessage, const T &debugVar1, const K &debugVar2)
+      {
+        if (!isOpen())
+        {
+          if (_fallback)
+            _fallback->printToLog2(debugMessage, debugVar1, debugVar2);
+          return;
+        }
+        if (Slab *slab = beginLine())
+        {
+          getStream(slab) << debugMessage << " " << debugVar1 << " " << debugVar2;
+          endLine(slab);
+        }
+      }
+
+      template <class T>
+      void printToLogArr(const char *debugMessage, const T debugVar[], int index)
+      {
+        if (!isOpen())
+        {
+          if (_fallback)
+            _fallback->printToLogArr(debugMessage, debugVar, index);
+          return;
+        }
+        if (Slab *slab = beginLine())
+        {
+          std::ostream &stream = getStream(slab);
+          stream << debugMessage;
+          for (int i = 0; i < index; i++)
+            stream << " " << debugVar[i];
+          endLine(slab);
+        }
+      }
+
+      /**
+       * @brief lines are written as soon as the writer gets them, only the fallback has anything to flush
+       */
+      void flushLog(bool printNextLine = true);
+
+      /**
+       * @brief lines dropped because the slab of the logging thread was full
+       */
+      uint64_t getDropCount();
+
+      uint64_t getWriteErrorCount() const { return _writeErrorCount.load(std::memory_order_relaxed); }
+
+      const std::string &getPlacementError() const { return _placementError; }
+
+    private:
+      struct Slot;
+      struct Slab;
+
+      SlabLog(const SlabLog &);
+      SlabLog &operator=(const SlabLog &);
+
+      Slab *getSlab();
+      Slab *beginLine();
+      void endLine(Slab *slab);
+      static std::ostream &getStream(Slab *slab);
+
+      void push(Slot *slot);
+      Slot *pop();
+      void run();
+      size_t writeBatch();
+      bool writeAll(struct iovec *iov, int count);
+      size_t formatPrefix(int64_t timestamp, char *prefix);
+
+      const uint64_t _id;
+      size_t _slotsPerThread;
+      API2::DebugLog *_fallback;
+
+      std::mutex _slabsMutex;
+      std::vector<Slab *> _slabs;
+
+      alignas(64) std::atomic<Slot *> _queueHead; // producers
+      alignas(64) Slot *_queueTail;               // writer only
+      Slot *_stub;
+
+      int _fd;
+      std::atomic<bool> _isOpen;
+      std::atomic<bool> _isRunning;
+      std::atomic<uint64_t> _writeErrorCount;
+      ThreadPlacement _placement;
+      std::string _placementError;
+      std::thread _writer;
+
+      // writer only, date and time of the last second seen
+      int64_t _prefixSecond;
+      char _prefixSecondText[32];
+    };
+  }
+}
+
+#endif
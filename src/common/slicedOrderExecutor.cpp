@@ -0,0 +1,228 @@
+/**
+ * Executes a parent quantity bigger than the exchange freeze quantity as freeze compliant child orders.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include "slicedOrderExecutor.h"
+#include <limits>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    SlicedOrderExecutor::SlicedOrderExecutor(const std::vector<OrderWrapper *> &pool,
+                                             const SIGNED_LONG freezeQty,
+                                             const SIGNED_LONG marketLot,
+                                             const int maxInFlight,
+                                             const int maxMsgsPerWindow,
+                                             const int64_t windowMicros)
+        : _sliceQty(0),
+          _parentQty(0),
+          _parentPrice(0),
+          _remainingQty(0),
+          _filledQty(0),
+          _isActive(false),
+          _isCancelled(false),
+          _maxInFlight(maxInFlight > 0 ? maxInFlight : (int)pool.size()),
+          _maxMsgsPerWindow(maxMsgsPerWindow),
+          _windowNanos(windowMicros * 1000LL),
+          _windowStart(0),
+          _windowMsgCount(0),
+          _msgSentCount(0),
+          _throttledCount(0)
+    {
+      _children.reserve(pool.size());
+      for (size_t i = 0; i < pool.size(); ++i)
+        _children.push_back(Child(pool[i]));
+
+      SIGNED_LONG lot = marketLot > 0 ? marketLot : 1;
+      //isOrderPlaceable rejects qty >= freezeQty, so largest child is one lot below freeze qty
+      if (freezeQty > 0)
+        _sliceQty = ((freezeQty - 1) / lot) * lot;
+      else
+        _sliceQty = std::numeric_limits<SIGNED_LONG>::max();
+    }
+
+    bool SlicedOrderExecutor::start(API2::DATA_TYPES::RiskStatus &riskStatus, const SIGNED_LONG price, const SIGNED_LONG qty)
+    {
+      if (_isActive || qty <= 0 || _sliceQty <= 0 || _children.empty())
+        return false;
+
+      _parentQty = qty;
+      _parentPrice = price;
+      _remainingQty = qty;
+      _filledQty = 0;
+      _isActive = true;
+      _isCancelled = false;
+      pump(riskStatus);
+      return true;
+    }
+
+    int SlicedOrderExecutor::pump(API2::DATA_TYPES::RiskStatus &riskStatus)
+    {
+      //children done without a confirmation of their own (wrapper reset by the strategy) free their wrapper here
+      for (size_t i = 0; i < _children.size(); ++i)
+      {
+        if (_children[i].qty != 0 && !_children[i].wrapper->isOrderOpen())
+          onChildDone(_children[i]);
+      }
+      if (_isCancelled)
+        cancelOpenChildren(riskStatus);
+      if (!_isActive)
+        return 0;
+
+      int sent = 0;
+      int inFlight = getInFlightCount();
+      for (size_t i = 0; i < _children.size(); ++i)
+      {
+        if (_remainingQty <= 0 || inFlight >= _maxInFlight)
+          break;
+
+        Child &child = _children[i];
+        if (child.qty != 0 || child.wrapper->isOrderOpen())
+          continue;
+
+        if (!takeThrottleSlot())
+        {
+          ++_throttledCount;
+          break;
+        }
+
+        SIGNED_LONG qty = _remainingQty < _sliceQty ? _remainingQty : _sliceQty;
+        if (!child.wrapper->_isReset)
+          child.wrapper->reset();
+        if (!child.wrapper->newOrder(riskStatus, _parentPrice, qty))
+          break;
+
+        child.qty = qty;
+        child.filledQty = 0;
+        child.isAcked = false;
+        _remainingQty -= qty;
+        ++inFlight;
+        ++sent;
+        ++_msgSentCount;
+      }
+      return sent;
+    }
+
+    bool SlicedOrderExecutor::onConfirmation(API2::DATA_TYPES::RiskStatus &riskStatus, const API2::COMMON::OrderId *orderId, OrderEvent event, const SIGNED_LONG lastFillQty)
+    {
+      int index = findChild(orderId);
+      if (index < 0)
+        return false;
+
+      Child &child = _children[index];
+      switch (event)
+      {
+      case OrderEvent_CONFIRMED:
+      case OrderEvent_REPLACED:
+        child.isAcked = true;
+        break;
+      case OrderEvent_FILLED:
+      case OrderEvent_PARTIAL_FILL:
+        child.isAcked = true;
+        child.filledQty += lastFillQty;
+        _filledQty += lastFillQty;
+        break;
+      case OrderEvent_NEW_REJECT:
+        //do not keep resending a rejected slice, strategy decides to restart
+        _isActive = false;
+        break;
+      default:
+        break;
+      }
+
+      if (child.qty != 0 && !child.wrapper->isOrderOpen())
+        onChildDone(child);
+
+      if (_filledQty >= _parentQty)
+        _isActive = false;
+
+      pump(riskStatus);
+      return true;
+    }
+
+    int SlicedOrderExecutor::findChild(const API2::COMMON::OrderId *orderId) const
+    {
+      for (size_t i = 0; i < _children.size(); ++i)
+      {
+        if (_children[i].wrapper->_orderId == orderId)
+          return (int)i;
+      }
+      return -1;
+    }
+
+    bool SlicedOrderExecutor::hasOpenChildren() const
+    {
+      for (size_t i = 0; i < _children.size(); ++i)
+      {
+        if (_children[i].qty != 0)
+          return true;
+      }
+      return false;
+    }
+
+    void SlicedOrderExecutor::cancel(API2::DATA_TYPES::RiskStatus &riskStatus)
+    {
+      _isActive = false;
+      _isCancelled = true;
+      _remainingQty = 0;
+      cancelOpenChildren(riskStatus);
+    }
+
+    //a child waiting for its new order ack can not be canceled yet, pump retries it once open (also after a cancel reject)
+    void SlicedOrderExecutor::cancelOpenChildren(API2::DATA_TYPES::RiskStatus &riskStatus)
+    {
+      for (size_t i = 0; i < _children.size(); ++i)
+      {
+        OrderWrapper *wrapper = _children[i].wrapper;
+        if (_children[i].qty != 0 && wrapper->getLastQuantity() && !wrapper->isOrderPending())
+        {
+          if (wrapper->cancelOrder(riskStatus))
+            ++_msgSentCount;
+        }
+      }
+    }
+
+    bool SlicedOrderExecutor::takeThrottleSlot()
+    {
+      if (_maxMsgsPerWindow <= 0)
+        return true;
+
+      int64_t now = getMonotonicTimestamp();
+      if (now - _windowStart >= _windowNanos)
+      {
+        _windowStart = now;
+        _windowMsgCount = 0;
+      }
+      if (_windowMsgCount >= _maxMsgsPerWindow)
+        return false;
+      ++_windowMsgCount;
+      return true;
+    }
+
+    int SlicedOrderExecutor::getInFlightCount() const
+    {
+      int inFlight = 0;
+      for (size_t i = 0; i < _children.size(); ++i)
+      {
+        if (_children[i].qty != 0 && !_children[i].isAcked)
+          ++inFlight;
+      }
+      return inFlight;
+    }
+
+    void SlicedOrderExecutor::onChildDone(Child &child)
+    {
+      //unfilled part of a canceled child goes back to the parent
+      SIGNED_LONG unfilledQty = child.qty - child.filledQty;
+      if (_isActive && unfilledQty > 0)
+        _remainingQty += unfilledQty;
+      child.qty = 0;
+      child.filledQty = 0;
+      child.isAcked = false;
+    }
+  }
+}
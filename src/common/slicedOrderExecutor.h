@@ -0,0 +1,147 @@
+#ifndef API2_SLICED_ORDER_EXECUTOR_H
+#define API2_SLICED_ORDER_EXECUTOR_H
+
+/**
+ * Executes a parent quantity bigger than the exchange freeze quantity as freeze compliant child orders.
+ * Children are placed over a pool of order wrappers owned by the strategy, the next child is sent as soon as
+ * a wrapper is free or an earlier child is acknowledged, without waiting for fills.
+ * Confirmations of children are processed into their wrappers by the strategy first (processConfirmation, reset when
+ * nothing is left open), the executor only accounts them and pipelines the next children.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <time.h>
+#include <vector>
+#include <sgContext.h>
+#include "orderWrapper.h"
+#include "orderStateMachine.h"
+
+namespace API2
+{
+  namespace COMMON
+  {
+    class SlicedOrderExecutor
+    {
+      struct Child
+      {
+        OrderWrapper *wrapper;
+        SIGNED_LONG qty;
+        SIGNED_LONG filledQty;
+        bool isAcked;
+        Child(OrderWrapper *orderWrapper) : wrapper(orderWrapper), qty(0), filledQty(0), isAcked(false) {}
+      };
+
+      std::vector<Child> _children;
+
+      SIGNED_LONG _sliceQty;
+      SIGNED_LONG _parentQty;
+      SIGNED_LONG _parentPrice;
+      SIGNED_LONG _remainingQty; // qty not yet sent as a child
+      SIGNED_LONG _filledQty;
+      bool _isActive;
+      bool _isCancelled; // children still pending at cancel() are canceled by pump once acknowledged
+
+      int _maxInFlight;      // max children waiting for exchange ack
+      int _maxMsgsPerWindow; // message throttle, 0 disables
+      int64_t _windowNanos;
+      int64_t _windowStart;
+      int _windowMsgCount;
+
+      uint32_t _msgSentCount;
+      uint32_t _throttledCount;
+
+      static int64_t getMonotonicTimestamp()
+      {
+        timespec ts;
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+      }
+
+      bool takeThrottleSlot();
+      int getInFlightCount() const;
+      void onChildDone(Child &child);
+      void cancelOpenChildren(API2::DATA_TYPES::RiskStatus &riskStatus);
+
+    public:
+      /**
+       * @brief SlicedOrderExecutor
+       * @param pool - order wrappers used for children, all must be of same instrument and mode. Caller keeps ownership
+       *               and the wrappers must not move while executor is in use.
+       * @param freezeQty - exchange freeze quantity, child qty is always below it. 0 means no freeze limit
+       * @param marketLot - child qty is rounded down to market lot
+       * @param maxInFlight - max children sent but not yet acknowledged, 0 means pool size
+       * @param maxMsgsPerWindow - max new orders per throttle window, 0 disables the throttle
+       * @param windowMicros - throttle window in microseconds
+       */
+      SlicedOrderExecutor(const std::vector<OrderWrapper *> &pool,
+                          const SIGNED_LONG freezeQty,
+                          const SIGNED_LONG marketLot,
+                          const int maxInFlight = 0,
+                          const int maxMsgsPerWindow = 0,
+                          const int64_t windowMicros = 1000000);
+
+      /**
+       * @brief start a new parent order, fails if an earlier parent is still active
+       * @param riskStatus
+       * @param price
+       * @param qty - parent quantity
+       * @return true if parent was accepted, children may still be throttled
+       */
+      bool start(API2::DATA_TYPES::RiskStatus &riskStatus, const SIGNED_LONG price, const SIGNED_LONG qty);
+
+      /**
+       * @brief send as many children as pool, in flight limit and throttle allow.
+       *        Call on timer / market data event while hasPendingSlices() or hasOpenChildren() to drain throttled children
+       *        and free wrappers of children that are done.
+       * @param riskStatus
+       * @return number of children sent
+       */
+      int pump(API2::DATA_TYPES::RiskStatus &riskStatus);
+
+      /**
+       * @brief account a confirmation already processed into the child wrapper and pipeline next children
+       * @param riskStatus
+       * @param orderId
+       * @param event - confirmation event of the child
+       * @param lastFillQty - fill qty of a FILLED / PARTIAL_FILL event
+       * @return false if orderId does not belong to this executor
+       */
+      bool onConfirmation(API2::DATA_TYPES::RiskStatus &riskStatus, const API2::COMMON::OrderId *orderId, OrderEvent event, const SIGNED_LONG lastFillQty);
+
+      /**
+       * @brief index of the child wrapper of orderId
+       * @return -1 if orderId does not belong to this executor
+       */
+      int findChild(const API2::COMMON::OrderId *orderId) const;
+
+      OrderWrapper *getChildWrapper(size_t index) { return _children[index].wrapper; }
+      size_t getChildCount() const { return _children.size(); }
+
+      /**
+       * @brief true while a child is sent and not yet filled / canceled / rejected, also after cancel until they are done
+       */
+      bool hasOpenChildren() const;
+
+      /**
+       * @brief stop sending children and cancel resting ones, children waiting for their ack are canceled by pump once open
+       * @param riskStatus
+       */
+      void cancel(API2::DATA_TYPES::RiskStatus &riskStatus);
+
+      bool isActive() const { return _isActive; }
+      bool isComplete() const { return _parentQty > 0 && _filledQty >= _parentQty; }
+      bool hasPendingSlices() const { return _isActive && _remainingQty > 0; }
+      SIGNED_LONG getSliceQty() const { return _sliceQty; }
+      SIGNED_LONG getParentQty() const { return _parentQty; }
+      SIGNED_LONG getParentPrice() const { return _parentPrice; }
+      SIGNED_LONG getFilledQty() const { return _filledQty; }
+      SIGNED_LONG getRemainingQty() const { return _remainingQty; }
+      uint32_t getMsgSentCount() const { return _msgSentCount; }
+      uint32_t getThrottledCount() const { return _throttledCount; }
+    };
+  }
+}
+
+#endif
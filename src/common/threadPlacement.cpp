@@ -0,0 +1,227 @@
+/**
+ * CPU affinity, real time priority and idle policy of threads run by strategy code.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include "threadPlacement.h"
+#include <ctype.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    namespace
+    {
+      inline int64_t getMonotonicTimestamp()
+      {
+        timespec ts;
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+      }
+
+      inline bool contains(const std::vector<int> &cpus, int cpu)
+      {
+        return std::find(cpus.begin(), cpus.end(), cpu) != cpus.end();
+      }
+    }
+
+    bool ThreadPlacement::apply(pthread_t thread, std::string &error) const
+    {
+      bool isApplied = true;
+      if (!cpus.empty())
+      {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        for (size_t i = 0; i < cpus.size(); ++i)
+          CPU_SET(cpus[i], &cpuSet);
+        int ret = pthread_setaffinity_np(thread, sizeof(cpuSet), &cpuSet);
+        if (ret != 0)
+        {
+          error += name + ": setaffinity failed, " + strerror(ret) + ". ";
+          isApplied = false;
+        }
+      }
+      if (fifoPriority > 0)
+      {
+        sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = fifoPriority;
+        int ret = pthread_setschedparam(thread, SCHED_FIFO, &param);
+        if (ret != 0)
+        {
+          // usually missing CAP_SYS_NICE / rtprio limit
+          error += name + ": SCHED_FIFO " + std::to_string(fifoPriority) + " failed, " + strerror(ret) + ". ";
+          isApplied = false;
+        }
+      }
+      return isApplied;
+    }
+
+    void ThreadPlacement::idle() const
+    {
+      if (isBusyPoll)
+        __builtin_ia32_pause();
+      else if (idleSleepMicros > 0)
+        usleep(idleSleepMicros);
+      else
+        sched_yield();
+    }
+
+    bool parseCpuList(const std::string &cpuList, std::vector<int> &cpus)
+    {
+      cpus.clear();
+      size_t pos = 0;
+      while (pos < cpuList.size())
+      {
+        size_t end = cpuList.find(',', pos);
+        if (end == std::string::npos)
+          end = cpuList.size();
+        std::string token = cpuList.substr(pos, end - pos);
+        pos = end + 1;
+
+        token.erase(std::remove_if(token.begin(), token.end(), ::isspace), token.end());
+        if (token.empty())
+          continue;
+
+        char *rangeEnd = NULL;
+        long first = strtol(token.c_str(), &rangeEnd, 10);
+        long last = first;
+        if (rangeEnd == token.c_str())
+          return false;
+        if (*rangeEnd == '-')
+        {
+          const char *lastBegin = rangeEnd + 1;
+          last = strtol(lastBegin, &rangeEnd, 10);
+          if (rangeEnd == lastBegin)
+            return false;
+        }
+        if (*rangeEnd != '\0' || first < 0 || last < first || last >= CPU_SETSIZE)
+          return false;
+        for (long cpu = first; cpu <= last; ++cpu)
+          cpus.push_back((int)cpu);
+      }
+      return true;
+    }
+
+    std::vector<int> readCpuListFile(const std::string &path)
+    {
+      std::vector<int> cpus;
+      std::ifstream file(path.c_str());
+      std::string cpuList;
+      if (file && std::getline(file, cpuList))
+        parseCpuList(cpuList, cpus);
+      return cpus;
+    }
+
+    bool validateThreadPlacements(const std::vector<ThreadPlacement> &placements, std::vector<std::string> &warnings)
+    {
+      bool isValid = true;
+      const long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+      const std::vector<int> isolated = readCpuListFile("/sys/devices/system/cpu/isolated");
+      const std::vector<int> nohzFull = readCpuListFile("/sys/devices/system/cpu/nohz_full");
+
+      for (size_t i = 0; i < placements.size(); ++i)
+      {
+        const ThreadPlacement &placement = placements[i];
+        for (size_t c = 0; c < placement.cpus.size(); ++c)
+        {
+          int cpu = placement.cpus[c];
+          if (cpu >= cpuCount)
+          {
+            warnings.push_back(placement.name + ": cpu " + std::to_string(cpu) + " is not online, " + std::to_string(cpuCount) + " cpus available");
+            isValid = false;
+            continue;
+          }
+          if (!contains(isolated, cpu))
+            warnings.push_back(placement.name + ": cpu " + std::to_string(cpu) + " is not in isolcpus, other tasks can be scheduled on it");
+          if (!contains(nohzFull, cpu))
+            warnings.push_back(placement.name + ": cpu " + std::to_string(cpu) + " is not in nohz_full, scheduler tick still interrupts it");
+
+          for (size_t j = i + 1; j < placements.size(); ++j)
+          {
+            if (!contains(placements[j].cpus, cpu) || !(placement.isBusyPoll || placements[j].isBusyPoll))
+              continue;
+            warnings.push_back(placement.name + " and " + placements[j].name + " share cpu " + std::to_string(cpu) + " while one of them busy polls");
+            // a spinning SCHED_FIFO thread is never preempted by another one of same or lower priority
+            if (placement.fifoPriority > 0 && placements[j].fifoPriority > 0)
+              isValid = false;
+          }
+        }
+
+        if (placement.cpus.empty() && (placement.isBusyPoll || placement.fifoPriority > 0))
+          warnings.push_back(placement.name + ": busy poll / SCHED_FIFO without cpu affinity can starve other threads");
+        if (placement.fifoPriority > 0 && placement.isBusyPoll && placement.cpus.size() == 1 && !contains(isolated, placement.cpus[0]))
+          warnings.push_back(placement.name + ": busy polling SCHED_FIFO thread on a non isolated cpu starves kernel threads of that cpu");
+        if (placement.fifoPriority < 0 || placement.fifoPriority > 99)
+        {
+          warnings.push_back(placement.name + ": SCHED_FIFO priority " + std::to_string(placement.fifoPriority) + " out of range 1-99");
+          isValid = false;
+        }
+      }
+      return isValid;
+    }
+
+    JitterReport calibrateJitter(int64_t durationMicros)
+    {
+      // log2 histogram of gaps, bucket i holds gaps in [2^i, 2^(i+1)) ns
+      static const int BUCKETS = 40;
+      uint64_t histogram[BUCKETS];
+      memset(histogram, 0, sizeof(histogram));
+
+      JitterReport report;
+      memset(&report, 0, sizeof(report));
+
+      const int64_t start = getMonotonicTimestamp();
+      const int64_t end = start + durationMicros * 1000;
+      int64_t previous = start;
+      while (previous < end)
+      {
+        int64_t now = getMonotonicTimestamp();
+        int64_t gap = now - previous;
+        previous = now;
+        ++report.samples;
+        if (gap > report.maxGapNanos)
+          report.maxGapNanos = gap;
+        if (gap > 10000)
+          ++report.gapsOver10Micros;
+        int bucket = gap > 0 ? 63 - __builtin_clzll((uint64_t)gap) : 0;
+        ++histogram[bucket < BUCKETS ? bucket : BUCKETS - 1];
+      }
+
+      // percentiles reported as upper bound of their bucket
+      uint64_t cumulative = 0;
+      for (int i = 0; i < BUCKETS; ++i)
+      {
+        cumulative += histogram[i];
+        if (report.p99GapNanos == 0 && cumulative * 100 >= report.samples * 99)
+          report.p99GapNanos = 2LL << i;
+        if (report.p999GapNanos == 0 && cumulative * 1000 >= report.samples * 999)
+          report.p999GapNanos = 2LL << i;
+      }
+      return report;
+    }
+
+    JitterReport calibrateJitter(const ThreadPlacement &placement, int64_t durationMicros, std::string &error)
+    {
+      JitterReport report;
+      std::thread calibration([&]()
+                              {
+                                placement.apply(error);
+                                report = calibrateJitter(durationMicros);
+                              });
+      calibration.join();
+      return report;
+    }
+  }
+}
@@ -0,0 +1,101 @@
+#ifndef API2_THREAD_PLACEMENT_H
+#define API2_THREAD_PLACEMENT_H
+
+/**
+ * CPU affinity, real time priority and idle policy of threads run by strategy code,
+ * with validation against kernel core isolation (isolcpus / nohz_full) and a scheduling jitter calibration.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    /**
+     * @brief placement of one thread
+     */
+    struct ThreadPlacement
+    {
+      std::string name;
+      std::vector<int> cpus; // affinity, empty leaves the thread to the scheduler
+      int fifoPriority;      // SCHED_FIFO priority 1-99, 0 keeps SCHED_OTHER
+      bool isBusyPoll;       // spin instead of sleeping when idle
+      int idleSleepMicros;   // sleep when idle and not busy polling
+
+      ThreadPlacement(const std::string &name_ = "") : name(name_), fifoPriority(0), isBusyPoll(false), idleSleepMicros(100) {}
+
+      /**
+       * @brief apply affinity and scheduling policy to a thread
+       * @param thread
+       * @param error - reason if failed
+       * @return false if any setting could not be applied
+       */
+      bool apply(pthread_t thread, std::string &error) const;
+
+      /**
+       * @brief apply to the calling thread
+       */
+      bool apply(std::string &error) const { return apply(pthread_self(), error); }
+
+      /**
+       * @brief idle wait of a polling loop according to the policy
+       */
+      void idle() const;
+    };
+
+    /**
+     * @brief scheduling gaps seen by a thread spinning on the clock
+     */
+    struct JitterReport
+    {
+      uint64_t samples;
+      int64_t maxGapNanos;
+      int64_t p99GapNanos;
+      int64_t p999GapNanos;
+      uint64_t gapsOver10Micros;
+    };
+
+    /**
+     * @brief parse a kernel style cpu list e.g. "2,4-6"
+     * @return false on malformed list
+     */
+    bool parseCpuList(const std::string &cpuList, std::vector<int> &cpus);
+
+    /**
+     * @brief cpus of a sysfs cpu list file e.g. /sys/devices/system/cpu/isolated, empty if unavailable
+     */
+    std::vector<int> readCpuListFile(const std::string &path);
+
+    /**
+     * @brief check placements against online cpus, isolcpus and nohz_full and against each other
+     * @param placements
+     * @param warnings - one human readable line per finding
+     * @return false if a placement can not work (e.g. cpu does not exist, SCHED_FIFO threads sharing a cpu while one busy polls),
+     *         warnings alone keep it true
+     */
+    bool validateThreadPlacements(const std::vector<ThreadPlacement> &placements, std::vector<std::string> &warnings);
+
+    /**
+     * @brief spin on CLOCK_MONOTONIC on the calling thread and measure gaps between consecutive reads
+     * @param durationMicros - calibration window
+     */
+    JitterReport calibrateJitter(int64_t durationMicros);
+
+    /**
+     * @brief calibrateJitter on a temporary thread placed by placement, e.g. on the strategy cpus before the strategy starts
+     * @param placement
+     * @param durationMicros - calibration window
+     * @param error - reason if placement could not be applied, calibration still runs
+     */
+    JitterReport calibrateJitter(const ThreadPlacement &placement, int64_t durationMicros, std::string &error);
+  }
+}
+
+#endif
@@ -0,0 +1,268 @@
+#ifndef API2_TIMING_WHEEL_H
+#define API2_TIMING_WHEEL_H
+
+/**
+ * Hierarchical timing wheel for deadlines of orders and strategies.
+ * LEVELS wheels of SLOTS slots, a slot of level l covers SLOTS^l ticks. A timer goes to the lowest level whose range holds its deadline
+ * and moves down a level each time the level above turns to its slot, at level 0 it expires. Timers are nodes of a pool allocated once,
+ * linked by index into their slot, so schedule and cancel are O(1) and never allocate. Advancing skips empty level 0 slots by bitmap.
+ * Deadlines further than SLOTS^LEVELS ticks wait on the top level and are placed again when it turns.
+ * Timers never expire early, a timer expires on the first advance at or after its deadline rounded up to the tick.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    class TimingWheel
+    {
+    public:
+      typedef uint64_t TimerId; // 0 is no timer
+
+      static const int LEVELS = 4;
+      static const int SLOT_BITS = 6;
+      static const uint32_t SLOTS = 1 << SLOT_BITS;
+
+    private:
+      static const uint64_t SLOT_MASK = SLOTS - 1;
+      static const uint32_t NIL = 0xFFFFFFFF;
+
+      struct Node
+      {
+        int64_t deadlineTick;
+        uint64_t data;
+        uint32_t kind;
+        uint32_t generation;
+        uint32_t next;
+        uint32_t prev;
+        uint32_t list; // level * SLOTS + slot, NIL while free
+      };
+
+      std::vector<Node> _nodes;
+      uint32_t _freeList;
+      uint32_t _heads[LEVELS * SLOTS];
+      uint64_t _occupied[LEVELS]; // bit per non empty slot
+      int64_t _tickNanos;
+      int64_t _currentTick;
+      size_t _size;
+      uint64_t _overflowCount;
+
+      static int countTrailingZeros(uint64_t value) { return __builtin_ctzll(value); }
+
+      // minDelta 1 for a new timer, the current slot is already expired. 0 while cascading, the current slot expires next
+      void link(uint32_t index, int64_t minDelta)
+      {
+        Node &node = _nodes[index];
+        int64_t delta = node.deadlineTick - _currentTick;
+        if (delta < minDelta)
+          delta = minDelta;
+        int level = 0;
+        while (level < LEVELS - 1 && delta >= (int64_t)1 << (SLOT_BITS * (level + 1)))
+          ++level;
+        int64_t tick = _currentTick + delta;
+        // past the range of the top level, parked on its last slot before the current one
+        if (level == LEVELS - 1 && delta >= (int64_t)1 << (SLOT_BITS * LEVELS))
+          tick = _currentTick + ((int64_t)1 << (SLOT_BITS * LEVELS)) - 1;
+        uint32_t slot = (uint32_t)((tick >> (SLOT_BITS * level)) & SLOT_MASK);
+        uint32_t list = level * SLOTS + slot;
+
+        node.list = list;
+        node.prev = NIL;
+        node.next = _heads[list];
+        if (node.next != NIL)
+          _nodes[node.next].prev = index;
+        _heads[list] = index;
+        _occupied[level] |= (uint64_t)1 << slot;
+      }
+
+      void unlink(uint32_t index)
+      {
+        Node &node = _nodes[index];
+        if (node.prev != NIL)
+          _nodes[node.prev].next = node.next;
+        else
+          _heads[node.list] = node.next;
+        if (node.next != NIL)
+          _nodes[node.next].prev = node.prev;
+        if (_heads[node.list] == NIL)
+          _occupied[node.list / SLOTS] &= ~((uint64_t)1 << (node.list % SLOTS));
+        node.list = NIL;
+      }
+
+      void release(uint32_t index)
+      {
+        Node &node = _nodes[index];
+        ++node.generation;
+        node.next = _freeList;
+        _freeList = index;
+        --_size;
+      }
+
+      // level turned to slot, its timers move to lower levels
+      void cascade(int level, uint32_t slot)
+      {
+        uint32_t list = level * SLOTS + slot;
+        uint32_t index = _heads[list];
+        _heads[list] = NIL;
+        _occupied[level] &= ~((uint64_t)1 << slot);
+        while (index != NIL)
+        {
+          uint32_t next = _nodes[index].next;
+          link(index, 0);
+          index = next;
+        }
+      }
+
+      TimingWheel(const TimingWheel &);
+      TimingWheel &operator=(const TimingWheel &);
+
+    public:
+      /**
+       * @brief TimingWheel
+       * @param capacity - max pending timers, allocated here once
+       * @param tickNanos - resolution, deadlines are rounded up to it
+       * @param now - timestamp of tick 0 of the wheel, same clock as deadlines
+       */
+      TimingWheel(size_t capacity, int64_t tickNanos, int64_t now = 0) : _nodes(capacity), _freeList(NIL), _tickNanos(tickNanos > 0 ? tickNanos : 1),
+                                                                          _currentTick(now / (tickNanos > 0 ? tickNanos : 1)), _size(0), _overflowCount(0)
+      {
+        for (size_t i = capacity; i > 0; --i)
+        {
+          _nodes[i - 1].generation = 1;
+          _nodes[i - 1].list = NIL;
+          _nodes[i - 1].next = _freeList;
+          _freeList = (uint32_t)(i - 1);
+        }
+        for (uint32_t i = 0; i < LEVELS * SLOTS; ++i)
+          _heads[i] = NIL;
+        for (int i = 0; i < LEVELS; ++i)
+          _occupied[i] = 0;
+      }
+
+      /**
+       * @brief restart the wheel at now with another resolution, only while no timer is pending
+       * @return false if timers are pending, nothing is changed
+       */
+      bool reset(int64_t now, int64_t tickNanos)
+      {
+        if (_size != 0)
+          return false;
+        _tickNanos = tickNanos > 0 ? tickNanos : 1;
+        _currentTick = now / _tickNanos;
+        return true;
+      }
+
+      /**
+       * @brief schedule a timer
+       * @param deadline - same clock as advance, a deadline already passed expires on the next tick
+       * @param kind - passed back on expiry
+       * @param data - passed back on expiry
+       * @return 0 if all timers are in use, the timer is dropped and counted
+       */
+      TimerId schedule(int64_t deadline, uint32_t kind, uint64_t data)
+      {
+        if (_freeList == NIL)
+        {
+          ++_overflowCount;
+          return 0;
+        }
+        uint32_t index = _freeList;
+        Node &node = _nodes[index];
+        _freeList = node.next;
+        ++_size;
+        node.deadlineTick = (deadline + _tickNanos - 1) / _tickNanos;
+        node.kind = kind;
+        node.data = data;
+        link(index, 1);
+        return ((TimerId)node.generation << 32) | (index + 1);
+      }
+
+      /**
+       * @brief cancel a pending timer
+       * @return false if timerId is 0, expired or already canceled
+       */
+      bool cancel(TimerId timerId)
+      {
+        uint32_t index = (uint32_t)(timerId & 0xFFFFFFFF) - 1;
+        if (timerId == 0 || index >= _nodes.size())
+          return false;
+        Node &node = _nodes[index];
+        if (node.generation != (uint32_t)(timerId >> 32) || node.list == NIL)
+          return false;
+        unlink(index);
+        release(index);
+        return true;
+      }
+
+      /**
+       * @brief expire timers with deadline up to now in deadline order (timers of one tick in any order)
+       * @param now - same clock as deadlines, earlier than the last advance is ignored
+       * @param handler - called as handler(kind, data) with the timer already released, may schedule and cancel timers
+       * @return number of expired timers
+       */
+      template <typename Handler>
+      size_t advance(int64_t now, Handler handler)
+      {
+        int64_t nowTick = now / _tickNanos;
+        size_t expired = 0;
+        while (_currentTick < nowTick)
+        {
+          if (_size == 0)
+          {
+            _currentTick = nowTick;
+            break;
+          }
+          // next tick with level 0 timers in this turn of level 0, or the start of the next turn
+          int64_t tick = _currentTick + 1;
+          uint32_t slot = (uint32_t)(tick & SLOT_MASK);
+          if (slot != 0)
+          {
+            uint64_t ahead = _occupied[0] >> slot;
+            tick = ahead != 0 ? tick + countTrailingZeros(ahead) : tick - slot + SLOTS;
+            if (tick > nowTick)
+            {
+              _currentTick = nowTick;
+              break;
+            }
+          }
+          _currentTick = tick;
+          slot = (uint32_t)(tick & SLOT_MASK);
+          for (int level = 1; slot == 0 && level < LEVELS; ++level)
+          {
+            uint32_t upperSlot = (uint32_t)((tick >> (SLOT_BITS * level)) & SLOT_MASK);
+            cascade(level, upperSlot);
+            if (upperSlot != 0)
+              break;
+          }
+          // handler may schedule, a new timer never lands on the slot being expired
+          uint32_t index;
+          while ((index = _heads[slot]) != NIL)
+          {
+            Node &node = _nodes[index];
+            uint32_t kind = node.kind;
+            uint64_t data = node.data;
+            unlink(index);
+            release(index);
+            ++expired;
+            handler(kind, data);
+          }
+        }
+        return expired;
+      }
+
+      size_t size() const { return _size; }
+      size_t capacity() const { return _nodes.size(); }
+      int64_t getTickNanos() const { return _tickNanos; }
+      uint64_t getOverflowCount() const { return _overflowCount; }
+    };
+  }
+}
+
+#endif
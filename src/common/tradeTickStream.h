@@ -0,0 +1,241 @@
+#ifndef API2_TRADE_TICK_STREAM_H
+#define API2_TRADE_TICK_STREAM_H
+
+/**
+ * Allocation free trade tick stream.
+ * TradeTickRing is a fixed capacity single producer / single consumer ring, the producer (the trade tick callback) only
+ * copies ticks in, strategy drains all queued ticks in one batch.
+ * When the ring is full new ticks are dropped and counted.
+ * TradeFlowStats keeps rolling traded volume, VWAP and trade sign imbalance over a time window of the drained ticks.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+#include <sgMktData.h>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    /**
+     * @brief POD copy of TradeTick
+     */
+    struct TradeTickEntry
+    {
+      API2::DATA_TYPES::PRICE price;
+      API2::DATA_TYPES::QTY qty;
+      UNSIGNED_LONG timestamp;
+    };
+
+    template <size_t CAPACITY>
+    class TradeTickRing
+    {
+      static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "TradeTickRing capacity must be a power of two");
+
+      TradeTickEntry _ticks[CAPACITY];
+      alignas(64) std::atomic<uint64_t> _head; // written by producer
+      alignas(64) std::atomic<uint64_t> _tail; // written by consumer
+      alignas(64) uint64_t _overflowCount;     // producer only
+
+    public:
+      TradeTickRing() : _head(0), _tail(0), _overflowCount(0) {}
+
+      /**
+       * @brief producer side
+       * @return false if ring was full and tick is dropped
+       */
+      bool push(const API2::DATA_TYPES::PRICE price, const API2::DATA_TYPES::QTY qty, const UNSIGNED_LONG timestamp)
+      {
+        uint64_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= CAPACITY)
+        {
+          ++_overflowCount;
+          return false;
+        }
+        TradeTickEntry &entry = _ticks[head & (CAPACITY - 1)];
+        entry.price = price;
+        entry.qty = qty;
+        entry.timestamp = timestamp;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+      }
+
+      bool push(const API2::COMMON::TradeTick &tradeTick)
+      {
+        return push(tradeTick.getPrice(), tradeTick.getQty(), tradeTick.getTimestamp());
+      }
+
+      /**
+       * @brief consumer side, hands all queued ticks to handler as at most two contiguous batches
+       * @param handler - callable as handler(const TradeTickEntry *ticks, size_t count)
+       * @return number of ticks consumed
+       */
+      template <typename Handler>
+      size_t consume(Handler &&handler)
+      {
+        uint64_t tail = _tail.load(std::memory_order_relaxed);
+        uint64_t head = _head.load(std::memory_order_acquire);
+        size_t count = (size_t)(head - tail);
+        if (count == 0)
+          return 0;
+
+        size_t begin = (size_t)(tail & (CAPACITY - 1));
+        size_t firstBatch = count < CAPACITY - begin ? count : CAPACITY - begin;
+        handler(&_ticks[begin], firstBatch);
+        if (firstBatch < count)
+          handler(&_ticks[0], count - firstBatch);
+
+        _tail.store(head, std::memory_order_release);
+        return count;
+      }
+
+      size_t size() const { return (size_t)(_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire)); }
+      static size_t capacity() { return CAPACITY; }
+      uint64_t getOverflowCount() const { return _overflowCount; }
+    };
+
+    /**
+     * @brief rolling trade aggregates over a time window, memory is allocated once at construction
+     */
+    class TradeFlowStats
+    {
+      struct Trade
+      {
+        UNSIGNED_LONG timestamp;
+        int64_t qty;
+        int64_t signedQty;
+        double notional;
+      };
+
+      std::vector<Trade> _window;
+      size_t _begin;
+      size_t _count;
+      UNSIGNED_LONG _windowLength;
+
+      int64_t _volume;
+      int64_t _signedVolume;
+      double _notional;
+      uint64_t _droppedCount; // trades evicted early because window capacity was exceeded
+
+      API2::DATA_TYPES::PRICE _lastPrice;
+      int _lastSign;
+
+      void evictFront()
+      {
+        const Trade &trade = _window[_begin];
+        _volume -= trade.qty;
+        _signedVolume -= trade.signedQty;
+        _notional -= trade.notional;
+        _begin = _begin + 1 == _window.size() ? 0 : _begin + 1;
+        --_count;
+      }
+
+    public:
+      /**
+       * @brief TradeFlowStats
+       * @param windowLength - in unit of trade tick timestamps
+       * @param maxTradesInWindow - window capacity, oldest trades are evicted early if exceeded
+       */
+      explicit TradeFlowStats(UNSIGNED_LONG windowLength, size_t maxTradesInWindow = 4096)
+          : _window(maxTradesInWindow > 0 ? maxTradesInWindow : 1),
+            _begin(0),
+            _count(0),
+            _windowLength(windowLength),
+            _volume(0),
+            _signedVolume(0),
+            _notional(0),
+            _droppedCount(0),
+            _lastPrice(0),
+            _lastSign(0)
+      {
+      }
+
+      void setWindowLength(UNSIGNED_LONG windowLength) { _windowLength = windowLength; }
+
+      /**
+       * @brief add a trade, aggressor side from quote rule against mid, tick rule when trade is at mid or mid is unknown
+       * @param tick
+       * @param midPrice - mid of the book when trade was received, 0 if unknown
+       */
+      void onTrade(const TradeTickEntry &tick, const API2::DATA_TYPES::PRICE midPrice)
+      {
+        int sign = 0;
+        if (midPrice > 0 && tick.price != midPrice)
+          sign = tick.price > midPrice ? 1 : -1;
+        else if (_lastPrice > 0 && tick.price != _lastPrice)
+          sign = tick.price > _lastPrice ? 1 : -1;
+        else
+          sign = _lastSign;
+        _lastSign = sign;
+        _lastPrice = tick.price;
+
+        if (_count == _window.size())
+        {
+          evictFront();
+          ++_droppedCount;
+        }
+        size_t end = _begin + _count;
+        if (end >= _window.size())
+          end -= _window.size();
+        Trade &trade = _window[end];
+        trade.timestamp = tick.timestamp;
+        trade.qty = tick.qty;
+        trade.signedQty = sign * (int64_t)tick.qty;
+        trade.notional = (double)tick.price * tick.qty;
+        ++_count;
+
+        _volume += trade.qty;
+        _signedVolume += trade.signedQty;
+        _notional += trade.notional;
+      }
+
+      /**
+       * @brief add a batch of trades as delivered by TradeTickRing::consume and expire old trades
+       */
+      void onTrades(const TradeTickEntry *ticks, size_t count, const API2::DATA_TYPES::PRICE midPrice)
+      {
+        for (size_t i = 0; i < count; ++i)
+          onTrade(ticks[i], midPrice);
+        if (count > 0)
+          expire(ticks[count - 1].timestamp);
+      }
+
+      /**
+       * @brief drop trades older than window length before now
+       */
+      void expire(UNSIGNED_LONG now)
+      {
+        while (_count > 0 && now > _window[_begin].timestamp && now - _window[_begin].timestamp > _windowLength)
+          evictFront();
+        if (_count == 0)
+        {
+          // reset running sums so floating point drift does not accumulate
+          _notional = 0;
+          _volume = 0;
+          _signedVolume = 0;
+        }
+      }
+
+      int64_t getVolume() const { return _volume; }
+      int64_t getSignedVolume() const { return _signedVolume; }
+      size_t getTradeCount() const { return _count; }
+      uint64_t getDroppedCount() const { return _droppedCount; }
+
+      /**
+       * @brief volume weighted average price in scrip precision, 0 if no trade in window
+       */
+      double getVwap() const { return _volume > 0 ? _notional / _volume : 0; }
+
+      /**
+       * @brief (buy volume - sell volume) / volume in [-1, 1], 0 if no trade in window
+       */
+      double getImbalance() const { return _volume > 0 ? (double)_signedVolume / _volume : 0; }
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,151 @@
+/**
+ * Trading calendar with cached time to expiry.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include "tradingCalendar.h"
+
+namespace API2
+{
+  namespace COMMON
+  {
+    namespace
+    {
+      const double SECONDS_IN_YEAR = 365.0 * 24 * 60 * 60;
+
+      inline int64_t floorDiv(int64_t value, int64_t divisor)
+      {
+        int64_t quotient = value / divisor;
+        return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? quotient - 1 : quotient;
+      }
+    }
+
+    TradingCalendar::TradingCalendar(int32_t utcOffset)
+        : _utcOffset(utcOffset),
+          _expiryTimeOfDay(15 * 3600 + 30 * 60),
+          _day(-1),
+          _secondsOfDay(0),
+          _sessionPhase(SessionPhase_CLOSED)
+    {
+      for (int weekday = 1; weekday <= 5; ++weekday)
+        _weekdaySessions[weekday] = getNseSession();
+    }
+
+    int64_t TradingCalendar::daysFromCivil(int32_t year, uint32_t month, uint32_t day)
+    {
+      // proleptic gregorian calendar, H. Hinnant's days_from_civil
+      year -= month <= 2;
+      const int64_t era = (year >= 0 ? year : year - 399) / 400;
+      const uint32_t yoe = (uint32_t)(year - era * 400);
+      const uint32_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+      const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+      return era * 146097 + (int64_t)doe - 719468;
+    }
+
+    void TradingCalendar::setWeekdaySession(int weekday, const SessionTimes &session)
+    {
+      if (weekday < 0 || weekday > 6)
+        return;
+      _weekdaySessions[weekday] = session;
+      _day = -1;
+    }
+
+    void TradingCalendar::setSpecialSession(int32_t yyyymmdd, const SessionTimes &session)
+    {
+      _specialSessions[daysFromCivil(yyyymmdd / 10000, (yyyymmdd / 100) % 100, yyyymmdd % 100)] = session;
+      _day = -1;
+    }
+
+    size_t TradingCalendar::registerInstrument(const API2::SymbolStaticData *data, const API2::DATA_TYPES::EXPIRYDAY_TYPE expiryDayType)
+    {
+      Expiry expiry;
+      expiry.maturityDay = -1;
+      expiry.expiryTime = 0;
+      expiry.expiryDayType = expiryDayType;
+      expiry.timeToExpireInYears = 0;
+      expiry.fractionalTimeToExpire = 0;
+      expiry.isExpiryDay = false;
+      expiry.isPastExpiryCutoff = false;
+
+      if (data != NULL && data->securityType != API2::CONSTANTS::CMD_SecurityType_COMMON_STOCK && data->maturityYearmon > 0)
+      {
+        expiry.maturityDay = daysFromCivil(data->maturityYearmon / 100, data->maturityYearmon % 100, data->maturityDay);
+        expiry.expiryTime = expiry.maturityDay * SECONDS_IN_DAY - _utcOffset + _expiryTimeOfDay;
+      }
+
+      _expiries.push_back(expiry);
+      if (_day >= 0)
+        refreshExpiry(_expiries.back(), _day * SECONDS_IN_DAY - _utcOffset + _secondsOfDay);
+      return _expiries.size() - 1;
+    }
+
+    void TradingCalendar::update(int64_t timestamp)
+    {
+      const int64_t now = floorDiv(timestamp, 1000000000LL);
+      const int64_t localTime = now + _utcOffset;
+      const int64_t day = floorDiv(localTime, SECONDS_IN_DAY);
+      _secondsOfDay = (int32_t)(localTime - day * SECONDS_IN_DAY);
+      if (day != _day)
+      {
+        _day = day;
+        onDayChange();
+      }
+
+      if (!_session.isTradingDay() || _secondsOfDay < _session.preOpenStart || _secondsOfDay >= _session.closingEnd)
+        _sessionPhase = SessionPhase_CLOSED;
+      else if (_secondsOfDay < _session.preOpenEnd)
+        _sessionPhase = SessionPhase_PRE_OPEN;
+      else if (_secondsOfDay < _session.normalStart)
+        _sessionPhase = SessionPhase_CLOSED;
+      else if (_secondsOfDay < _session.normalEnd)
+        _sessionPhase = SessionPhase_NORMAL;
+      else
+        _sessionPhase = SessionPhase_CLOSING;
+
+      for (size_t i = 0; i < _expiries.size(); ++i)
+        refreshExpiry(_expiries[i], now);
+    }
+
+    void TradingCalendar::onDayChange()
+    {
+      std::map<int64_t, SessionTimes>::const_iterator it = _specialSessions.find(_day);
+      if (it != _specialSessions.end())
+        _session = it->second;
+      else
+        _session = _weekdaySessions[((_day + 4) % 7 + 7) % 7]; // 1970-01-01 was a Thursday
+    }
+
+    void TradingCalendar::refreshExpiry(Expiry &expiry, int64_t now) const
+    {
+      if (expiry.maturityDay < 0)
+        return;
+
+      expiry.isExpiryDay = expiry.maturityDay == _day;
+
+      // day granular value, kept identical to SharedUtilities::getTimeToExpireInYears
+      double day = 0;
+      switch (expiry.expiryDayType)
+      {
+      case API2::CONSTANTS::CMD_ExpiryDay_INCLUDE_ON_EXPIRY:
+        day = expiry.isExpiryDay ? 24 * 60 * 60 : 0;
+        break;
+      case API2::CONSTANTS::CMD_ExpiryDay_INCLUDE:
+        day = 24 * 60 * 60;
+        break;
+      case API2::CONSTANTS::CMD_ExpiryDay_HALF_INCLUDE:
+        day = 12 * 60 * 60;
+        break;
+      default:
+        day = 0;
+        break;
+      }
+      expiry.timeToExpireInYears = ((double)(expiry.maturityDay - _day) * SECONDS_IN_DAY + day) / SECONDS_IN_YEAR;
+
+      int64_t remaining = expiry.expiryTime - now;
+      expiry.fractionalTimeToExpire = remaining > 0 ? remaining / SECONDS_IN_YEAR : 0;
+      expiry.isPastExpiryCutoff = expiry.maturityDay < _day || (expiry.isExpiryDay && _secondsOfDay >= _session.expiryCutoff);
+    }
+  }
+}
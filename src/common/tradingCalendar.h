@@ -0,0 +1,162 @@
+#ifndef API2_TRADING_CALENDAR_H
+#define API2_TRADING_CALENDAR_H
+
+/**
+ * Trading calendar with cached time to expiry.
+ * Expiry of every registered instrument is converted to an epoch once, session phase and time to expiry of
+ * all instruments are refreshed by a single update() per timer tick, readers only load cached values.
+ * Replaces per call SharedUtilities::getTimeToExpireInYears (time/localtime/mktime) and time zone lookups.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+#include <sgContext.h>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    class TradingCalendar
+    {
+    public:
+      static const int32_t IST_UTC_OFFSET = 19800;
+      static const int32_t SECONDS_IN_DAY = 86400;
+
+      /**
+       * @brief SessionPhase
+       */
+      enum SessionPhase
+      {
+        SessionPhase_CLOSED = 0,
+        SessionPhase_PRE_OPEN,
+        SessionPhase_NORMAL,
+        SessionPhase_CLOSING,
+        SessionPhase_MAX,
+      };
+
+      /**
+       * @brief session of a day, all values are seconds from local midnight. Default constructed value is a holiday
+       */
+      struct SessionTimes
+      {
+        int32_t preOpenStart;
+        int32_t preOpenEnd;
+        int32_t normalStart;
+        int32_t normalEnd;
+        int32_t closingEnd;
+        int32_t expiryCutoff; // on expiry day, instruments expiring today are past cutoff after this time
+
+        SessionTimes() : preOpenStart(0), preOpenEnd(0), normalStart(0), normalEnd(0), closingEnd(0), expiryCutoff(0) {}
+        SessionTimes(int32_t preOpenStart_, int32_t preOpenEnd_, int32_t normalStart_, int32_t normalEnd_, int32_t closingEnd_, int32_t expiryCutoff_)
+            : preOpenStart(preOpenStart_), preOpenEnd(preOpenEnd_), normalStart(normalStart_), normalEnd(normalEnd_), closingEnd(closingEnd_), expiryCutoff(expiryCutoff_) {}
+
+        bool isTradingDay() const { return normalEnd > normalStart; }
+      };
+
+      /**
+       * @brief NSE equity derivatives session: pre-open 09:00-09:08, normal 09:15-15:30, closing till 16:00
+       */
+      static SessionTimes getNseSession() { return SessionTimes(9 * 3600, 9 * 3600 + 8 * 60, 9 * 3600 + 15 * 60, 15 * 3600 + 30 * 60, 16 * 3600, 15 * 3600 + 30 * 60); }
+
+    private:
+      struct Expiry
+      {
+        int64_t maturityDay; // days since epoch in local time, -1 for non expiring instrument
+        int64_t expiryTime;  // epoch seconds of contract expiry
+        API2::DATA_TYPES::EXPIRYDAY_TYPE expiryDayType;
+        double timeToExpireInYears;
+        double fractionalTimeToExpire;
+        bool isExpiryDay;
+        bool isPastExpiryCutoff;
+      };
+
+      std::vector<Expiry> _expiries;
+      SessionTimes _weekdaySessions[7]; // 0 is Sunday
+      std::map<int64_t, SessionTimes> _specialSessions; // keyed by local day since epoch
+      int32_t _utcOffset;
+      int32_t _expiryTimeOfDay;
+
+      // refreshed by update
+      int64_t _day;
+      int32_t _secondsOfDay;
+      SessionTimes _session;
+      SessionPhase _sessionPhase;
+
+      void onDayChange();
+      void refreshExpiry(Expiry &expiry, int64_t now) const;
+
+    public:
+      /**
+       * @brief TradingCalendar, weekdays get NSE session and weekends are holidays
+       * @param utcOffset - seconds east of UTC of exchange local time, no DST handling as Indian exchanges have none
+       */
+      explicit TradingCalendar(int32_t utcOffset = IST_UTC_OFFSET);
+
+      /**
+       * @brief days since epoch of a civil date
+       */
+      static int64_t daysFromCivil(int32_t year, uint32_t month, uint32_t day);
+
+      /**
+       * @brief set session of a day of week
+       * @param weekday - 0 Sunday to 6 Saturday
+       * @param session
+       */
+      void setWeekdaySession(int weekday, const SessionTimes &session);
+
+      /**
+       * @brief override session of a date e.g. holiday (SessionTimes()) or special session
+       * @param yyyymmdd - date in exchange local time
+       * @param session
+       */
+      void setSpecialSession(int32_t yyyymmdd, const SessionTimes &session);
+
+      /**
+       * @brief time of day contracts expire at, used for fractional time to expiry. Set before registering instruments
+       * @param secondsOfDay - default 15:30
+       */
+      void setExpiryTimeOfDay(int32_t secondsOfDay) { _expiryTimeOfDay = secondsOfDay; }
+
+      /**
+       * @brief register an instrument, expiry epoch is computed once here
+       * @param data - static data of instrument, common stock or NULL never expires
+       * @param expiryDayType - same meaning as in SharedUtilities::getTimeToExpireInYears
+       * @return index used with the getters
+       */
+      size_t registerInstrument(const API2::SymbolStaticData *data,
+                                const API2::DATA_TYPES::EXPIRYDAY_TYPE expiryDayType = API2::CONSTANTS::CMD_ExpiryDay_EXCLUDE);
+
+      /**
+       * @brief refresh session phase and time to expiry of all instruments, call once per timer tick
+       * @param timestamp - epoch nanoseconds e.g. wsc::Time::getTimestamp()
+       */
+      void update(int64_t timestamp);
+
+      SessionPhase getSessionPhase() const { return _sessionPhase; }
+      bool isTradingDay() const { return _session.isTradingDay(); }
+      bool isNormalMarket() const { return _sessionPhase == SessionPhase_NORMAL; }
+      int32_t getSecondsOfDay() const { return _secondsOfDay; }
+      const SessionTimes &getSession() const { return _session; }
+
+      /**
+       * @brief day granular time to expiry, same value as SharedUtilities::getTimeToExpireInYears
+       */
+      double getTimeToExpireInYears(size_t index) const { return _expiries[index].timeToExpireInYears; }
+
+      /**
+       * @brief time to expiry from last update till expiry time of day of maturity date, in years
+       */
+      double getFractionalTimeToExpire(size_t index) const { return _expiries[index].fractionalTimeToExpire; }
+
+      bool isExpiryDay(size_t index) const { return _expiries[index].isExpiryDay; }
+      bool isPastExpiryCutoff(size_t index) const { return _expiries[index].isPastExpiryCutoff; }
+      int64_t getExpiryTime(size_t index) const { return _expiries[index].expiryTime; }
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,253 @@
+/**
+ * Implied volatility surface of one underlying, built off the strategy thread.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include "volatilitySurface.h"
+#include <math.h>
+#include <string.h>
+#include <string>
+
+namespace API2
+{
+  namespace COMMON
+  {
+    double VolatilitySurface::Smile::getIv(double strike) const
+    {
+      if (forward <= 0 || strike <= 0)
+        return a;
+      double x = log(strike / forward);
+      return a + (b + c * x) * x;
+    }
+
+    double VolatilitySurface::Smile::getPrice(bool isCall, double strike) const
+    {
+      if (nodeCount == 0 || forward <= 0 || strike <= 0 || timeToExpire <= 0)
+        return 0;
+      double iv = getIv(strike);
+      if (!(iv > 0))
+        return 0;
+      double deviation = iv * sqrt(timeToExpire);
+      double d1 = log(forward / strike) / deviation + 0.5 * deviation;
+      double d2 = d1 - deviation;
+      // N(x) = erfc(-x / sqrt(2)) / 2
+      if (isCall)
+        return discount * 0.5 * (forward * erfc(-d1 * M_SQRT1_2) - strike * erfc(-d2 * M_SQRT1_2));
+      return discount * 0.5 * (strike * erfc(d2 * M_SQRT1_2) - forward * erfc(d1 * M_SQRT1_2));
+    }
+
+    VolatilitySurface::VolatilitySurface(double interestRate, double dividend, const ThreadPlacement &placement)
+        : _interestRate(interestRate),
+          _dividend(dividend),
+          _placement(placement),
+          _spot(0),
+          _sequence(0),
+          _isRunning(false),
+          _fittedSpot(0)
+    {
+      memset(&_snapshot, 0, sizeof(_snapshot));
+      memset(&_working, 0, sizeof(_working));
+    }
+
+    VolatilitySurface::~VolatilitySurface()
+    {
+      stop();
+    }
+
+    size_t VolatilitySurface::addExpiry(double timeToExpire)
+    {
+      if (_expiries.size() >= MAX_EXPIRIES)
+        throw std::string("VolatilitySurface: too many expiries");
+      Expiry expiry;
+      expiry.fittedVersion = 0;
+      expiry.fittedTimeToExpire = timeToExpire;
+      _expiries.push_back(expiry);
+      return _expiries.size() - 1;
+    }
+
+    size_t VolatilitySurface::addOption(size_t expiry, bool isCall, double strike)
+    {
+      Expiry &target = _expiries.at(expiry);
+      Node node;
+      node.expiry = expiry;
+      node.chainIndex = target.chain.addOption(isCall, strike, target.fittedTimeToExpire);
+      target.nodes.push_back(_nodes.size());
+      _nodes.push_back(node);
+      return _nodes.size() - 1;
+    }
+
+    bool VolatilitySurface::start()
+    {
+      if (_isRunning.load() || _expiries.empty())
+        return false;
+
+      _optionPrices.reset(new std::atomic<double>[_nodes.size()]);
+      for (size_t i = 0; i < _nodes.size(); ++i)
+        _optionPrices[i].store(0);
+      _expiryVersions.reset(new std::atomic<uint32_t>[_expiries.size()]);
+      _timeToExpire.reset(new std::atomic<double>[_expiries.size()]);
+      for (size_t i = 0; i < _expiries.size(); ++i)
+      {
+        _expiryVersions[i].store(0);
+        _timeToExpire[i].store(_expiries[i].fittedTimeToExpire);
+      }
+
+      _isRunning.store(true);
+      _worker = std::thread(&VolatilitySurface::run, this);
+      _placementError.clear();
+      _placement.apply(_worker.native_handle(), _placementError);
+      return true;
+    }
+
+    void VolatilitySurface::stop()
+    {
+      _isRunning.store(false);
+      if (_worker.joinable())
+        _worker.join();
+    }
+
+    bool VolatilitySurface::getSnapshot(Snapshot &snapshot) const
+    {
+      for (;;)
+      {
+        uint64_t begin = _sequence.load(std::memory_order_acquire);
+        if (begin & 1)
+        {
+#if defined(__x86_64__) || defined(__i386__)
+          __builtin_ia32_pause();
+#endif
+          continue;
+        }
+        memcpy(&snapshot, &_snapshot, sizeof(snapshot));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_sequence.load(std::memory_order_relaxed) == begin)
+          return begin != 0;
+      }
+    }
+
+    void VolatilitySurface::run()
+    {
+      while (_isRunning.load(std::memory_order_relaxed))
+      {
+        if (!refresh())
+          _placement.idle();
+      }
+    }
+
+    bool VolatilitySurface::refresh()
+    {
+      double spot = _spot.load(std::memory_order_acquire);
+      if (spot <= 0)
+        return false;
+
+      // spot moves every node, otherwise only expiries with new prices or time are re-solved
+      bool isSpotChanged = spot != _fittedSpot;
+      bool isChanged = false;
+      for (size_t e = 0; e < _expiries.size(); ++e)
+      {
+        Expiry &expiry = _expiries[e];
+        uint32_t version = _expiryVersions[e].load(std::memory_order_acquire);
+        double timeToExpire = _timeToExpire[e].load(std::memory_order_acquire);
+        if (!isSpotChanged && version == expiry.fittedVersion && timeToExpire == expiry.fittedTimeToExpire)
+          continue;
+
+        for (size_t i = 0; i < expiry.nodes.size(); ++i)
+        {
+          const Node &node = _nodes[expiry.nodes[i]];
+          expiry.chain.setOptionPrice(node.chainIndex, _optionPrices[expiry.nodes[i]].load(std::memory_order_relaxed));
+          expiry.chain.setTimeToExpire(node.chainIndex, timeToExpire);
+        }
+        expiry.chain.compute(spot, _interestRate, _dividend);
+        expiry.fittedVersion = version;
+        expiry.fittedTimeToExpire = timeToExpire;
+
+        fitSmile(expiry, spot, _working.smiles[e]);
+        isChanged = true;
+      }
+      _fittedSpot = spot;
+
+      if (isChanged)
+        publish(spot);
+      return isChanged;
+    }
+
+    void VolatilitySurface::fitSmile(const Expiry &expiry, double spot, Smile &fitted) const
+    {
+      fitted.timeToExpire = expiry.fittedTimeToExpire;
+      fitted.forward = spot * exp((_interestRate - _dividend) * expiry.fittedTimeToExpire);
+      fitted.discount = exp(-_interestRate * expiry.fittedTimeToExpire);
+
+      // vega weighted least squares of iv over x = ln(K / F), normal equations of a + b x + c x^2
+      double s[5] = {0, 0, 0, 0, 0}; // sum w x^n
+      double t[3] = {0, 0, 0};       // sum w iv x^n
+      uint32_t nodeCount = 0;
+      const OptionChainGreeks &chain = expiry.chain;
+      for (size_t i = 0; i < chain.size(); ++i)
+      {
+        if (chain.getStatus(i) != OptionChainGreeks::IvStatus_OK)
+          continue;
+        double w = chain.getVega(i);
+        if (!(w > 0))
+          continue;
+        double x = log(chain.getStrike(i) / fitted.forward);
+        double iv = chain.getIv(i);
+        double xn = w;
+        for (int n = 0; n < 5; ++n)
+        {
+          s[n] += xn;
+          if (n < 3)
+            t[n] += xn * iv;
+          xn *= x;
+        }
+        ++nodeCount;
+      }
+      fitted.nodeCount = nodeCount;
+      // no solved option, a smile of an older pass must not be priced off
+      if (nodeCount == 0)
+      {
+        fitted.a = fitted.b = fitted.c = fitted.rmse = 0;
+        return;
+      }
+
+      double a = t[0] / s[0], b = 0, c = 0;
+      double det = s[0] * (s[2] * s[4] - s[3] * s[3]) - s[1] * (s[1] * s[4] - s[3] * s[2]) + s[2] * (s[1] * s[3] - s[2] * s[2]);
+      if (nodeCount >= 3 && fabs(det) > 1e-12 * s[0] * s[0] * s[0])
+      {
+        // Cramer's rule
+        a = (t[0] * (s[2] * s[4] - s[3] * s[3]) - s[1] * (t[1] * s[4] - s[3] * t[2]) + s[2] * (t[1] * s[3] - s[2] * t[2])) / det;
+        b = (s[0] * (t[1] * s[4] - s[3] * t[2]) - t[0] * (s[1] * s[4] - s[3] * s[2]) + s[2] * (s[1] * t[2] - t[1] * s[2])) / det;
+        c = (s[0] * (s[2] * t[2] - t[1] * s[3]) - s[1] * (s[1] * t[2] - t[1] * s[2]) + t[0] * (s[1] * s[3] - s[2] * s[2])) / det;
+      }
+
+      double sumSquares = 0;
+      for (size_t i = 0; i < chain.size(); ++i)
+      {
+        if (chain.getStatus(i) != OptionChainGreeks::IvStatus_OK || !(chain.getVega(i) > 0))
+          continue;
+        double x = log(chain.getStrike(i) / fitted.forward);
+        double error = chain.getIv(i) - (a + (b + c * x) * x);
+        sumSquares += chain.getVega(i) * error * error;
+      }
+
+      fitted.a = a;
+      fitted.b = b;
+      fitted.c = c;
+      fitted.rmse = sqrt(sumSquares / s[0]);
+      ++fitted.fitCount;
+    }
+
+    void VolatilitySurface::publish(double spot)
+    {
+      uint64_t sequence = _sequence.load(std::memory_order_relaxed);
+      _sequence.store(sequence + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      _working.version = sequence / 2 + 1;
+      _working.spot = spot;
+      _working.expiryCount = _expiries.size();
+      memcpy(&_snapshot, &_working, sizeof(_snapshot));
+      _sequence.store(sequence + 2, std::memory_order_release);
+    }
+  }
+}
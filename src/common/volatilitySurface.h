@@ -0,0 +1,194 @@
+#ifndef API2_VOLATILITY_SURFACE_H
+#define API2_VOLATILITY_SURFACE_H
+
+/**
+ * Implied volatility surface of one underlying, built off the strategy thread.
+ * Strategy thread only stores the latest spot / option prices (atomic stores, no locks, no fit). A worker thread,
+ * placed by a ThreadPlacement, re-solves IV of the expiries touched since its last pass with
+ * OptionChainGreeks (warm started), fits a quadratic smile per expiry and publishes a snapshot through a seqlock.
+ * Quoting logic copies the latest consistent snapshot with getSnapshot() and prices off the fitted smile (Smile::getPrice).
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "optionChainGreeks.h"
+#include "threadPlacement.h"
+
+namespace API2
+{
+  namespace COMMON
+  {
+    class VolatilitySurface
+    {
+    public:
+      static const size_t MAX_EXPIRIES = 8;
+
+      /**
+       * @brief smile of one expiry, iv = a + b * x + c * x * x where x = ln(strike / forward)
+       */
+      struct Smile
+      {
+        double timeToExpire;
+        double forward;
+        double discount; // exp(-interestRate * timeToExpire)
+        double a;
+        double b;
+        double c;
+        double rmse; // vega weighted fit error in IV
+        uint32_t nodeCount; // options used in the fit
+        uint32_t fitCount;  // number of fits of this expiry so far
+
+        double getIv(double strike) const;
+
+        /**
+         * @brief Black-Scholes price on the forward with IV of the smile at strike, 0 if the expiry has no fit
+         */
+        double getPrice(bool isCall, double strike) const;
+      };
+
+      /**
+       * @brief trivially copyable surface snapshot
+       */
+      struct Snapshot
+      {
+        uint64_t version;
+        double spot;
+        size_t expiryCount;
+        Smile smiles[MAX_EXPIRIES];
+      };
+
+    private:
+      struct Node
+      {
+        size_t expiry;
+        size_t chainIndex;
+      };
+
+      struct Expiry
+      {
+        OptionChainGreeks chain;
+        std::vector<size_t> nodes;
+        uint32_t fittedVersion;
+        double fittedTimeToExpire;
+      };
+
+      // configuration, fixed after start
+      std::vector<Node> _nodes;
+      std::vector<Expiry> _expiries;
+      double _interestRate;
+      double _dividend;
+      ThreadPlacement _placement;
+      std::string _placementError;
+
+      // written by strategy thread
+      std::unique_ptr<std::atomic<double>[]> _optionPrices;
+      std::unique_ptr<std::atomic<uint32_t>[]> _expiryVersions;
+      std::unique_ptr<std::atomic<double>[]> _timeToExpire;
+      std::atomic<double> _spot;
+
+      // published by worker thread
+      alignas(64) std::atomic<uint64_t> _sequence;
+      Snapshot _snapshot;
+
+      // worker thread only
+      alignas(64) Snapshot _working;
+
+      std::atomic<bool> _isRunning;
+      std::thread _worker;
+      double _fittedSpot;
+
+      void run();
+      bool refresh();
+      void fitSmile(const Expiry &expiry, double spot, Smile &fitted) const;
+      void publish(double spot);
+
+      VolatilitySurface(const VolatilitySurface &) = delete;
+      VolatilitySurface &operator=(const VolatilitySurface &) = delete;
+
+    public:
+      // snapshots and sequence are cache line aligned, which plain new does not honour before C++17
+      static void *operator new(size_t size)
+      {
+        void *memory = NULL;
+        if (posix_memalign(&memory, alignof(VolatilitySurface), size) != 0)
+          throw std::bad_alloc();
+        return memory;
+      }
+      static void operator delete(void *memory) { free(memory); }
+
+      /**
+       * @brief VolatilitySurface
+       * @param interestRate - decimal
+       * @param dividend - decimal
+       * @param placement - cpu affinity, priority and idle policy of the worker
+       */
+      VolatilitySurface(double interestRate, double dividend, const ThreadPlacement &placement = ThreadPlacement("IvSurface"));
+
+      /**
+       * @brief stops the worker
+       */
+      ~VolatilitySurface();
+
+      /**
+       * @brief add an expiry, only before start
+       * @return expiry index, smiles of snapshot are in the same order
+       */
+      size_t addExpiry(double timeToExpire);
+
+      /**
+       * @brief add an option of an expiry, only before start
+       * @param expiry - index returned by addExpiry
+       * @param isCall
+       * @param strike - same unit as spot and option prices
+       * @return node index used with onOptionTick
+       */
+      size_t addOption(size_t expiry, bool isCall, double strike);
+
+      /**
+       * @brief start the worker thread
+       * @return false if already running or no expiry added. Worker still runs if placement fails, see getPlacementError
+       */
+      bool start();
+
+      const std::string &getPlacementError() const { return _placementError; }
+
+      void stop();
+
+      /**
+       * @brief strategy thread, latest underlying price
+       */
+      void onUnderlyingTick(double spot) { _spot.store(spot, std::memory_order_release); }
+
+      /**
+       * @brief strategy thread, latest option price (e.g. mid) of a node, 0 marks price as unavailable
+       */
+      void onOptionTick(size_t node, double optionPrice)
+      {
+        _optionPrices[node].store(optionPrice, std::memory_order_relaxed);
+        _expiryVersions[_nodes[node].expiry].fetch_add(1, std::memory_order_release);
+      }
+
+      /**
+       * @brief strategy thread, e.g. from TradingCalendar::getFractionalTimeToExpire on timer tick
+       */
+      void setTimeToExpire(size_t expiry, double timeToExpire) { _timeToExpire[expiry].store(timeToExpire, std::memory_order_release); }
+
+      /**
+       * @brief copy latest consistent snapshot, never blocks the worker
+       * @return false if nothing published yet
+       */
+      bool getSnapshot(Snapshot &snapshot) const;
+    };
+  }
+}
+
+#endif
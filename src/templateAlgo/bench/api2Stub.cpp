@@ -0,0 +1,285 @@
+/**
+ * In process stand in for the API2 runtime used by templateAlgo_bench.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include "api2Stub.h"
+#include <api2Exceptions.h>
+#include <api2UserCommands.h>
+#include <orderWrapperAPI.h>
+#include <sgDebugLogDefines.h>
+#include <sharedResponse.h>
+#include <string.h>
+
+namespace Api2Stub
+{
+    namespace
+    {
+        // objects handed out to strategy code, stub methods never touch their members
+        alignas(64) char instrumentStorage[sizeof(API2::COMMON::Instrument)];
+        alignas(64) char mktDataStorage[sizeof(API2::COMMON::MktData)];
+        alignas(64) char positionStorage[sizeof(API2::COMMON::InstrumentPosition)];
+
+        API2::COMMON::Instrument *instrument() { return reinterpret_cast<API2::COMMON::Instrument *>(instrumentStorage); }
+        API2::COMMON::MktData *mktData() { return reinterpret_cast<API2::COMMON::MktData *>(mktDataStorage); }
+        API2::COMMON::InstrumentPosition *position() { return reinterpret_cast<API2::COMMON::InstrumentPosition *>(positionStorage); }
+
+        API2::DebugLog &debugLog()
+        {
+            static API2::DebugLog log;
+            return log;
+        }
+    }
+
+    Market &market()
+    {
+        static Market market = Market();
+        return market;
+    }
+
+    API2::SymbolStaticData &staticData()
+    {
+        static API2::SymbolStaticData data;
+        static bool isInitialized = false;
+        if (!isInitialized)
+        {
+            isInitialized = true;
+            data.scripName = "BANKNIFTY-STUB";
+            data.marketLot = 25;
+            data.tickSize = 5;
+            data.scripPrecision = 2;
+            data.lowerBandPrice = 3150000;
+            data.upperBandPrice = 3850000;
+            data.lowTradeExecutionRange = 0;
+            data.highTradeExecutionRange = 0;
+            data.freezeQuantity = 1800;
+            data.maturityYearmon = 0;
+            data.maturityDay = 0;
+        }
+        return data;
+    }
+
+    void setBook(long mid, long tickSize, long qty, int64_t timestamp)
+    {
+        Market &m = market();
+        m.timestamp = timestamp;
+        for (int i = 0; i < BOOK_LEVELS; ++i)
+        {
+            m.bidPrice[i] = mid - (i + 1) * tickSize;
+            m.askPrice[i] = mid + (i + 1) * tickSize;
+            m.bidQty[i] = qty * (i + 1);
+            m.askQty[i] = qty * (i + 1);
+        }
+    }
+
+    OrderCounters &orderCounters()
+    {
+        static OrderCounters counters = OrderCounters();
+        return counters;
+    }
+}
+
+namespace API2
+{
+    /* ---------------------------------------------Static data / account --------------------------------------------------*/
+
+    SymbolStaticData::SymbolStaticData() {}
+
+    short getExchangeId(const long &symbolId) { return 0; }
+
+    AccountDetail::AccountDetail() { memset(_primaryClientCode, 0, sizeof(_primaryClientCode)); _TraderId = 0; _LocationId = 0; _AccountType = 0; }
+    std::string AccountDetail::getString() const { return _primaryClientCode; }
+    std::string AccountDetail::getString() { return _primaryClientCode; }
+    void AccountDetail::setPrimaryClientCode(const char *code) { strncpy(_primaryClientCode, code, sizeof(_primaryClientCode) - 1); }
+    void AccountDetail::setAccountType(char type) { _AccountType = type; }
+    void AccountDetail::setLocationId(UNSIGNED_LONG locationId) { _LocationId = locationId; }
+    void AccountDetail::setTraderId(SIGNED_LONG traderId) { _TraderId = traderId; }
+
+    void *StrategyParameters::getInfo() { return _info; }
+
+    /* ---------------------------------------------Debug log --------------------------------------------------*/
+
+    AbstractSingle::AbstractSingle() {}
+    std::string AbstractSingle::getString() { return ""; }
+
+    Logs::Logs() : _printDepth(false), _flushLogs(false), _active(false), _printOnExit(false), _file(NULL),
+                   _useLocksWhilePoppingLogsAndFileDumping(false), _spinLockForFileLogging(0), _spinLock(0), _logVector(&_logVector1) {}
+    void Logs::takeLock() {}
+    void Logs::releaseLock() {}
+    void Logs::push(const char *, const char *) {}
+
+    // silent, benchmarks measure strategy code not log file I/O
+    DebugLog::DebugLog() : _useBufferedLogs(false), _silentMode(true) {}
+    DebugLog::~DebugLog() {}
+    void DebugLog::timeStamp() {}
+    void DebugLog::message(const char *) {}
+    void DebugLog::message(const std::string &) {}
+    void DebugLog::flushLog(bool) {}
+    void DebugLog::saveConfirmation(const API2::OrderConfirmation &) {}
+
+    const char *MarketDataSubscriptionFailedException::what() const throw() { return "market data subscription failed"; }
+    const char *InstrumentNotFoundException::what() const throw() { return "instrument not found"; }
+
+    /* ---------------------------------------------Confirmations --------------------------------------------------*/
+
+    ExchangeAdapterDetails::ExchangeAdapterDetails() {}
+    ExchangeAdapterDetails::~ExchangeAdapterDetails() {}
+
+    OrderConfirmation::OrderConfirmation() : _clOrderId(0), _symbolId(0), _lastFillQuantity(0), _lastFillPrice(0), _origLastFillPrice(0),
+                                             _orderStatus(0), _orderMode(0), _orderQuantity(0), _orderPrice(0), _origOrderPrice(0), _errorCode(0)
+    {
+        _exchangeOrderId[0] = 0;
+    }
+    OrderConfirmation::~OrderConfirmation() {}
+    DATA_TYPES::CLORDER_ID OrderConfirmation::getClOrderId() const { return _clOrderId; }
+    DATA_TYPES::SYMBOL_ID OrderConfirmation::getSymbolId() const { return _symbolId; }
+    DATA_TYPES::QTY OrderConfirmation::getLastFillQuantity() const { return _lastFillQuantity; }
+    DATA_TYPES::PRICE OrderConfirmation::getLastFillPrice() const { return _lastFillPrice; }
+    DATA_TYPES::PRICE OrderConfirmation::getOrigLastFillPrice() const { return _origLastFillPrice; }
+    DATA_TYPES::PRICE OrderConfirmation::getOrigOrderPrice() const { return _origOrderPrice; }
+    DATA_TYPES::PRICE OrderConfirmation::getOrderPrice() const { return _orderPrice; }
+    DATA_TYPES::QTY OrderConfirmation::getOrderQuantity() const { return _orderQuantity; }
+    DATA_TYPES::OrderStatus OrderConfirmation::getOrderStatus() const { return _orderStatus; }
+    DATA_TYPES::OrderMode OrderConfirmation::getOrderMode() const { return _orderMode; }
+    TYPE_DEFS::OrderType OrderConfirmation::getOrderType() const { return _orderType; }
+    const char *OrderConfirmation::getExchangeOrderIdCharPtr() const { return _exchangeOrderId; }
+    TYPE_DEFS::ERROR_CODE OrderConfirmation::getErrorCode() const { return _errorCode; }
+
+    /* ---------------------------------------------Orders --------------------------------------------------*/
+
+    // stub keeps no order book, reqQryOrder finds nothing so a warm restart finds no order of previous run
+    DATA_TYPES::CLORDER_ID SingleOrder::getClOrdId() const { return _clOrdId; }
+    DATA_TYPES::SYMBOL_ID SingleOrder::getSymbolId() const { return _symbolId; }
+    DATA_TYPES::QTY SingleOrder::getQuantity() const { return _quantity; }
+    DATA_TYPES::QTY SingleOrder::getFilledQuantity() const { return _filledQuantity; }
+    DATA_TYPES::PRICE SingleOrder::getPrice() const { return _price; }
+    DATA_TYPES::OrderMode SingleOrder::getOrderMode() const { return _orderMode; }
+    DATA_TYPES::OrderStatus SingleOrder::getOrderStatus() const { return _orderStatus; }
+    const char *SingleOrder::getExchangeOrderId() const { return _exchangeOrderId; }
+
+    /* ---------------------------------------------Instrument / market data --------------------------------------------------*/
+
+    namespace COMMON
+    {
+        SymbolStaticData *Instrument::getStaticData() { return &Api2Stub::staticData(); }
+        SYMBOL_ID Instrument::getSymbolId() { return Api2Stub::market().symbolId; }
+        InstrumentPosition *Instrument::getPosition() { return Api2Stub::position(); }
+
+        SIGNED_LONG InstrumentPosition::getTradedQty(const DATA_TYPES::OrderMode &mode)
+        {
+            return mode == CONSTANTS::CMD_OrderMode_BUY ? Api2Stub::market().buyTradedQty : Api2Stub::market().sellTradedQty;
+        }
+        UNSIGNED_LONG InstrumentPosition::getAmount(const DATA_TYPES::OrderMode mode)
+        {
+            return mode == CONSTANTS::CMD_OrderMode_BUY ? Api2Stub::market().buyTradedValue : Api2Stub::market().sellTradedValue;
+        }
+
+        DATA_TYPES::PRICE MktData::getBidPrice(size_t level) { return Api2Stub::market().bidPrice[level]; }
+        DATA_TYPES::PRICE MktData::getAskPrice(size_t level) { return Api2Stub::market().askPrice[level]; }
+        DATA_TYPES::QTY MktData::getBidQty(size_t level) { return Api2Stub::market().bidQty[level]; }
+        DATA_TYPES::QTY MktData::getAskQty(size_t level) { return Api2Stub::market().askQty[level]; }
+        DATA_TYPES::PRICE MktData::getPrice(size_t level, const DATA_TYPES::OrderMode &mode)
+        {
+            return mode == CONSTANTS::CMD_OrderMode_BUY ? getBidPrice(level) : getAskPrice(level);
+        }
+        DATA_TYPES::QTY MktData::getQty(size_t level, const DATA_TYPES::OrderMode &mode)
+        {
+            return mode == CONSTANTS::CMD_OrderMode_BUY ? getBidQty(level) : getAskQty(level);
+        }
+        DATA_TYPES::NanoSecondTimeStamp MktData::getTimeStamp() { return Api2Stub::market().timestamp; }
+        // one update per timestamp in the stub
+        UNSIGNED_LONG MktData::getLatestIndexCounter() { return Api2Stub::market().timestamp; }
+
+        /* ---------------------------------------------Order wrapper --------------------------------------------------*/
+
+        // every request is acknowledged at once, so the wrapper is always in a steady state
+        void OrderWrapperAPI::reset()
+        {
+            _isReset = true;
+            _isPendingNew = _isPendingReplace = _isPendingCancel = false;
+            _price = _lastQuantity = _lastQuotedPrice = _lastFilledQuantity = 0;
+        }
+
+        bool OrderWrapperAPI::newOrder(DATA_TYPES::RiskStatus &risk, const DATA_TYPES::PRICE &price, const DATA_TYPES::QTY &qty, DATA_TYPES::PRICE)
+        {
+            ++Api2Stub::orderCounters().newOrders;
+            risk = CONSTANTS::RSP_RiskStatus_SUCCESS;
+            _isReset = false;
+            _price = _lastQuotedPrice = price;
+            _lastQuantity = qty;
+            _lastFilledQuantity = 0;
+            return true;
+        }
+
+        bool OrderWrapperAPI::replaceOrder(DATA_TYPES::RiskStatus &risk, const DATA_TYPES::PRICE &price, const DATA_TYPES::QTY &qty, DATA_TYPES::PRICE)
+        {
+            ++Api2Stub::orderCounters().replaceOrders;
+            risk = CONSTANTS::RSP_RiskStatus_SUCCESS;
+            _price = _lastQuotedPrice = price;
+            _lastQuantity = qty;
+            return true;
+        }
+
+        bool OrderWrapperAPI::cancelOrder(DATA_TYPES::RiskStatus &risk)
+        {
+            ++Api2Stub::orderCounters().cancelOrders;
+            risk = CONSTANTS::RSP_RiskStatus_SUCCESS;
+            reset();
+            return true;
+        }
+
+        bool OrderWrapperAPI::processConfirmation(API2::OrderConfirmation &) { return true; }
+    }
+
+    /* ---------------------------------------------Strategy context --------------------------------------------------*/
+
+    SGContext::SGContext(StrategyParameters *, const std::string &, bool) : pimpl(NULL) {}
+    SGContext::~SGContext() {}
+    void SGContext::registerStrategy(boost::shared_ptr<SGContext>) {}
+
+    COMMON::Instrument *SGContext::createNewInstrument(SYMBOL_ID symbolId, bool, bool, bool, bool, size_t)
+    {
+        Api2Stub::market().symbolId = symbolId;
+        return Api2Stub::instrument();
+    }
+    DATA_TYPES::SYMBOL_ID SGContext::reqQrySymbolID(std::string) { return 1; }
+    SingleOrder *SGContext::reqQryOrder(DATA_TYPES::CLORDER_ID) { return NULL; }
+    COMMON::MktData *SGContext::reqQryMarketData(SYMBOL_ID) { return Api2Stub::mktData(); }
+    COMMON::MktData *SGContext::reqQryUpdateMarketData(SYMBOL_ID) { return Api2Stub::mktData(); }
+    DebugLog *SGContext::reqQryDebugLog() { return &Api2Stub::debugLog(); }
+
+    void *SGContext::reqStartAlgo(bool, bool, bool, bool, bool) { return NULL; }
+    bool SGContext::reqTimerEvent(DATA_TYPES::TimerMicroSecondInterval) { return true; }
+    bool SGContext::reqCancelOrder(DATA_TYPES::RiskStatus &risk, COMMON::OrderId *, const bool)
+    {
+        ++Api2Stub::orderCounters().cancelOrders;
+        risk = CONSTANTS::RSP_RiskStatus_SUCCESS;
+        return true;
+    }
+    void SGContext::reqAddStrategyComment(DATA_TYPES::StrategyComment) {}
+    void SGContext::reqTerminateStrategy(bool) {}
+    void SGContext::reqTerminateSquareOffStrategy() {}
+    void SGContext::reqSendStrategyResponse(DATA_TYPES::ResponseType, DATA_TYPES::RiskStatus, DATA_TYPES::StrategyComment, DATA_TYPES::StrategyComment, const std::string &) {}
+    bool SGContext::reqQryTestSegment(const DATA_TYPES::ExchangeId &, const DATA_TYPES::SecurityType &) { return false; }
+    bool SGContext::isMandateSatisfiesGetFromStrategy() { return true; }
+
+    void SGContext::receiveCustomData(CustomDataPtr) {}
+    void SGContext::onPendingNewOrder(SingleOrder *) {}
+    void SGContext::onPendingReplaceOrder(SingleOrder *) {}
+    void SGContext::onPendingCancelOrder(SingleOrder *) {}
+    void SGContext::onCMDInternalMessage(const DATA_TYPES::CommandCategory &) {}
+    void SGContext::onCMDDisconnection(const DATA_TYPES::CommandCategory &) {}
+    void SGContext::onCMDReconnection(const DATA_TYPES::CommandCategory &) {}
+    void SGContext::onCMDTerminateStartegy() {}
+    void SGContext::onCMDDmsDisconnection() {}
+    void SGContext::onCMDTerminateSqOffStrategy() {}
+    void SGContext::onCMDPauseStartegy() {}
+    void SGContext::onCMDRunStrategy() {}
+    void SGContext::onDefaultEvent() {}
+    void SGContext::onMarketDataEvent(UNSIGNED_LONG) {}
+    void SGContext::onOhlcTimeOutEvent() {}
+    void SGContext::onTradeTickEvent(DATA_TYPES::SYMBOL_ID, COMMON::TradeTick) {}
+    void SGContext::onTradeTickEvent(DATA_TYPES::SYMBOL_ID) {}
+}
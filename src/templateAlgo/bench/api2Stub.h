@@ -0,0 +1,61 @@
+#ifndef API2_STUB_H
+#define API2_STUB_H
+
+/**
+ * In process stand in for the API2 runtime, only what templateAlgo_bench needs to drive Template.
+ * There is one instrument, its book / static data / position are plain memory set by the benchmark,
+ * order requests are acknowledged immediately and nothing is sent anywhere.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include <sgContext.h>
+#include <sgSymbolDataDefines.h>
+
+namespace Api2Stub
+{
+    static const int BOOK_LEVELS = 20;
+
+    struct Market
+    {
+        API2::DATA_TYPES::SYMBOL_ID symbolId;
+        int64_t timestamp;
+        long bidPrice[BOOK_LEVELS];
+        long bidQty[BOOK_LEVELS];
+        long askPrice[BOOK_LEVELS];
+        long askQty[BOOK_LEVELS];
+        long buyTradedQty;
+        long buyTradedValue;
+        long sellTradedQty;
+        long sellTradedValue;
+    };
+
+    /**
+     * @brief book and position of the stub instrument
+     */
+    Market &market();
+
+    /**
+     * @brief static data of the stub instrument, filled with NSE FO like defaults
+     */
+    API2::SymbolStaticData &staticData();
+
+    /**
+     * @brief build a book around mid with tickSize spaced levels
+     */
+    void setBook(long mid, long tickSize, long qty, int64_t timestamp);
+
+    /**
+     * @brief order requests seen by the stub since start
+     */
+    struct OrderCounters
+    {
+        uint64_t newOrders;
+        uint64_t replaceOrders;
+        uint64_t cancelOrders;
+    };
+    OrderCounters &orderCounters();
+}
+
+#endif
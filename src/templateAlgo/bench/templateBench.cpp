@@ -0,0 +1,806 @@
+/**
+ * templateAlgo_bench - microbenchmarks of the Template hot functions against the API2 stub.
+ *
+ * usage: templateAlgo_bench [--filter <substring>] [--min-time-ms <ms>] [--config <appConfig.ini>]
+ *                           [--out <results.json>] [--baseline <results.json>]
+ *                           [--replay <session.csv>|synthetic] [--replay-passes <n>]
+ *
+ * --replay feeds a recorded session through onMarketDataEvent and reports its duration per tick as replay/tickToOrder,
+ * orders are placed synchronously by the stub so that is the tick to order latency of the strategy code.
+ * Session rows are "timestamp_ns,bidPrice,bidQty,askPrice,askQty[,bidPrice,bidQty,askPrice,askQty ...]" best level first,
+ * lines starting with # are skipped. "synthetic" replays a seeded random walk instead of a file.
+ * Resting orders crossed by the replayed book are filled, so position dependent paths are exercised too.
+ * The replay is also the training run of the profile guided build, see pgoBuild.sh.
+ *
+ * Results are written as JSON, one benchmark per line so a recorded run can be passed back as --baseline,
+ * every result then carries the baseline median and its change in percent.
+ * Log output of the strategy (DEBUG_PRINT) is discarded while benchmarks run, formatting is measured, terminal I/O is not.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include "api2Stub.h"
+#include "../template.h"
+#include "../../common/optionChainGreeks.h"
+#include "../../common/riskLimits.h"
+#include "../../common/batchedRowWriter.h"
+#include "../../wscCommon/ini.hpp"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+namespace SampleTemplate
+{
+    // access to private hot functions of Template
+    class TemplateBench
+    {
+        Template &_strategy;
+
+    public:
+        explicit TemplateBench(Template &strategy) : _strategy(strategy) {}
+
+        void updateBookSnapshot() { _strategy.updateBookSnapshot(); }
+        bool isValidBookSnapshot() { return _strategy.isValidBookSnapshot(); }
+        void orderManager() { _strategy.orderManager(); }
+        void requote() { _strategy.requote(); }
+        template <typename Policy>
+        void quote() { _strategy.quote<Policy>(); }
+        void logSnapshot() { _strategy.logSnapshot(); }
+        void captureSnapshot(wsc::SnapshotRecord &record) { _strategy.captureSnapshot(record); }
+        static void printSnapshot(std::ostream &os, const wsc::SnapshotRecord &record) { Template::printSnapshot(os, record); }
+        void orderResHandler(API2::OrderConfirmation &confirmation) { _strategy.orderResHandler(API2::COMMON::OrderEvent_CONFIRMED, confirmation, _strategy._buyOrderBook[0]->_orderId); }
+        OrderStr getOrderStr() { return _strategy.getOrderStr(*_strategy._buyOrderBook[0]); }
+        API2::COMMON::OrderWrapper &buyOrder() { return *_strategy._buyOrderBook[0]; }
+        API2::COMMON::OrderWrapper &sellOrder() { return *_strategy._sellOrderBook[0]; }
+        const wsc::BookSnapshot &bookSnapshot() { return _strategy._bookSnapshot; }
+
+        // fill resting orders the book traded through, stub acknowledges at once so a fill resets the wrapper
+        void simulateFills()
+        {
+            Api2Stub::Market &market = Api2Stub::market();
+            for (int i = 0; i < _strategy._ordersPoolSize; ++i)
+            {
+                API2::COMMON::OrderWrapper &buy = *_strategy._buyOrderBook[i];
+                if (!buy._isReset && buy._lastQuantity > 0 && buy._lastQuotedPrice >= market.askPrice[0])
+                {
+                    market.buyTradedQty += buy._lastQuantity;
+                    market.buyTradedValue += buy._lastQuantity * buy._lastQuotedPrice;
+                    buy.reset();
+                }
+                API2::COMMON::OrderWrapper &sell = *_strategy._sellOrderBook[i];
+                if (!sell._isReset && sell._lastQuantity > 0 && sell._lastQuotedPrice <= market.bidPrice[0])
+                {
+                    market.sellTradedQty += sell._lastQuantity;
+                    market.sellTradedValue += sell._lastQuantity * sell._lastQuotedPrice;
+                    sell.reset();
+                }
+            }
+        }
+
+        // stub wrappers carry no order id, slice children get distinct ones so their confirmations find the child.
+        // Throttle of the configured executor is kept for checkSquareOffSliced, disabled for the timed case
+        void setUpSquareOff(bool isThrottled)
+        {
+            for (int side = 0; side < 2; ++side)
+            {
+                for (size_t i = 0; i < _strategy._sliceOrderBook[side].size() && i < MAX_CHILDREN; ++i)
+                    _strategy._sliceOrderBook[side][i]->_orderId = reinterpret_cast<API2::COMMON::OrderId *>(&_childIds[side][i]);
+                if (!isThrottled && _strategy._squareOffExecutors[side])
+                {
+                    API2::SymbolStaticData *staticData = _strategy._contract->getStaticData();
+                    _strategy._squareOffExecutors[side].reset(new API2::COMMON::SlicedOrderExecutor(_strategy._sliceOrderBook[side], staticData->freezeQuantity, staticData->marketLot));
+                }
+            }
+        }
+
+        // long position of qty squared off by a requote, every child filled as soon as it is sent, position is flat again after
+        // returns quantity of the largest child, 0 if the square off was not sliced or children do not cover the position
+        long squareOffSliced(long qty)
+        {
+            Api2Stub::Market &market = Api2Stub::market();
+            market.buyTradedQty += qty;
+            market.buyTradedValue += qty * market.bidPrice[0];
+            _strategy.requote();
+
+            API2::COMMON::SlicedOrderExecutor *executor = _strategy._squareOffExecutors[1].get();
+            long filledQty = 0, maxChildQty = 0;
+            while (executor && (executor->isActive() || executor->hasOpenChildren()))
+            {
+                bool isFilled = false;
+                for (size_t i = 0; i < executor->getChildCount(); ++i)
+                {
+                    API2::COMMON::OrderWrapper *child = executor->getChildWrapper(i);
+                    if (child->_isReset || child->_lastQuantity == 0)
+                        continue;
+                    long fillQty = child->_lastQuantity;
+                    market.sellTradedQty += fillQty;
+                    market.sellTradedValue += fillQty * child->_lastQuotedPrice;
+                    filledQty += fillQty;
+                    maxChildQty = std::max(maxChildQty, fillQty);
+                    child->reset();
+                    executor->onConfirmation(_strategy._riskStatus, child->_orderId, API2::COMMON::OrderEvent_FILLED, fillQty);
+                    isFilled = true;
+                }
+                if (!isFilled)
+                    break;
+            }
+            if (executor == NULL || executor->isActive() || filledQty != qty)
+            {
+                market.sellTradedQty += qty - filledQty;
+                maxChildQty = 0;
+            }
+            _strategy.requote();
+            return maxChildQty;
+        }
+
+        // quote both sides of the first level, existing orders are replaced when price changes
+        void setInternalOrders(long buyPrice, long sellPrice, int qty)
+        {
+            _strategy._internalBuyOrderBook[0].price = buyPrice;
+            _strategy._internalBuyOrderBook[0].qty = qty;
+            _strategy._internalSellOrderBook[0].price = sellPrice;
+            _strategy._internalSellOrderBook[0].qty = qty;
+        }
+
+    private:
+        static const size_t MAX_CHILDREN = 16;
+        long _childIds[2][MAX_CHILDREN];
+    };
+}
+
+namespace
+{
+    struct NullBuffer : public std::streambuf
+    {
+        int overflow(int c) { return c; }
+        std::streamsize xsputn(const char *, std::streamsize n) { return n; }
+    };
+
+    struct BenchOptions
+    {
+        std::string filter;
+        std::string config;
+        std::string out;
+        std::string baseline;
+        std::string replay;
+        int replayPasses;
+        int64_t minTimeMs;
+    };
+
+    struct SessionTick
+    {
+        int64_t timestamp;
+        long bidPrice[Api2Stub::BOOK_LEVELS];
+        long bidQty[Api2Stub::BOOK_LEVELS];
+        long askPrice[Api2Stub::BOOK_LEVELS];
+        long askQty[Api2Stub::BOOK_LEVELS];
+    };
+
+    struct BenchResult
+    {
+        std::string name;
+        uint64_t iterations;
+        double meanNs;
+        double medianNs;
+        double p99Ns;
+        double minNs;
+    };
+
+    inline int64_t getMonotonicTimestamp()
+    {
+        timespec ts;
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    // keeps the compiler from dropping a result nobody reads
+    template <class T>
+    inline void doNotOptimize(const T &value)
+    {
+        asm volatile(""
+                     :
+                     : "m"(value)
+                     : "memory");
+    }
+
+    BenchResult makeResult(const char *name, std::vector<double> &samples, uint64_t iterations, int64_t elapsed)
+    {
+        std::sort(samples.begin(), samples.end());
+        BenchResult result;
+        result.name = name;
+        result.iterations = iterations;
+        result.meanNs = (double)elapsed / iterations;
+        result.medianNs = samples[samples.size() / 2];
+        result.p99Ns = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+        result.minNs = samples[0];
+        return result;
+    }
+
+    // runs fn in batches sized to ~20us until minTimeMs passed, per op time of every batch is one sample
+    template <class F>
+    BenchResult measure(const char *name, const BenchOptions &options, F fn)
+    {
+        uint64_t batch = 1;
+        while (batch < (1 << 20))
+        {
+            int64_t begin = getMonotonicTimestamp();
+            for (uint64_t i = 0; i < batch; ++i)
+                fn();
+            if (getMonotonicTimestamp() - begin > 20000)
+                break;
+            batch *= 2;
+        }
+
+        std::vector<double> samples;
+        samples.reserve(1 << 16);
+        uint64_t iterations = 0;
+        int64_t elapsed = 0;
+        const int64_t end = getMonotonicTimestamp() + options.minTimeMs * NANO_SECONDS_IN_MILI_SEC;
+        while (getMonotonicTimestamp() < end || samples.size() < 10)
+        {
+            int64_t begin = getMonotonicTimestamp();
+            for (uint64_t i = 0; i < batch; ++i)
+                fn();
+            int64_t duration = getMonotonicTimestamp() - begin;
+            samples.push_back((double)duration / batch);
+            iterations += batch;
+            elapsed += duration;
+        }
+
+        return makeResult(name, samples, iterations, elapsed);
+    }
+
+    bool readSession(const std::string &path, std::vector<SessionTick> &session)
+    {
+        std::ifstream file(path.c_str());
+        if (!file)
+            return false;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (line.empty() || line[0] == '#')
+                continue;
+            SessionTick tick;
+            memset(&tick, 0, sizeof(tick));
+            char *cursor = const_cast<char *>(line.c_str());
+            tick.timestamp = strtoll(cursor, &cursor, 10);
+            for (int level = 0; level < Api2Stub::BOOK_LEVELS && *cursor == ','; ++level)
+            {
+                tick.bidPrice[level] = strtol(cursor + 1, &cursor, 10);
+                tick.bidQty[level] = *cursor == ',' ? strtol(cursor + 1, &cursor, 10) : 0;
+                tick.askPrice[level] = *cursor == ',' ? strtol(cursor + 1, &cursor, 10) : 0;
+                tick.askQty[level] = *cursor == ',' ? strtol(cursor + 1, &cursor, 10) : 0;
+            }
+            session.push_back(tick);
+        }
+        return !session.empty();
+    }
+
+    inline uint64_t nextRandom(uint64_t &seed)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return seed;
+    }
+
+    // a single row must reach the CSV file flushIntervalMicros after it was appended, not wait for a full batch
+    // returns the delay in milliseconds, -1 if the row was not written within limitMs
+    long checkRowWriterFlush(long limitMs)
+    {
+        char path[] = "/tmp/templateAlgo_bench_XXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0)
+            return -1;
+        close(fd);
+        API2::COMMON::RowWriterConfig config;
+        config.target = API2::COMMON::RowWriterTarget_CSV;
+        config.path = path;
+        config.table = "flush";
+        config.columns = "id INTEGER";
+        config.flushIntervalMicros = 1000;
+        API2::COMMON::BatchedRowWriter writer;
+        std::string error;
+        long delayMs = -1;
+        if (writer.open(config, API2::COMMON::ThreadPlacement("BenchWriter"), error))
+        {
+            // writer idle first, waiting without deadline
+            usleep(20000);
+            struct timespec start, now;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            writer.append([](API2::COMMON::RowBuffer &row) { row.addInt(1); });
+            for (long elapsedMs = 0; elapsedMs <= limitMs; usleep(1000))
+            {
+                clock_gettime(CLOCK_MONOTONIC, &now);
+                elapsedMs = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+                if (writer.getWrittenRowCount() == 1)
+                {
+                    delayMs = elapsedMs;
+                    break;
+                }
+            }
+            writer.close();
+        }
+        unlink(path);
+        return delayMs;
+    }
+
+    // getBestPrices must price every request exactly like getBestPrice, compared over seeded random books with empty levels,
+    // own orders resting on a level and random arguments. Wrapper prices and quantities are restored, the caller sets its book again
+    bool checkBestPrices(API2::SGContext *context, API2::COMMON::OrderWrapper *wrappers[2], long mid, long tickSize, int rounds)
+    {
+        Api2Stub::Market &market = Api2Stub::market();
+        const size_t COUNT = 8;
+        struct WrapperState
+        {
+            long _lastQuotedPrice, _lastQuantity, _lastFilledQuantity;
+        } saved[2];
+        for (int side = 0; side < 2; ++side)
+            saved[side] = {wrappers[side]->_lastQuotedPrice, wrappers[side]->_lastQuantity, wrappers[side]->_lastFilledQuantity};
+        uint64_t seed = 88172645463325252ULL;
+        bool isSame = true;
+        for (int round = 0; round < rounds && isSame; ++round)
+        {
+            for (int level = 0; level < 5; ++level)
+            {
+                market.bidPrice[level] = mid - (long)(level * 2 + 1 + nextRandom(seed) % 2) * tickSize;
+                market.bidQty[level] = nextRandom(seed) % 5 == 0 ? 0 : 25 * (long)(1 + nextRandom(seed) % 3);
+                market.askPrice[level] = mid + (long)(level * 2 + 1 + nextRandom(seed) % 2) * tickSize;
+                market.askQty[level] = nextRandom(seed) % 5 == 0 ? 0 : 25 * (long)(1 + nextRandom(seed) % 3);
+            }
+            for (int side = 0; side < 2; ++side)
+            {
+                API2::COMMON::OrderWrapper &wrapper = *wrappers[side];
+                int level = (int)(nextRandom(seed) % 5);
+                wrapper._lastFilledQuantity = 25 * (long)(nextRandom(seed) % 2);
+                wrapper._lastQuotedPrice = side == 0 ? market.bidPrice[level] : market.askPrice[level];
+                // alone on its level half of the time, else one lot more rests there
+                wrapper._lastQuantity = (side == 0 ? market.bidQty[level] : market.askQty[level]) + wrapper._lastFilledQuantity - 25 * (long)(nextRandom(seed) % 2);
+            }
+
+            API2::COMMON::BestPriceRequest requests[COUNT];
+            for (size_t i = 0; i < COUNT; ++i)
+            {
+                API2::COMMON::BestPriceRequest &request = requests[i];
+                request.orderWrapper = wrappers[i % 2];
+                request.side = i % 2 == 0 ? API2::CONSTANTS::CMD_OrderMode_BUY : API2::CONSTANTS::CMD_OrderMode_SELL;
+                request.tickFactor = (int)(nextRandom(seed) % 3) - 1;
+                request.pickOpportunityEnabled = nextRandom(seed) % 3 == 0;
+                request.opportunityPrice = (i % 2 == 0 ? market.askPrice[0] : market.bidPrice[0]) + ((long)(nextRandom(seed) % 3) - 1) * tickSize;
+                request.useBasePrice = nextRandom(seed) % 2 == 0;
+                request.basePrice = mid + ((long)(nextRandom(seed) % 9) - 4) * tickSize;
+                request.bidInTop5 = nextRandom(seed) % 2 == 0;
+                request.notBestBid = nextRandom(seed) % 2 == 0;
+                request.price = (long)(nextRandom(seed) % 1000);
+            }
+            API2::COMMON::BestPriceRequest expected[COUNT];
+            std::copy(requests, requests + COUNT, expected);
+            for (size_t i = 0; i < COUNT; ++i)
+            {
+                API2::COMMON::BestPriceRequest &r = expected[i];
+                API2::COMMON::getBestPrice(market.symbolId, r.side, r.price, *r.orderWrapper, context, r.tickFactor, r.pickOpportunityEnabled,
+                                           r.pickedOpportunity, r.opportunityPrice, r.useBasePrice, r.basePrice, r.bidInTop5, r.notBestBid);
+            }
+            API2::COMMON::getBestPrices(market.symbolId, requests, COUNT, context);
+            for (size_t i = 0; i < COUNT; ++i)
+            {
+                if (requests[i].price != expected[i].price || requests[i].pickedOpportunity != expected[i].pickedOpportunity)
+                {
+                    fprintf(stderr, "getBestPrices differs from getBestPrice in round %d request %zu: price %ld / %ld, picked %d / %d\n",
+                            round, i, (long)requests[i].price, (long)expected[i].price, requests[i].pickedOpportunity, expected[i].pickedOpportunity);
+                    isSame = false;
+                }
+            }
+        }
+        for (int side = 0; side < 2; ++side)
+        {
+            wrappers[side]->_lastQuotedPrice = saved[side]._lastQuotedPrice;
+            wrappers[side]->_lastQuantity = saved[side]._lastQuantity;
+            wrappers[side]->_lastFilledQuantity = saved[side]._lastFilledQuantity;
+        }
+        return isSame;
+    }
+
+    // seeded random walk of the mid with 1-3 tick spread, 5 levels a side, one tick per millisecond
+    void makeSyntheticSession(size_t ticks, long mid, long tickSize, std::vector<SessionTick> &session)
+    {
+        uint64_t seed = 88172645463325252ULL;
+        int64_t timestamp = 1619596800000000000LL;
+        session.resize(ticks);
+        for (size_t t = 0; t < ticks; ++t)
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            mid += ((long)(seed % 3) - 1) * tickSize;
+            long halfSpread = (1 + (long)((seed >> 8) % 3)) * tickSize;
+            SessionTick &tick = session[t];
+            memset(&tick, 0, sizeof(tick));
+            tick.timestamp = timestamp += NANO_SECONDS_IN_MILI_SEC;
+            for (int level = 0; level < 5; ++level)
+            {
+                tick.bidPrice[level] = mid - halfSpread - level * tickSize;
+                tick.askPrice[level] = mid + halfSpread + level * tickSize;
+                tick.bidQty[level] = 25 * (1 + (long)((seed >> (16 + level)) % 8));
+                tick.askQty[level] = 25 * (1 + (long)((seed >> (24 + level)) % 8));
+            }
+        }
+    }
+
+    // timer event every 1000 ticks (not timed), as the API2 timer would fire during a session
+    BenchResult replaySession(SampleTemplate::Template &strategy, SampleTemplate::TemplateBench &bench, const std::vector<SessionTick> &session, int passes)
+    {
+        Api2Stub::Market &market = Api2Stub::market();
+        std::vector<double> samples;
+        samples.reserve(session.size() * passes);
+        int64_t elapsed = 0;
+        for (int pass = 0; pass < passes; ++pass)
+        {
+            for (size_t t = 0; t < session.size(); ++t)
+            {
+                const SessionTick &tick = session[t];
+                market.timestamp = tick.timestamp;
+                memcpy(market.bidPrice, tick.bidPrice, sizeof(tick.bidPrice));
+                memcpy(market.bidQty, tick.bidQty, sizeof(tick.bidQty));
+                memcpy(market.askPrice, tick.askPrice, sizeof(tick.askPrice));
+                memcpy(market.askQty, tick.askQty, sizeof(tick.askQty));
+                bench.simulateFills();
+
+                int64_t begin = getMonotonicTimestamp();
+                strategy.onMarketDataEvent(market.symbolId);
+                int64_t duration = getMonotonicTimestamp() - begin;
+                samples.push_back((double)duration);
+                elapsed += duration;
+
+                if (t % 1000 == 999)
+                    strategy.onTimerEvent();
+            }
+        }
+        return makeResult("replay/tickToOrder", samples, samples.size(), elapsed);
+    }
+
+    // name -> median_ns of a previous run of this tool
+    std::map<std::string, double> readBaseline(const std::string &path)
+    {
+        std::map<std::string, double> baseline;
+        std::ifstream file(path.c_str());
+        std::string line;
+        while (std::getline(file, line))
+        {
+            size_t name = line.find("\"name\": \"");
+            size_t median = line.find("\"median_ns\": ");
+            if (name == std::string::npos || median == std::string::npos)
+                continue;
+            name += 9;
+            baseline[line.substr(name, line.find('"', name) - name)] = atof(line.c_str() + median + 13);
+        }
+        return baseline;
+    }
+
+    void writeResults(std::ostream &os, const std::vector<BenchResult> &results, const BenchOptions &options)
+    {
+        std::map<std::string, double> baseline;
+        if (!options.baseline.empty())
+            baseline = readBaseline(options.baseline);
+
+        char buffer[512];
+        os << "{\n";
+        os << "  \"benchmark\": \"templateAlgo_bench\",\n";
+        os << "  \"compiler\": \"" << __VERSION__ << "\",\n";
+        os << "  \"timestamp\": " << time(NULL) << ",\n";
+        os << "  \"min_time_ms\": " << options.minTimeMs << ",\n";
+        os << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const BenchResult &r = results[i];
+            int length = snprintf(buffer, sizeof(buffer),
+                                  "    {\"name\": \"%s\", \"iterations\": %llu, \"mean_ns\": %.2f, \"median_ns\": %.2f, \"p99_ns\": %.2f, \"min_ns\": %.2f",
+                                  r.name.c_str(), (unsigned long long)r.iterations, r.meanNs, r.medianNs, r.p99Ns, r.minNs);
+            os.write(buffer, length);
+            std::map<std::string, double>::const_iterator base = baseline.find(r.name);
+            if (base != baseline.end() && base->second > 0)
+            {
+                length = snprintf(buffer, sizeof(buffer), ", \"baseline_median_ns\": %.2f, \"change_pct\": %.1f",
+                                  base->second, (r.medianNs - base->second) * 100.0 / base->second);
+                os.write(buffer, length);
+            }
+            os << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        os << "  ]\n}\n";
+    }
+
+    double blackScholesPrice(bool isCall, double spot, double strike, double t, double r, double iv)
+    {
+        double sqrtT = sqrt(t);
+        double d1 = (log(spot / strike) + (r + 0.5 * iv * iv) * t) / (iv * sqrtT);
+        double d2 = d1 - iv * sqrtT;
+        double discount = exp(-r * t);
+        double nd1 = 0.5 * erfc(-d1 / M_SQRT2);
+        double nd2 = 0.5 * erfc(-d2 / M_SQRT2);
+        return isCall ? spot * nd1 - strike * discount * nd2 : strike * discount * (1 - nd2) - spot * (1 - nd1);
+    }
+
+    bool parseOptions(int argc, char **argv, BenchOptions &options)
+    {
+        options.config = TEMPLATE_BENCH_APP_CONFIG;
+        options.minTimeMs = 200;
+        options.replayPasses = 1;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (i + 1 >= argc)
+                return false;
+            if (arg == "--filter")
+                options.filter = argv[++i];
+            else if (arg == "--min-time-ms")
+                options.minTimeMs = atol(argv[++i]);
+            else if (arg == "--config")
+                options.config = argv[++i];
+            else if (arg == "--out")
+                options.out = argv[++i];
+            else if (arg == "--baseline")
+                options.baseline = argv[++i];
+            else if (arg == "--replay")
+                options.replay = argv[++i];
+            else if (arg == "--replay-passes")
+                options.replayPasses = atoi(argv[++i]);
+            else
+                return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "usage: %s [--filter <substring>] [--min-time-ms <ms>] [--config <appConfig.ini>] [--out <results.json>] [--baseline <results.json>]"
+                        " [--replay <session.csv>|synthetic] [--replay-passes <n>]\n",
+                argv[0]);
+        return 2;
+    }
+
+    NullBuffer nullBuffer;
+    std::streambuf *coutBuffer = std::cout.rdbuf(&nullBuffer);
+
+    const long mid = 3500000;
+    const long tickSize = Api2Stub::staticData().tickSize;
+    Api2Stub::setBook(mid, tickSize, 25, 1619596800000000000LL);
+
+    wsc::common::appConfigFilePath = options.config;
+    SampleTemplate::FrontEndParameters userParams;
+    API2::StrategyParameters strategyParams;
+    SampleTemplate::Template *strategy;
+    try
+    {
+        strategy = new SampleTemplate::Template(&strategyParams, userParams);
+    }
+    catch (std::string &e)
+    {
+        std::cout.rdbuf(coutBuffer);
+        fprintf(stderr, "strategy setup failed: %s (config %s)\n", e.c_str(), options.config.c_str());
+        return 1;
+    }
+    SampleTemplate::TemplateBench bench(*strategy);
+
+    std::vector<BenchResult> results;
+#define BENCH(NAME, BODY)                                                          \
+    if (options.filter.empty() || std::string(NAME).find(options.filter) != std::string::npos) \
+        results.push_back(measure(NAME, options, [&]() BODY));
+
+    // new update every call, depth is read from MktData and published to the shared cache
+    BENCH("updateBookSnapshot", {
+        ++Api2Stub::market().timestamp;
+        bench.updateBookSnapshot();
+    });
+    // update already published, as seen by a second strategy on the same symbol
+    BENCH("updateBookSnapshot/cached", { bench.updateBookSnapshot(); });
+    BENCH("isValidBookSnapshot", { doNotOptimize(bench.isValidBookSnapshot()); });
+
+    // quote prices of each policy for the current book, same instantiations as onBookSnapshot
+    BENCH("quote/FIXED_LEVEL", { bench.quote<API2::COMMON::FixedLevelQuoting>(); });
+    BENCH("quote/JOIN_IMPROVE", { bench.quote<API2::COMMON::JoinImproveQuoting>(); });
+    BENCH("quote/INVENTORY_SKEW", { bench.quote<API2::COMMON::InventorySkewQuoting>(); });
+    BENCH("quote/MICROPRICE_OFFSET", { bench.quote<API2::COMMON::MicropriceOffsetQuoting>(); });
+
+    bench.setInternalOrders(mid - 2 * tickSize, mid + 2 * tickSize, 25);
+    bench.orderManager();
+    BENCH("orderManager", { bench.orderManager(); });
+
+    long shift = 0;
+    BENCH("orderManager/replace", {
+        shift ^= tickSize;
+        bench.setInternalOrders(mid - 2 * tickSize - shift, mid + 2 * tickSize + shift, 25);
+        bench.orderManager();
+    });
+
+    // orders recomputed from the last book after a confirmation, no MktData read
+    bench.updateBookSnapshot();
+    BENCH("requote", { bench.requote(); });
+    BENCH("onMarketDataEvent", { strategy->onMarketDataEvent(Api2Stub::market().symbolId); });
+
+    // square off of three freeze quantities, runtime rejects any order at or above freeze quantity so it must go out in slices
+    const long freezeQty = Api2Stub::staticData().freezeQuantity, squareOffQty = 3 * freezeQty;
+    bench.setUpSquareOff(true);
+    long maxChildQty = bench.squareOffSliced(squareOffQty);
+    if (maxChildQty == 0 || maxChildQty >= freezeQty)
+    {
+        std::cout.rdbuf(coutBuffer);
+        fprintf(stderr, "square off of %ld was not sliced below freeze quantity %ld, largest child %ld\n", squareOffQty, freezeQty, maxChildQty);
+        return 1;
+    }
+    bench.setUpSquareOff(false);
+
+    long flushDelayMs = checkRowWriterFlush(300);
+    if (flushDelayMs < 0)
+    {
+        std::cout.rdbuf(coutBuffer);
+        fprintf(stderr, "persist row was not written within 300ms of a 1ms flush interval\n");
+        return 1;
+    }
+    BENCH("squareOff/sliced", { doNotOptimize(bench.squareOffSliced(squareOffQty)); });
+    BENCH("logSnapshot", { bench.logSnapshot(); });
+
+    // formatting done by the snapshot thread for every logSnapshot it keeps up with
+    wsc::SnapshotRecord snapshotRecord;
+    bench.captureSnapshot(snapshotRecord);
+    wsc::FixedBufferStream<16384> snapshotStream;
+    BENCH("printSnapshot", {
+        snapshotStream.reset();
+        bench.printSnapshot(snapshotStream, snapshotRecord);
+        doNotOptimize(snapshotStream.c_str()[0]);
+    });
+
+    // record copy only, formatting runs on the confirmation log thread
+    API2::OrderConfirmation confirmation;
+    BENCH("orderResHandler", { bench.orderResHandler(confirmation); });
+
+    wsc::FixedBufferStream<4096> stream;
+    BENCH("getOrderStr", {
+        stream.reset();
+        stream << bench.getOrderStr();
+        doNotOptimize(stream.c_str()[0]);
+    });
+
+    int64_t timestamp = 1619596800123456789LL;
+    BENCH("printTimestamp", {
+        stream.reset();
+        wsc::Time::printTimestamp(stream, timestamp += 1000);
+        doNotOptimize(stream.c_str()[0]);
+    });
+
+    API2::COMMON::MktData *mktData = strategy->reqQryMarketData(Api2Stub::market().symbolId);
+    BENCH("getWeightedAveragePrice", { doNotOptimize(API2::COMMON::getWeightedAveragePrice(mktData, 500, true)); });
+
+    // differential check of the batched pricing, then one symbol with 8 wrappers priced one call each and in one batch
+    API2::COMMON::OrderWrapper *bestPriceWrappers[2] = {&bench.buyOrder(), &bench.sellOrder()};
+    bool isBestPricesSame = checkBestPrices(strategy, bestPriceWrappers, mid, tickSize, 100000);
+    Api2Stub::setBook(mid, tickSize, 25, ++Api2Stub::market().timestamp);
+    if (!isBestPricesSame)
+    {
+        std::cout.rdbuf(coutBuffer);
+        return 1;
+    }
+    API2::COMMON::BestPriceRequest bestPriceRequests[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        bestPriceRequests[i].orderWrapper = bestPriceWrappers[i % 2];
+        bestPriceRequests[i].side = i % 2 == 0 ? API2::CONSTANTS::CMD_OrderMode_BUY : API2::CONSTANTS::CMD_OrderMode_SELL;
+        bestPriceRequests[i].tickFactor = i / 2;
+    }
+    BENCH("getBestPrice x8", {
+        for (int i = 0; i < 8; ++i)
+        {
+            API2::COMMON::BestPriceRequest &r = bestPriceRequests[i];
+            API2::COMMON::getBestPrice(Api2Stub::market().symbolId, r.side, r.price, *r.orderWrapper, strategy, r.tickFactor, false, r.pickedOpportunity, 0);
+        }
+        doNotOptimize(bestPriceRequests[7].price);
+    });
+    BENCH("getBestPrices/8", {
+        API2::COMMON::getBestPrices(Api2Stub::market().symbolId, bestPriceRequests, 8, strategy);
+        doNotOptimize(bestPriceRequests[7].price);
+    });
+    BENCH("isOrderPlaceable", { doNotOptimize(API2::COMMON::isOrderPlaceable(mid, 25, bench.buyOrder(), true, 1800)); });
+
+    API2::COMMON::RiskLimits riskLimits;
+    riskLimits.initialize(&Api2Stub::staticData(), 1000000.0, 20, 40);
+    BENCH("checkRiskLimits", {
+        doNotOptimize(API2::COMMON::checkRiskLimits(riskLimits, API2::CONSTANTS::CMD_OrderMode_BUY, mid - tickSize, 25, 100, mid));
+    });
+
+    // current book through the fixed layout encoding of checkpoints and messages, decode and view of the same buffer
+    typedef API2::COMMON::FixedCodec<wsc::BookSnapshot> BookCodec;
+    char layoutBuffer[BookCodec::ENCODED_SIZE];
+    wsc::BookSnapshot decodedBook = bench.bookSnapshot();
+    BENCH("FixedCodec/encode BookSnapshot", { doNotOptimize(BookCodec::encode(bench.bookSnapshot(), layoutBuffer, sizeof(layoutBuffer))); });
+    BENCH("FixedCodec/decode BookSnapshot", {
+        doNotOptimize(BookCodec::decode(layoutBuffer, sizeof(layoutBuffer), decodedBook));
+        doNotOptimize(decodedBook.bidPriceLevels[0].price);
+    });
+    API2::COMMON::FixedView<wsc::BookSnapshot> bookView;
+    BENCH("FixedView/best bid BookSnapshot", {
+        doNotOptimize(BookCodec::view(layoutBuffer, sizeof(layoutBuffer), bookView) &&
+                      bookView.get<API2_FIXED_FIELD(wsc::BookSnapshot, bidPriceLevels)>()[0].get<API2_FIXED_FIELD(wsc::BookPriceLevel, price)>() > 0);
+    });
+
+    // order deadlines, 1000 timers already pending 1 to 10 s out on a 10 ms wheel
+    API2::COMMON::TimingWheel wheel(4096, 10 * NANO_SECONDS_IN_MILI_SEC);
+    for (int i = 0; i < 1000; ++i)
+        wheel.schedule((1 + i % 10) * NANO_SECONDS_IN_SEC + i * NANO_SECONDS_IN_MILI_SEC, 1, i);
+    BENCH("TimingWheel/schedule+cancel", { doNotOptimize(wheel.cancel(wheel.schedule(2 * NANO_SECONDS_IN_SEC, 1, 0))); });
+    int64_t wheelNow = 0;
+    size_t wheelExpired = 0;
+    BENCH("TimingWheel/advance+reschedule", {
+        wheelNow += NANO_SECONDS_IN_MILI_SEC;
+        wheel.advance(wheelNow, [&](uint32_t kind, uint64_t data)
+                      {
+                          ++wheelExpired;
+                          wheel.schedule(wheelNow + 10 * NANO_SECONDS_IN_SEC, kind, data);
+                      });
+    });
+    doNotOptimize(wheelExpired);
+
+    // line formatted into the slab of this thread, written to /dev/null by the writer thread
+    API2::COMMON::SlabLog slabLog;
+    std::string slabLogError;
+    if (slabLog.open("/dev/null", API2::COMMON::ThreadPlacement("bench log"), slabLogError))
+    {
+        API2::COMMON::SlabLog *log = &slabLog;
+        BENCH("SlabLog/printToLog2", { DEBUG_VARSHOW2(log, "Order price qty", mid, 25); });
+        slabLog.close();
+    }
+
+    BENCH("mINI/read", {
+        mINI::INIStructure ini;
+        doNotOptimize(mINI::INIFile(options.config).read(ini));
+    });
+
+    // 100 strikes x call / put x 2 expiries, prices from a 20% flat surface
+    API2::COMMON::OptionChainGreeks chain(400);
+    const double spot = 35000, interestRate = 0.05;
+    for (int expiry = 0; expiry < 2; ++expiry)
+        for (int strike = 0; strike < 100; ++strike)
+            for (int isCall = 0; isCall < 2; ++isCall)
+            {
+                double k = 32500 + strike * 50, t = (7 + expiry * 28) / 365.0;
+                size_t index = chain.addOption(isCall, k, t);
+                chain.setOptionPrice(index, blackScholesPrice(isCall, spot, k, t, interestRate, 0.2));
+            }
+    BENCH("OptionChainGreeks/compute400", { chain.compute(spot, interestRate, 0); });
+#undef BENCH
+
+    if (!options.replay.empty() && (options.filter.empty() || std::string("replay/tickToOrder").find(options.filter) != std::string::npos))
+    {
+        std::vector<SessionTick> session;
+        if (options.replay == "synthetic")
+            makeSyntheticSession(200000, mid, tickSize, session);
+        else if (!readSession(options.replay, session))
+        {
+            delete strategy;
+            std::cout.rdbuf(coutBuffer);
+            fprintf(stderr, "can not read session %s\n", options.replay.c_str());
+            return 1;
+        }
+        results.push_back(replaySession(*strategy, bench, session, std::max(options.replayPasses, 1)));
+    }
+
+    delete strategy;
+    std::cout.rdbuf(coutBuffer);
+
+    if (options.out.empty())
+        writeResults(std::cout, results, options);
+    else
+    {
+        std::ofstream file(options.out.c_str());
+        writeResults(file, results, options);
+    }
+    return 0;
+}
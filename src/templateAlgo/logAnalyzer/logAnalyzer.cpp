@@ -0,0 +1,1000 @@
+/**
+ * templateAlgo_logAnalyzer - post trade report of strategy logs and rmsLogs login logs.
+ *
+ * usage: templateAlgo_logAnalyzer [--interval-sec <s>] [--threads <n>] [--out <report.json>] <log file> [<log file> ...]
+ *
+ * Files are memory mapped and read once. Lines are found with a DelimiterScanner on newlines, fields of a line with a second one on
+ * commas and quotes, the doubled quote JSON columns of STG_SNAPSHOT are read in place. Nothing is copied or allocated per line,
+ * only per strategy, curve point and order. Files are analyzed in parallel, one file at a time per thread.
+ *
+ * Strategy logs (REPORT_LOG_DIR report log, or stdout of the strategy), strategy is a contract of STG_SNAPSHOT lines of one file:
+ *  - STG_SNAPSHOT (logSnapshot) gives the position / PnL curve, last snapshot of every --interval-sec (default 60, 0 keeps all),
+ *    final and extreme PnL, max drawdown of NetPnL, message count and rate, traded quantities, mean spread of the book snapshot
+ *    and mean number of open orders of the ActiveOrderBook column.
+ *  - CONFIRMATION (confirmation log) gives counts per callback, filled quantity and the orderLifetime distribution, onConfirmed
+ *    to onFilled / onCanceled / onIOCCanceled of the same ClOrderId. Book to confirmation latency is not reported, the book
+ *    timestamp of STG_SNAPSHOT is exchange time of a conflated snapshot and the confirmation time is local.
+ * Timestamps are read back as printed by wsc::Time::printTimestamp, local wall clock, and reported the same way.
+ * Login logs (header "DEALER ID,LOGIN/LOGOUT,PASS/FAIL,IP ADDRESS,TIME") give the session events in file order and counts per dealer.
+ *
+ * Report is written as JSON, to stdout unless --out is given.
+ *
+ * Disclaimer: uTrade will not be responsible for any issue due to this code as implementation is also provided
+ *
+ */
+
+#include "../../common/delimiterScan.h"
+#include "../../common/orderStateMachine.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    using API2::COMMON::DelimiterScanner;
+
+    const int64_t NANOS_IN_SEC = 1000000000LL;
+    const size_t MAX_FIELDS = 32;
+
+    // STG_SNAPSHOT columns after the STG_SNAPSHOT field, see Template::printSnapshot
+    enum SnapshotField
+    {
+        SnapshotField_TIMESTAMP = 1,
+        SnapshotField_NET_POS,
+        SnapshotField_GROSS_PNL,
+        SnapshotField_NET_PNL,
+        SnapshotField_MID_PRICE,
+        SnapshotField_TSTQ,
+        SnapshotField_TSTV,
+        SnapshotField_TBTQ,
+        SnapshotField_TBTV,
+        SnapshotField_CONTRACT,
+        SnapshotField_SENT_MSG_COUNT = 16,
+        SnapshotField_ACTIVE_ORDER_BOOK = 19,
+        SnapshotField_INTERNAL_ORDER_BOOK,
+        SnapshotField_BOOK_SNAPSHOT_BID,
+        SnapshotField_BOOK_SNAPSHOT_ASK,
+        SnapshotField_COUNT
+    };
+
+    struct Options
+    {
+        int64_t intervalNanos;
+        int threads;
+        std::string out;
+        std::vector<std::string> files;
+    };
+
+    // text in a mapped file, quoted fields without their quotes, doubled quotes still in
+    struct Field
+    {
+        const char *begin;
+        const char *end;
+
+        size_t size() const { return end - begin; }
+        bool equals(const char *text) const { return size() == strlen(text) && memcmp(begin, text, size()) == 0; }
+        std::string str() const { return std::string(begin, end); }
+    };
+
+    // read only mapping of a whole file
+    class MappedFile
+    {
+        const char *_data;
+        size_t _size;
+
+        MappedFile(const MappedFile &);
+        MappedFile &operator=(const MappedFile &);
+
+    public:
+        MappedFile() : _data(NULL), _size(0) {}
+
+        ~MappedFile()
+        {
+            if (_data)
+                munmap((void *)_data, _size);
+        }
+
+        bool open(const std::string &path, std::string &error)
+        {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+            {
+                error = "open " + path + ": " + strerror(errno);
+                return false;
+            }
+            struct stat fileStat;
+            if (fstat(fd, &fileStat) != 0)
+            {
+                error = "fstat " + path + ": " + strerror(errno);
+                ::close(fd);
+                return false;
+            }
+            if (fileStat.st_size > 0)
+            {
+                void *mapping = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping == MAP_FAILED)
+                {
+                    error = "mmap " + path + ": " + strerror(errno);
+                    ::close(fd);
+                    return false;
+                }
+                madvise(mapping, fileStat.st_size, MADV_SEQUENTIAL);
+                _data = (const char *)mapping;
+                _size = fileStat.st_size;
+            }
+            ::close(fd);
+            return true;
+        }
+
+        const char *begin() const { return _data; }
+        const char *end() const { return _data + _size; }
+        size_t size() const { return _size; }
+    };
+
+    // latency distribution in nanoseconds, 8 buckets per power of 2 so a percentile is within 12.5%, no allocation
+    class Histogram
+    {
+        static const int SUB_BITS = 3;
+        static const int BUCKETS = 64 << SUB_BITS;
+
+        uint64_t _counts[BUCKETS];
+        uint64_t _count;
+        uint64_t _negativeCount;
+        int64_t _min;
+        int64_t _max;
+        double _sum;
+
+        static int getBucket(uint64_t value)
+        {
+            if (value < (1u << SUB_BITS))
+                return (int)value;
+            int msb = 63 - __builtin_clzll(value);
+            return ((msb - SUB_BITS + 1) << SUB_BITS) + (int)((value >> (msb - SUB_BITS)) & ((1 << SUB_BITS) - 1));
+        }
+
+        static int64_t getBucketValue(int bucket)
+        {
+            if (bucket < (1 << SUB_BITS))
+                return bucket;
+            int msb = (bucket >> SUB_BITS) + SUB_BITS - 1;
+            return (int64_t)((1 << SUB_BITS) + (bucket & ((1 << SUB_BITS) - 1))) << (msb - SUB_BITS);
+        }
+
+    public:
+        Histogram() : _counts(), _count(0), _negativeCount(0), _min(0), _max(0), _sum(0) {}
+
+        // negative values come from clocks of different hosts, they are only counted
+        void record(int64_t value)
+        {
+            if (value < 0)
+            {
+                ++_negativeCount;
+                return;
+            }
+            if (_count == 0 || value < _min)
+                _min = value;
+            if (_count == 0 || value > _max)
+                _max = value;
+            ++_count;
+            _sum += value;
+            ++_counts[getBucket(value)];
+        }
+
+        int64_t getPercentile(double percentile) const
+        {
+            uint64_t target = (uint64_t)(percentile * _count / 100.0 + 0.5);
+            if (target == 0)
+                target = 1;
+            uint64_t total = 0;
+            for (int i = 0; i < BUCKETS; ++i)
+            {
+                total += _counts[i];
+                if (total >= target)
+                    return std::min(std::max(getBucketValue(i), _min), _max);
+            }
+            return _max;
+        }
+
+        void write(std::ostream &os) const
+        {
+            char buffer[512];
+            int length = snprintf(buffer, sizeof(buffer),
+                                  "{\"count\": %llu, \"negative\": %llu, \"min_ns\": %lld, \"mean_ns\": %.0f, \"p50_ns\": %lld, \"p90_ns\": %lld, \"p99_ns\": %lld, \"p999_ns\": %lld, \"max_ns\": %lld}",
+                                  (unsigned long long)_count, (unsigned long long)_negativeCount, (long long)_min, _count ? _sum / _count : 0.0,
+                                  (long long)getPercentile(50), (long long)getPercentile(90), (long long)getPercentile(99), (long long)getPercentile(99.9), (long long)_max);
+            os.write(buffer, length);
+        }
+    };
+
+    struct CurvePoint
+    {
+        int64_t timestamp;
+        int64_t netPos;
+        double grossPnL;
+        double netPnL;
+        int64_t msgSentCount;
+    };
+
+    struct StrategyReport
+    {
+        std::string contract;
+        uint64_t snapshots = 0;
+        int64_t firstTimestamp = 0;
+        int64_t lastTimestamp = 0;
+        int64_t netPos = 0;
+        int64_t minNetPos = 0;
+        int64_t maxNetPos = 0;
+        double grossPnL = 0;
+        double netPnL = 0;
+        double minNetPnL = 0;
+        double maxNetPnL = 0;
+        double maxDrawdown = 0;
+        int64_t firstMsgSentCount = 0;
+        int64_t msgSentCount = 0;
+        int64_t buyTradedQty = 0;
+        int64_t sellTradedQty = 0;
+        double spreadSum = 0;
+        uint64_t spreadCount = 0;
+        uint64_t openOrderSum = 0;
+        std::vector<CurvePoint> curve;
+    };
+
+    struct ConfirmationReport
+    {
+        uint64_t counts[API2::COMMON::OrderEvent_MAX] = {};
+        uint64_t unknownCount = 0;
+        int64_t filledQty = 0;
+        Histogram orderLifetime;
+        std::unordered_map<uint64_t, int64_t> confirmedAt; // ClOrderId of open orders, onConfirmed time
+    };
+
+    struct SessionEvent
+    {
+        std::string dealer;
+        std::string action;
+        std::string result;
+        std::string ipAddress;
+        std::string time;
+    };
+
+    struct DealerReport
+    {
+        std::string dealer;
+        uint64_t logins = 0;
+        uint64_t failedLogins = 0;
+        uint64_t logouts = 0;
+        std::string firstTime;
+        std::string lastTime;
+        std::vector<std::string> ipAddresses;
+    };
+
+    struct FileReport
+    {
+        std::string path;
+        std::string error;
+        bool isLoginLog = false;
+        uint64_t bytes = 0;
+        uint64_t lines = 0;
+        uint64_t snapshotLines = 0;
+        uint64_t confirmationLines = 0;
+        uint64_t loginLines = 0;
+        uint64_t unparsedLines = 0; // STG_SNAPSHOT / CONFIRMATION / login lines with a malformed field
+        std::vector<StrategyReport> strategies;
+        ConfirmationReport confirmations;
+        std::vector<SessionEvent> sessionEvents;
+        std::vector<DealerReport> dealers;
+    };
+
+    /**
+     * @brief split a CSV line on commas, a quoted field may hold commas and doubled quotes
+     * @return number of fields, at most maxFields, the rest of a longer line is not split
+     */
+    size_t splitFields(DelimiterScanner &scanner, const char *begin, const char *end, Field *fields, size_t maxFields)
+    {
+        scanner.reset(begin, end);
+        size_t count = 0;
+        const char *p = begin;
+        while (count < maxFields)
+        {
+            Field &field = fields[count++];
+            const char *delimiter;
+            if (p < end && *p == '"')
+            {
+                field.begin = p + 1;
+                scanner.seek(p + 1);
+                for (delimiter = scanner.next(); delimiter != end; delimiter = scanner.next())
+                {
+                    if (*delimiter != '"')
+                        continue;
+                    if (delimiter + 1 < end && delimiter[1] == '"')
+                    {
+                        scanner.seek(delimiter + 2);
+                        continue;
+                    }
+                    break;
+                }
+                field.end = delimiter;
+                // anything between the closing quote and the comma is dropped
+                while (delimiter != end && *delimiter != ',')
+                    delimiter = scanner.next();
+            }
+            else
+            {
+                field.begin = p;
+                for (delimiter = scanner.next(); delimiter != end && *delimiter != ','; delimiter = scanner.next())
+                    ;
+                field.end = delimiter;
+            }
+            if (delimiter == end)
+                break;
+            p = delimiter + 1;
+        }
+        return count;
+    }
+
+    bool readDigits(const char *&p, const char *end, int64_t &value, int &digits)
+    {
+        value = 0;
+        digits = 0;
+        while (p < end && *p >= '0' && *p <= '9')
+        {
+            value = value * 10 + (*p++ - '0');
+            ++digits;
+        }
+        return digits > 0;
+    }
+
+    bool parseInt(const Field &field, int64_t &value)
+    {
+        const char *p = field.begin;
+        bool isNegative = p < field.end && *p == '-';
+        p += isNegative;
+        int digits;
+        if (!readDigits(p, field.end, value, digits) || p != field.end)
+            return false;
+        if (isNegative)
+            value = -value;
+        return true;
+    }
+
+    // doubles are printed by ostream with 6 significant digits, exponent form and nan / inf go through strtod
+    bool parseDouble(const Field &field, double &value)
+    {
+        const char *p = field.begin;
+        bool isNegative = p < field.end && *p == '-';
+        p += isNegative;
+        int64_t integer, fraction = 0;
+        int digits, fractionDigits = 0;
+        bool isPlain = readDigits(p, field.end, integer, digits);
+        if (isPlain && p < field.end && *p == '.')
+        {
+            ++p;
+            readDigits(p, field.end, fraction, fractionDigits);
+        }
+        if (isPlain && p == field.end && fractionDigits <= 18)
+        {
+            static const double scale[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18};
+            value = integer + fraction / scale[fractionDigits];
+            if (isNegative)
+                value = -value;
+            return true;
+        }
+        char buffer[64];
+        if (field.size() == 0 || field.size() >= sizeof(buffer))
+            return false;
+        memcpy(buffer, field.begin, field.size());
+        buffer[field.size()] = 0;
+        char *parsedEnd;
+        value = strtod(buffer, &parsedEnd);
+        return parsedEnd == buffer + field.size();
+    }
+
+    int64_t daysFromCivil(int64_t year, int64_t month, int64_t day)
+    {
+        year -= month <= 2;
+        int64_t era = (year >= 0 ? year : year - 399) / 400;
+        int64_t yearOfEra = year - era * 400;
+        int64_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + dayOfEra - 719468;
+    }
+
+    /**
+     * @brief "IST 2021-6-5 9:15:3000000123" of wsc::Time::printTimestamp, seconds run into 9 digits of nanoseconds
+     * @param p - start of the zone, moved past the timestamp
+     * @return wall clock nanoseconds, 0 if malformed
+     */
+    int64_t parseTimestamp(const char *&p, const char *end)
+    {
+        while (p < end && *p != ' ')
+            ++p;
+        ++p;
+        int64_t year, month, day, hour, minute, secondNanos;
+        int digits;
+        if (!readDigits(p, end, year, digits) || p >= end || *p++ != '-' ||
+            !readDigits(p, end, month, digits) || p >= end || *p++ != '-' ||
+            !readDigits(p, end, day, digits) || p >= end || *p++ != ' ' ||
+            !readDigits(p, end, hour, digits) || p >= end || *p++ != ':' ||
+            !readDigits(p, end, minute, digits) || p >= end || *p++ != ':' ||
+            !readDigits(p, end, secondNanos, digits) || digits < 10 || digits > 11 || month < 1 || month > 12)
+            return 0;
+        return ((daysFromCivil(year, month, day) * 24 + hour) * 60 + minute) * 60 * NANOS_IN_SEC + secondNanos;
+    }
+
+    // "2021-06-05 09:15:03.000000123"
+    void formatTimestamp(char (&buffer)[40], int64_t timestamp)
+    {
+        int64_t days = timestamp / (86400 * NANOS_IN_SEC);
+        int64_t nanosOfDay = timestamp % (86400 * NANOS_IN_SEC);
+        if (nanosOfDay < 0)
+        {
+            nanosOfDay += 86400 * NANOS_IN_SEC;
+            --days;
+        }
+        days += 719468;
+        int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+        int64_t dayOfEra = days - era * 146097;
+        int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        int64_t monthIndex = (5 * dayOfYear + 2) / 153;
+        int64_t day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+        int64_t month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+        int64_t year = yearOfEra + era * 400 + (month <= 2);
+        int64_t seconds = nanosOfDay / NANOS_IN_SEC;
+        snprintf(buffer, sizeof(buffer), "%04lld-%02lld-%02lld %02lld:%02lld:%02lld.%09lld", (long long)year, (long long)month, (long long)day,
+                 (long long)(seconds / 3600), (long long)(seconds / 60 % 60), (long long)(seconds % 60), (long long)(nanosOfDay % NANOS_IN_SEC));
+    }
+
+    /**
+     * @brief next { } object of a doubled quote JSON array, objects of these columns do not nest
+     */
+    bool nextJsonObject(const char *&p, const char *end, Field &object)
+    {
+        const char *open = (const char *)memchr(p, '{', end - p);
+        if (open == NULL)
+            return false;
+        const char *close = (const char *)memchr(open, '}', end - open);
+        if (close == NULL)
+            return false;
+        object.begin = open + 1;
+        object.end = close;
+        p = close + 1;
+        return true;
+    }
+
+    /**
+     * @brief value of ""key"" in a doubled quote JSON object, string values without their quotes
+     */
+    bool findJsonValue(const Field &object, const char *key, Field &value)
+    {
+        size_t keyLength = strlen(key);
+        const char *p = object.begin;
+        while (p + keyLength + 4 <= object.end)
+        {
+            p = (const char *)memchr(p, '"', object.end - p);
+            if (p == NULL || p + keyLength + 4 > object.end)
+                return false;
+            if (p[1] == '"' && memcmp(p + 2, key, keyLength) == 0 && p[keyLength + 2] == '"' && p[keyLength + 3] == '"')
+            {
+                const char *v = p + keyLength + 4;
+                while (v < object.end && (*v == ':' || *v == ' '))
+                    ++v;
+                if (v + 1 < object.end && v[0] == '"' && v[1] == '"')
+                    v += 2;
+                value.begin = v;
+                while (v < object.end && *v != '"' && *v != ',' && *v != '}' && *v != ' ')
+                    ++v;
+                value.end = v;
+                return true;
+            }
+            ++p;
+        }
+        return false;
+    }
+
+    // price of the ""BP"" key of the first or last object of a book column
+    int64_t getBookPrice(const Field &column, bool isLast)
+    {
+        const char *p = column.begin;
+        Field object, value;
+        int64_t price = 0;
+        while (nextJsonObject(p, column.end, object))
+        {
+            if (!findJsonValue(object, "BP", value) || !parseInt(value, price))
+                price = 0;
+            if (!isLast)
+                break;
+        }
+        return price;
+    }
+
+    StrategyReport &getStrategy(FileReport &report, const Field &contract)
+    {
+        for (size_t i = 0; i < report.strategies.size(); ++i)
+            if (report.strategies[i].contract.size() == contract.size() && memcmp(report.strategies[i].contract.data(), contract.begin, contract.size()) == 0)
+                return report.strategies[i];
+        report.strategies.push_back(StrategyReport());
+        report.strategies.back().contract = contract.str();
+        return report.strategies.back();
+    }
+
+    /**
+     * @brief STG_SNAPSHOT line, its prefix (DEBUG_PRINT file, line and function) is skipped
+     * @return false if the line is not an STG_SNAPSHOT line
+     */
+    bool analyzeSnapshot(const Field *fields, size_t count, int64_t intervalNanos, FileReport &report)
+    {
+        size_t marker = 0;
+        while (marker < count && marker < 4)
+        {
+            const Field &field = fields[marker];
+            size_t length = sizeof("STG_SNAPSHOT") - 1;
+            if (field.size() >= length && memcmp(field.end - length, "STG_SNAPSHOT", length) == 0 &&
+                (field.size() == length || field.end[-(int)length - 1] == ' '))
+                break;
+            ++marker;
+        }
+        if (marker == count || marker == 4)
+            return false;
+        const Field *f = fields + marker;
+        // column header line
+        if (count - marker > SnapshotField_TIMESTAMP && f[SnapshotField_TIMESTAMP].equals("Timestamp"))
+            return true;
+
+        ++report.snapshotLines;
+        if (count - marker < SnapshotField_COUNT)
+        {
+            ++report.unparsedLines;
+            return true;
+        }
+        const char *p = f[SnapshotField_TIMESTAMP].begin;
+        int64_t timestamp = parseTimestamp(p, f[SnapshotField_TIMESTAMP].end);
+        int64_t netPos, msgSentCount, buyTradedQty, sellTradedQty;
+        double grossPnL, netPnL;
+        if (timestamp == 0 || !parseInt(f[SnapshotField_NET_POS], netPos) || !parseDouble(f[SnapshotField_GROSS_PNL], grossPnL) ||
+            !parseDouble(f[SnapshotField_NET_PNL], netPnL) || !parseInt(f[SnapshotField_SENT_MSG_COUNT], msgSentCount) ||
+            !parseInt(f[SnapshotField_TBTQ], buyTradedQty) || !parseInt(f[SnapshotField_TSTQ], sellTradedQty))
+        {
+            ++report.unparsedLines;
+            return true;
+        }
+        StrategyReport &strategy = getStrategy(report, f[SnapshotField_CONTRACT]);
+        if (strategy.snapshots++ == 0)
+        {
+            strategy.firstTimestamp = timestamp;
+            strategy.minNetPos = strategy.maxNetPos = netPos;
+            strategy.minNetPnL = strategy.maxNetPnL = netPnL;
+            strategy.firstMsgSentCount = msgSentCount;
+        }
+        strategy.lastTimestamp = timestamp;
+        strategy.netPos = netPos;
+        strategy.minNetPos = std::min(strategy.minNetPos, netPos);
+        strategy.maxNetPos = std::max(strategy.maxNetPos, netPos);
+        strategy.grossPnL = grossPnL;
+        strategy.netPnL = netPnL;
+        strategy.minNetPnL = std::min(strategy.minNetPnL, netPnL);
+        strategy.maxNetPnL = std::max(strategy.maxNetPnL, netPnL);
+        strategy.maxDrawdown = std::max(strategy.maxDrawdown, strategy.maxNetPnL - netPnL);
+        strategy.msgSentCount = msgSentCount;
+        strategy.buyTradedQty = buyTradedQty;
+        strategy.sellTradedQty = sellTradedQty;
+
+        // bid column is printed deepest level first, ask column best level first
+        int64_t bestBid = getBookPrice(f[SnapshotField_BOOK_SNAPSHOT_BID], true);
+        int64_t bestAsk = getBookPrice(f[SnapshotField_BOOK_SNAPSHOT_ASK], false);
+        if (bestBid > 0 && bestAsk > bestBid)
+        {
+            strategy.spreadSum += bestAsk - bestBid;
+            ++strategy.spreadCount;
+        }
+        const char *orders = f[SnapshotField_ACTIVE_ORDER_BOOK].begin;
+        Field order, isReset;
+        while (nextJsonObject(orders, f[SnapshotField_ACTIVE_ORDER_BOOK].end, order))
+            if (findJsonValue(order, "IsReset", isReset) && isReset.equals("0"))
+                ++strategy.openOrderSum;
+
+        CurvePoint point = {timestamp, netPos, grossPnL, netPnL, msgSentCount};
+        if (!strategy.curve.empty() && intervalNanos > 0 && strategy.curve.back().timestamp / intervalNanos == timestamp / intervalNanos)
+            strategy.curve.back() = point;
+        else
+            strategy.curve.push_back(point);
+        return true;
+    }
+
+    // " Key: value" field of a CONFIRMATION line
+    bool findConfirmationValue(const Field *fields, size_t count, const char *key, int64_t &value)
+    {
+        size_t keyLength = strlen(key);
+        for (size_t i = 1; i < count; ++i)
+        {
+            Field field = fields[i];
+            while (field.begin < field.end && *field.begin == ' ')
+                ++field.begin;
+            if (field.size() > keyLength + 2 && memcmp(field.begin, key, keyLength) == 0 && field.begin[keyLength] == ':')
+            {
+                field.begin += keyLength + 2;
+                return parseInt(field, value);
+            }
+        }
+        return false;
+    }
+
+    // "CONFIRMATION | IST 2021-6-5 9:15:3000000123 onConfirmed BuySellType: BUY, ..." of the confirmation log
+    void analyzeConfirmation(const Field *fields, size_t count, const char *lineBegin, FileReport &report)
+    {
+        ++report.confirmationLines;
+        ConfirmationReport &confirmations = report.confirmations;
+        const char *p = lineBegin + sizeof("CONFIRMATION | ") - 1;
+        const char *end = fields[0].end;
+        int64_t timestamp = parseTimestamp(p, end);
+        if (timestamp == 0 || p >= end || *p != ' ')
+        {
+            ++report.unparsedLines;
+            return;
+        }
+        const char *callback = ++p;
+        while (p < end && *p != ' ')
+            ++p;
+        int event = 0;
+        for (; event < API2::COMMON::OrderEvent_MAX; ++event)
+        {
+            const char *name = API2::COMMON::OrderEventStr((API2::COMMON::OrderEvent)event);
+            if (strlen(name) == (size_t)(p - callback) && memcmp(name, callback, p - callback) == 0)
+                break;
+        }
+        if (event == API2::COMMON::OrderEvent_MAX)
+        {
+            ++confirmations.unknownCount;
+            return;
+        }
+        ++confirmations.counts[event];
+
+        int64_t clOrderId, lastFillQuantity;
+        if (!findConfirmationValue(fields, count, "ClOrderId", clOrderId))
+            return;
+        if (event == API2::COMMON::OrderEvent_FILLED || event == API2::COMMON::OrderEvent_PARTIAL_FILL)
+            if (findConfirmationValue(fields, count, "LastFillQuantity", lastFillQuantity))
+                confirmations.filledQty += lastFillQuantity;
+        if (event == API2::COMMON::OrderEvent_CONFIRMED)
+            confirmations.confirmedAt[(uint64_t)clOrderId] = timestamp;
+        else if (event == API2::COMMON::OrderEvent_FILLED || event == API2::COMMON::OrderEvent_CANCELED || event == API2::COMMON::OrderEvent_IOC_CANCELED)
+        {
+            std::unordered_map<uint64_t, int64_t>::iterator confirmed = confirmations.confirmedAt.find((uint64_t)clOrderId);
+            if (confirmed != confirmations.confirmedAt.end())
+            {
+                confirmations.orderLifetime.record(timestamp - confirmed->second);
+                confirmations.confirmedAt.erase(confirmed);
+            }
+        }
+    }
+
+    Field trim(Field field)
+    {
+        while (field.begin < field.end && *field.begin == ' ')
+            ++field.begin;
+        while (field.end > field.begin && field.end[-1] == ' ')
+            --field.end;
+        return field;
+    }
+
+    // "DEALER ID,LOGIN/LOGOUT,PASS/FAIL,IP ADDRESS,TIME"
+    void analyzeLogin(const Field *fields, size_t count, FileReport &report)
+    {
+        if (count == 1 && fields[0].size() == 0)
+            return;
+        ++report.loginLines;
+        if (count < 5)
+        {
+            ++report.unparsedLines;
+            return;
+        }
+        SessionEvent event;
+        event.dealer = trim(fields[0]).str();
+        event.action = trim(fields[1]).str();
+        event.result = trim(fields[2]).str();
+        event.ipAddress = trim(fields[3]).str();
+        event.time = trim(fields[4]).str();
+
+        DealerReport *dealer = NULL;
+        for (size_t i = 0; i < report.dealers.size() && dealer == NULL; ++i)
+            if (report.dealers[i].dealer == event.dealer)
+                dealer = &report.dealers[i];
+        if (dealer == NULL)
+        {
+            report.dealers.push_back(DealerReport());
+            dealer = &report.dealers.back();
+            dealer->dealer = event.dealer;
+            dealer->firstTime = event.time;
+        }
+        dealer->lastTime = event.time;
+        if (event.action == "LOGOUT")
+            ++dealer->logouts;
+        else if (event.result == "PASS")
+            ++dealer->logins;
+        else
+            ++dealer->failedLogins;
+        if (std::find(dealer->ipAddresses.begin(), dealer->ipAddresses.end(), event.ipAddress) == dealer->ipAddresses.end())
+            dealer->ipAddresses.push_back(event.ipAddress);
+        report.sessionEvents.push_back(event);
+    }
+
+    void analyzeFile(const std::string &path, const Options &options, FileReport &report)
+    {
+        report.path = path;
+        MappedFile file;
+        if (!file.open(path, report.error))
+            return;
+        report.bytes = file.size();
+
+        DelimiterScanner lines("\n");
+        DelimiterScanner fieldScanner(",\"");
+        Field fields[MAX_FIELDS];
+        const char *begin = file.begin();
+        const char *end = file.end();
+        lines.reset(begin, end);
+        while (begin < end)
+        {
+            const char *lineEnd = lines.next();
+            const char *next = lineEnd < end ? lineEnd + 1 : end;
+            if (lineEnd > begin && lineEnd[-1] == '\r')
+                --lineEnd;
+            size_t count = splitFields(fieldScanner, begin, lineEnd, fields, MAX_FIELDS);
+            if (report.lines++ == 0 && count == 5 && fields[0].equals("DEALER ID") && fields[1].equals("LOGIN/LOGOUT"))
+                report.isLoginLog = true;
+            else if (report.isLoginLog)
+                analyzeLogin(fields, count, report);
+            else if ((size_t)(lineEnd - begin) > sizeof("CONFIRMATION | ") - 1 && memcmp(begin, "CONFIRMATION | ", sizeof("CONFIRMATION | ") - 1) == 0)
+                analyzeConfirmation(fields, count, begin, report);
+            else
+                analyzeSnapshot(fields, count, options.intervalNanos, report);
+            begin = next;
+        }
+    }
+
+    void writeJsonString(std::ostream &os, const std::string &text)
+    {
+        os << '"';
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            char c = text[i];
+            if (c == '"' || c == '\\')
+                os << '\\' << c;
+            else if ((unsigned char)c < 0x20)
+                os << ' ';
+            else
+                os << c;
+        }
+        os << '"';
+    }
+
+    void writeStrategy(std::ostream &os, const FileReport &file, const StrategyReport &strategy)
+    {
+        char buffer[1024];
+        char first[40], last[40];
+        formatTimestamp(first, strategy.firstTimestamp);
+        formatTimestamp(last, strategy.lastTimestamp);
+        double durationSec = (double)(strategy.lastTimestamp - strategy.firstTimestamp) / NANOS_IN_SEC;
+        os << "    {\"file\": ";
+        writeJsonString(os, file.path);
+        os << ", \"contract\": ";
+        writeJsonString(os, strategy.contract);
+        int length = snprintf(buffer, sizeof(buffer),
+                              ", \"snapshots\": %llu, \"first\": \"%s\", \"last\": \"%s\", \"net_pos\": %lld, \"min_net_pos\": %lld, \"max_net_pos\": %lld,"
+                              " \"gross_pnl\": %.2f, \"net_pnl\": %.2f, \"min_net_pnl\": %.2f, \"max_net_pnl\": %.2f, \"max_drawdown\": %.2f,"
+                              " \"msg_sent_count\": %lld, \"msg_per_sec\": %.2f, \"buy_traded_qty\": %lld, \"sell_traded_qty\": %lld,"
+                              " \"mean_spread\": %.2f, \"mean_open_orders\": %.2f,\n      \"curve\": [",
+                              (unsigned long long)strategy.snapshots, first, last, (long long)strategy.netPos, (long long)strategy.minNetPos, (long long)strategy.maxNetPos,
+                              strategy.grossPnL, strategy.netPnL, strategy.minNetPnL, strategy.maxNetPnL, strategy.maxDrawdown,
+                              (long long)strategy.msgSentCount, durationSec > 0 ? (strategy.msgSentCount - strategy.firstMsgSentCount) / durationSec : 0.0,
+                              (long long)strategy.buyTradedQty, (long long)strategy.sellTradedQty,
+                              strategy.spreadCount ? strategy.spreadSum / strategy.spreadCount : 0.0, (double)strategy.openOrderSum / strategy.snapshots);
+        os.write(buffer, length);
+        for (size_t i = 0; i < strategy.curve.size(); ++i)
+        {
+            const CurvePoint &point = strategy.curve[i];
+            formatTimestamp(first, point.timestamp);
+            length = snprintf(buffer, sizeof(buffer), "%s\n        [\"%s\", %lld, %.2f, %.2f, %lld]", i ? "," : "", first,
+                              (long long)point.netPos, point.grossPnL, point.netPnL, (long long)point.msgSentCount);
+            os.write(buffer, length);
+        }
+        os << "]}";
+    }
+
+    void writeReport(std::ostream &os, const std::vector<FileReport> &reports, const Options &options, double elapsedMs)
+    {
+        uint64_t bytes = 0;
+        for (size_t i = 0; i < reports.size(); ++i)
+            bytes += reports[i].bytes;
+        char buffer[512];
+        os << "{\n";
+        os << "  \"analyzer\": \"templateAlgo_logAnalyzer\",\n";
+        os << "  \"timestamp\": " << time(NULL) << ",\n";
+        int length = snprintf(buffer, sizeof(buffer), "  \"interval_sec\": %lld,\n  \"threads\": %d,\n  \"bytes\": %llu,\n  \"elapsed_ms\": %.1f,\n  \"mb_per_sec\": %.1f,\n",
+                              (long long)(options.intervalNanos / NANOS_IN_SEC), options.threads, (unsigned long long)bytes, elapsedMs,
+                              elapsedMs > 0 ? bytes / 1048576.0 / (elapsedMs / 1000) : 0.0);
+        os.write(buffer, length);
+
+        os << "  \"files\": [\n";
+        for (size_t i = 0; i < reports.size(); ++i)
+        {
+            const FileReport &r = reports[i];
+            os << "    {\"path\": ";
+            writeJsonString(os, r.path);
+            length = snprintf(buffer, sizeof(buffer),
+                              ", \"bytes\": %llu, \"lines\": %llu, \"snapshot_lines\": %llu, \"confirmation_lines\": %llu, \"login_lines\": %llu, \"unparsed_lines\": %llu",
+                              (unsigned long long)r.bytes, (unsigned long long)r.lines, (unsigned long long)r.snapshotLines,
+                              (unsigned long long)r.confirmationLines, (unsigned long long)r.loginLines, (unsigned long long)r.unparsedLines);
+            os.write(buffer, length);
+            if (!r.error.empty())
+            {
+                os << ", \"error\": ";
+                writeJsonString(os, r.error);
+            }
+            os << "}" << (i + 1 < reports.size() ? "," : "") << "\n";
+        }
+        os << "  ],\n";
+
+        os << "  \"strategies\": [";
+        bool isFirst = true;
+        for (size_t i = 0; i < reports.size(); ++i)
+            for (size_t s = 0; s < reports[i].strategies.size(); ++s)
+            {
+                os << (isFirst ? "\n" : ",\n");
+                isFirst = false;
+                writeStrategy(os, reports[i], reports[i].strategies[s]);
+            }
+        os << "\n  ],\n";
+
+        os << "  \"confirmations\": [";
+        isFirst = true;
+        for (size_t i = 0; i < reports.size(); ++i)
+        {
+            const ConfirmationReport &c = reports[i].confirmations;
+            if (reports[i].confirmationLines == 0)
+                continue;
+            os << (isFirst ? "\n" : ",\n") << "    {\"file\": ";
+            isFirst = false;
+            writeJsonString(os, reports[i].path);
+            os << ", \"callbacks\": {";
+            for (int event = 0; event < API2::COMMON::OrderEvent_MAX; ++event)
+                os << (event ? ", \"" : "\"") << API2::COMMON::OrderEventStr((API2::COMMON::OrderEvent)event) << "\": " << c.counts[event];
+            os << ", \"unknown\": " << c.unknownCount << "}, \"filled_qty\": " << c.filledQty << ", \"open_orders\": " << c.confirmedAt.size();
+            os << ",\n      \"order_lifetime\": ";
+            c.orderLifetime.write(os);
+            os << "}";
+        }
+        os << "\n  ],\n";
+
+        os << "  \"sessions\": [";
+        isFirst = true;
+        for (size_t i = 0; i < reports.size(); ++i)
+        {
+            const FileReport &r = reports[i];
+            if (!r.isLoginLog)
+                continue;
+            os << (isFirst ? "\n" : ",\n") << "    {\"file\": ";
+            isFirst = false;
+            writeJsonString(os, r.path);
+            os << ",\n      \"dealers\": [";
+            for (size_t d = 0; d < r.dealers.size(); ++d)
+            {
+                const DealerReport &dealer = r.dealers[d];
+                os << (d ? ",\n" : "\n") << "        {\"dealer\": ";
+                writeJsonString(os, dealer.dealer);
+                os << ", \"logins\": " << dealer.logins << ", \"failed_logins\": " << dealer.failedLogins << ", \"logouts\": " << dealer.logouts << ", \"first\": ";
+                writeJsonString(os, dealer.firstTime);
+                os << ", \"last\": ";
+                writeJsonString(os, dealer.lastTime);
+                os << ", \"ip_addresses\": [";
+                for (size_t a = 0; a < dealer.ipAddresses.size(); ++a)
+                {
+                    os << (a ? ", " : "");
+                    writeJsonString(os, dealer.ipAddresses[a]);
+                }
+                os << "]}";
+            }
+            os << "],\n      \"events\": [";
+            for (size_t e = 0; e < r.sessionEvents.size(); ++e)
+            {
+                const SessionEvent &event = r.sessionEvents[e];
+                os << (e ? ",\n" : "\n") << "        [";
+                writeJsonString(os, event.time);
+                os << ", ";
+                writeJsonString(os, event.dealer);
+                os << ", ";
+                writeJsonString(os, event.action);
+                os << ", ";
+                writeJsonString(os, event.result);
+                os << ", ";
+                writeJsonString(os, event.ipAddress);
+                os << "]";
+            }
+            os << "]}";
+        }
+        os << "\n  ]\n}\n";
+    }
+
+    bool parseOptions(int argc, char **argv, Options &options)
+    {
+        options.intervalNanos = 60 * NANOS_IN_SEC;
+        options.threads = std::max(1, (int)std::thread::hardware_concurrency());
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg.compare(0, 2, "--") != 0)
+            {
+                options.files.push_back(arg);
+                continue;
+            }
+            if (i + 1 >= argc)
+                return false;
+            if (arg == "--interval-sec")
+                options.intervalNanos = atoll(argv[++i]) * NANOS_IN_SEC;
+            else if (arg == "--threads")
+                options.threads = std::max(1, atoi(argv[++i]));
+            else if (arg == "--out")
+                options.out = argv[++i];
+            else
+                return false;
+        }
+        return !options.files.empty();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "usage: %s [--interval-sec <s>] [--threads <n>] [--out <report.json>] <log file> [<log file> ...]\n", argv[0]);
+        return 2;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<FileReport> reports(options.files.size());
+    std::atomic<size_t> nextFile(0);
+    auto worker = [&]()
+    {
+        for (size_t i = nextFile++; i < options.files.size(); i = nextFile++)
+            analyzeFile(options.files[i], options, reports[i]);
+    };
+    options.threads = std::min(options.threads, (int)options.files.size());
+    std::vector<std::thread> threads;
+    for (int i = 1; i < options.threads; ++i)
+        threads.push_back(std::thread(worker));
+    worker();
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    int status = 0;
+    for (size_t i = 0; i < reports.size(); ++i)
+        if (!reports[i].error.empty())
+        {
+            fprintf(stderr, "%s\n", reports[i].error.c_str());
+            status = 1;
+        }
+    if (options.out.empty())
+        writeReport(std::cout, reports, options, elapsedMs);
+    else
+    {
+        std::ofstream file(options.out.c_str());
+        writeReport(file, reports, options, elapsedMs);
+    }
+    return status;
+}
@@ -1,9 +1,145 @@
 #include "template.h"
 #include "apiConstants.h"
 #include "../wscCommon/ini.hpp"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace SampleTemplate
 {
+    std::ostream &operator<<(std::ostream &os, const OrderStr &orderStr)
+    {
+        const API2::COMMON::OrderWrapper &order = orderStr.order;
+        os << "\"\", \"\"BuySellType\"\": \"\"" << wsc::BuySellTypeStr(order._mode)
+           << "\"\", \"\"ContractName\"\": \"\"" << order._instrument->getStaticData()->scripName
+           << "\"\", \"\"OrderType\"\": \"\"" << order._orderType
+           << "\"\", \"\"ExchOrderId\"\": " << order._exchangeOrderId
+           << ", \"\"IsReset\"\": \"\"" << order._isReset
+           << "\"\", \"\"Price\"\": " << order._price
+           << "\"\", \"\"LastQuotedPrice\"\": " << order._lastQuotedPrice
+           << ", \"\"Quantity\"\": " << order._lastQuantity
+           << ", \"\"QuantityTraded\"\": " << order._lastFilledQuantity
+           << "\"\"";
+        return os;
+    }
+
+    // same fields as OrderStr, from the captured copy
+    static std::ostream &operator<<(std::ostream &os, const wsc::SnapshotOrder &order)
+    {
+        os << "\"\", \"\"BuySellType\"\": \"\"" << wsc::BuySellTypeStr(order.mode)
+           << "\"\", \"\"ContractName\"\": \"\"" << order.contractName
+           << "\"\", \"\"OrderType\"\": \"\"" << order.orderType
+           << "\"\", \"\"ExchOrderId\"\": " << order.exchangeOrderId
+           << ", \"\"IsReset\"\": \"\"" << order.isReset
+           << "\"\", \"\"Price\"\": " << order.price
+           << "\"\", \"\"LastQuotedPrice\"\": " << order.lastQuotedPrice
+           << ", \"\"Quantity\"\": " << order.lastQuantity
+           << ", \"\"QuantityTraded\"\": " << order.lastFilledQuantity
+           << "\"\"";
+        return os;
+    }
+
+    // reads <PREFIX>_CPUS, <PREFIX>_FIFO_PRIORITY, <PREFIX>_BUSY_POLL, <PREFIX>_IDLE_SLEEP_MICROS, missing keys keep defaults
+    static void readThreadPlacement(mINI::INIMap<std::string> &config, const std::string &prefix, API2::COMMON::ThreadPlacement &placement)
+    {
+        if (!config[prefix + "_CPUS"].empty() && !API2::COMMON::parseCpuList(config[prefix + "_CPUS"], placement.cpus))
+            throw std::string("Invalid " + prefix + "_CPUS");
+        if (!config[prefix + "_FIFO_PRIORITY"].empty())
+            placement.fifoPriority = boost::lexical_cast<int>(config[prefix + "_FIFO_PRIORITY"]);
+        if (!config[prefix + "_BUSY_POLL"].empty())
+            placement.isBusyPoll = boost::lexical_cast<bool>(config[prefix + "_BUSY_POLL"]);
+        if (!config[prefix + "_IDLE_SLEEP_MICROS"].empty())
+            placement.idleSleepMicros = boost::lexical_cast<int>(config[prefix + "_IDLE_SLEEP_MICROS"]);
+    }
+
+    // worker placement starts from the AUX one, keys of the worker prefix override it
+    static void readWorkerPlacement(mINI::INIMap<std::string> &config, const std::string &prefix, const API2::COMMON::ThreadPlacement &aux, API2::COMMON::ThreadPlacement &placement)
+    {
+        std::string name = placement.name;
+        placement = aux;
+        placement.name = name;
+        readThreadPlacement(config, prefix, placement);
+    }
+
+    // [SOURCE] [EXCHANGE] [SYMBOL] [Expiry1(YYYYMMDD)] [Expiry2(YYYYMMDD)] [StrikePrice] [C/P(For Call/Put)]
+    static std::string getSymbolName(const std::string &source, const std::string &exchange, const std::string &symbol, const std::string &expiary, const std::string &strikePrice, const std::string &optType)
+    {
+        std::string symbolName = source + " " + exchange + " " + symbol;
+        if (expiary.length() > 0)
+            symbolName += " " + expiary;
+        if (strikePrice.length() > 0)
+            symbolName += " " + strikePrice;
+        if (optType.length() > 0)
+            symbolName += " " + optType;
+        return symbolName;
+    }
+
+    // no further fill can come for an order in such a state, any other state may still be working at exchange
+    static bool isOrderStatusDone(API2::DATA_TYPES::OrderStatus status)
+    {
+        return status == API2::CONSTANTS::RSP_OrderStatus_FILLED ||
+               status == API2::CONSTANTS::RSP_OrderStatus_CANCELED ||
+               status == API2::CONSTANTS::RSP_OrderStatus_NEW_REJECTED ||
+               status == API2::CONSTANTS::RSP_OrderStatus_CANCELED_OF_IOC ||
+               status == API2::CONSTANTS::RSP_OrderStatus_RMS_REJECT;
+    }
+
+    // one write per line to the report log, a line is never split by a line of another thread.
+    // Without REPORT_LOG_DIR lines go to stdout: still written whole, but DEBUG_PRINT streams its lines to std::cout
+    // piece by piece, so a report line may land inside a debug line of another thread
+    static void writeReportLine(int fd, const char *line, size_t length)
+    {
+        if (fd < 0)
+        {
+            std::cout.write(line, length);
+            std::cout.flush();
+            return;
+        }
+        while (length > 0)
+        {
+            ssize_t written = ::write(fd, line, length);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return;
+            line += written;
+            length -= written;
+        }
+    }
+
+    // logging thread, one line per confirmation record, nothing of the strategy state is read here
+    static void printConfirmation(const wsc::ConfirmationRecord &record, int reportLogFd)
+    {
+        std::ostringstream ss;
+        ss << "CONFIRMATION | ";
+        wsc::Time::printTimestamp(ss, record.timestamp);
+        ss << " " << record.callback
+           << " BuySellType: " << wsc::BuySellTypeStr(record.orderMode)
+           << ", ContractName: " << record.symbolId
+           << ", OrderType: " << record.orderType
+           << ", ClOrderId: " << record.clOrderId
+           << ", ExchOrderId: " << record.exchangeOrderId
+           << ", OrderStatus: " << record.orderStatus
+           << ", ErrorCode: " << record.errorCode
+           << ", OrigOrderPrice: " << record.origOrderPrice
+           << ", OrderPrice: " << record.orderPrice
+           << ", Quantity: " << record.orderQuantity
+           << ", OrigLastFillPrice: " << record.origLastFillPrice
+           << ", LastFillPrice: " << record.lastFillPrice
+           << ", LastFillQuantity: " << record.lastFillQuantity;
+        if (record.wrapperIndex < 0)
+            ss << ", Wrapper: none";
+        else
+            ss << ", Wrapper: " << (record.isBuyWrapper ? "BUY" : "SELL") << "[" << record.wrapperIndex << "]"
+               << ", Processed: " << record.isProcessed
+               << ", IsReset: " << record.isReset
+               << ", LastQuotedPrice: " << record.lastQuotedPrice
+               << ", LastQuantity: " << record.lastQuantity
+               << ", QuantityTraded: " << record.lastFilledQuantity;
+        ss << "\n";
+        const std::string &line = ss.str();
+        writeReportLine(reportLogFd, line.data(), line.size());
+    }
 
     // Template class constructor
     // It Recieves the Parameter Structure from the Bid Driver Function
@@ -13,15 +149,31 @@ namespace SampleTemplate
                                                            _terminateCheck(false)
     {
         DEBUG_PRINT;
+        _debugLog.setFallback(reqQryDebugLog());
         //Set Parameters
         API2::UserParams *customParams = (API2::UserParams *)params->getInfo();
         if (!setInternalParameters(customParams, _userParams))
         {
-            DEBUG_MESSAGE(reqQryDebugLog(), "Parameters not set from front end");
+            DEBUG_MESSAGE(debugLog(), "Parameters not set from front end");
             terminateStrategyComment(API2::CONSTANTS::RSP_StrategyComment_STRATEGY_ERROR_STATE);
             return;
         }
 
+        start();
+    }
+
+    Template::Template(API2::StrategyParameters *params, const FrontEndParameters &userParams) : API2::SGContext(params, "Template"),
+                                                                                                 _userParams(userParams),
+                                                                                                 _terminateCheck(false)
+    {
+        DEBUG_PRINT;
+        _debugLog.setFallback(reqQryDebugLog());
+        start();
+    }
+
+    //Set up instruments, orders and config, setup failures terminate the strategy
+    void Template::start()
+    {
         try
         {
             initSetUp();
@@ -29,7 +181,7 @@ namespace SampleTemplate
         catch (API2::MarketDataSubscriptionFailedException &e)
         {
             DEBUG_PRINT << e.what();
-            DEBUG_MESSAGE(reqQryDebugLog(), "TBT subscription Failed");
+            DEBUG_MESSAGE(debugLog(), "TBT subscription Failed");
             terminateStrategyComment(API2::CONSTANTS::
                                          RSP_StrategyComment_STRATEGY_ERROR_STATE);
             // return;
@@ -37,7 +189,7 @@ namespace SampleTemplate
         catch (API2::InstrumentNotFoundException &e)
         {
             DEBUG_PRINT << e.what();
-            DEBUG_MESSAGE(reqQryDebugLog(), "Instrument Not Found");
+            DEBUG_MESSAGE(debugLog(), "Instrument Not Found");
             terminateStrategyComment(API2::CONSTANTS::
                                          RSP_StrategyComment_STRATEGY_ERROR_STATE);
             // return;
@@ -45,34 +197,196 @@ namespace SampleTemplate
         catch (std::exception &e)
         {
             DEBUG_PRINT << e.what();
-            DEBUG_MESSAGE(reqQryDebugLog(), "standard exception raised");
+            DEBUG_MESSAGE(debugLog(), "standard exception raised");
             terminateStrategyComment(API2::CONSTANTS::
                                          RSP_StrategyComment_STRATEGY_ERROR_STATE);
             // return;
         }
     }
 
+    Template::~Template()
+    {
+        _confirmationLog.stop();
+        _persistWriter.close();
+        _snapshotLog.stop();
+        if (_reportLogFd >= 0)
+            ::close(_reportLogFd);
+        _debugLog.close();
+#ifdef ALLOCATION_COUNTING
+        API2::COMMON::AllocationScope::report();
+#endif
+        for (size_t i = 0; i < _buyOrderBook.size(); i++)
+            API2::COMMON::OrderWrapperPool::shared().release(_buyOrderBook[i]);
+        for (size_t i = 0; i < _sellOrderBook.size(); i++)
+            API2::COMMON::OrderWrapperPool::shared().release(_sellOrderBook[i]);
+        for (int side = 0; side < 2; side++)
+            for (size_t i = 0; i < _sliceOrderBook[side].size(); i++)
+                API2::COMMON::OrderWrapperPool::shared().release(_sliceOrderBook[side][i]);
+    }
+
     /* ---------------------------------------------Workflow Functions --------------------------------------------------*/
 
     //Recieve Callbacks on Every Market Data Event
     //In this function,we can perform the calculations if any change in market corresponding to symbolId
     void Template::onMarketDataEvent(UNSIGNED_LONG symbolId)
     {
+        ALLOCATION_SCOPE("onMarketDataEvent");
         // DEBUG_PRINT;
         // DEBUG_MESSAGE(reqQryDebugLog(), "In onMarketDataEvent");
+        // other symbols are the option chain and underlying of the IV surface
+        if (symbolId != _contract->getSymbolId())
+        {
+            updateIvSurface(symbolId);
+            return;
+        }
         onBookSnapshot(symbolId);
     }
 
+    //Recieve Callbacks on Every Trade Tick of the TBT feed
+    //Tick is only copied into the ring, trade flow and bars take all queued ticks in one batch on the next market data / timer event
+    void Template::onTradeTickEvent(API2::DATA_TYPES::SYMBOL_ID symbolId, API2::COMMON::TradeTick tradeTick)
+    {
+        if ((UNSIGNED_LONG)symbolId == _contract->getSymbolId())
+            _tradeTicks.push(tradeTick);
+    }
+
     //Recieve Callbacks from reqTimerEvent
     //In this function,Call back when an timer set by reqTimerEvent expires
     //Here,after 1000000 microsecond i.e. 1 second this function gets the callback
     void Template::onTimerEvent()
     {
         // DEBUG_PRINT;
-        reqTimerEvent(wsc::appConfig::smConsumerInterval);
+        if (!_isThreadPlaced)
+            placeStrategyThread();
+        reqTimerEvent(_timerEventInterval);
+        int64_t now = wsc::Time::getSystemTimestamp();
+        _orderTimers.advance(now, [this](uint32_t kind, uint64_t data)
+                             { onOrderTimer(kind, data); });
+        pumpSquareOff();
+        checkLeftoverOrders();
+        // timer event runs every order timer tick while deadlines are on, the rest keeps to SM_CONSUMER_INTERVAL
+        if (now < _nextConsumerTimestamp)
+            return;
+        _nextConsumerTimestamp = now + wsc::appConfig::smConsumerInterval * NANO_SECONDS_IN_MICRO_SEC;
+        saveCheckpoint();
+        _checkpointFile.flush();
+        _calendar.update(wsc::Time::getTimestamp());
+        if (_ivSurface)
+            _ivSurface->setTimeToExpire(_ivSurfaceExpiry, _calendar.getFractionalTimeToExpire(_calendarIndex));
+        if (!_terminateCheck)
+            _riskLimits.refresh(_contract->getStaticData());
+        processTradeTicks();
+        // reported here, building the message on market data path would allocate
+        if (_tradeTicks.getOverflowCount() != _tradeTickOverflowCount)
+        {
+            _tradeTickOverflowCount = _tradeTicks.getOverflowCount();
+            DEBUG_MESSAGE(debugLog(), "Trade tick ring full, dropped ticks: " + std::to_string(_tradeTickOverflowCount));
+        }
+        if (_confirmationLog.getOverflowCount() != _confirmationOverflowCount)
+        {
+            _confirmationOverflowCount = _confirmationLog.getOverflowCount();
+            DEBUG_MESSAGE(debugLog(), "Confirmation log ring full, dropped records: " + std::to_string(_confirmationOverflowCount));
+        }
+        if (_persistWriter.getBlockedCount() != _persistBlockedCount)
+        {
+            _persistBlockedCount = _persistWriter.getBlockedCount();
+            DEBUG_MESSAGE(debugLog(), "Persist writer behind, confirmation logging waited for it: " + std::to_string(_persistBlockedCount) + " times");
+        }
+        if (_persistWriter.getErrorCount() != _persistErrorCount)
+        {
+            _persistErrorCount = _persistWriter.getErrorCount();
+            DEBUG_MESSAGE(debugLog(), "Persist batches not written: " + std::to_string(_persistErrorCount) + ", last error: " + _persistWriter.getLastError());
+        }
+        uint64_t debugLogDropCount = _debugLog.getDropCount();
+        if (debugLogDropCount != _debugLogDropCount)
+        {
+            _debugLogDropCount = debugLogDropCount;
+            DEBUG_MESSAGE(debugLog(), "Debug log slab full, dropped lines: " + std::to_string(_debugLogDropCount));
+        }
+        uint64_t illegalTransitionCount = _buyOrderStates.getIllegalCount() + _sellOrderStates.getIllegalCount();
+        if (illegalTransitionCount != _illegalTransitionCount)
+        {
+            _illegalTransitionCount = illegalTransitionCount;
+            DEBUG_MESSAGE(debugLog(), "Order state transitions not allowed: " + std::to_string(_illegalTransitionCount));
+        }
+        if (_riskRejectCount != _reportedRiskRejectCount)
+        {
+            _reportedRiskRejectCount = _riskRejectCount;
+            DEBUG_MESSAGE(debugLog(), "Orders not sent on risk limits: " + std::to_string(_reportedRiskRejectCount));
+        }
+        if (_requoteThrottledCount != _reportedRequoteThrottledCount)
+        {
+            _reportedRequoteThrottledCount = _requoteThrottledCount;
+            DEBUG_MESSAGE(debugLog(), "Requote throttled, requotes left to next tick: " + std::to_string(_reportedRequoteThrottledCount));
+        }
+        if (_stuckOrderCount != _reportedStuckOrderCount)
+        {
+            _reportedStuckOrderCount = _stuckOrderCount;
+            DEBUG_MESSAGE(debugLog(), "Orders not confirmed in ack timeout: " + std::to_string(_reportedStuckOrderCount));
+        }
+        if (_orderTimers.getOverflowCount() != _orderTimerOverflowCount)
+        {
+            _orderTimerOverflowCount = _orderTimers.getOverflowCount();
+            DEBUG_MESSAGE(debugLog(), "Order timing wheel full, dropped timers: " + std::to_string(_orderTimerOverflowCount));
+        }
+        // throttled requote of a quiet book, no tick came since
+        if (_isRequotePending && wsc::appConfig::isRequoteOnConfirmation && takeRequoteSlot())
+            requote();
+        uint64_t snapshotMergedCount = _snapshotDeferredCount + _snapshotLog.getMergedCount();
+        if (snapshotMergedCount != _snapshotMergedCount)
+        {
+            _snapshotMergedCount = snapshotMergedCount;
+            DEBUG_MESSAGE(debugLog(), "Snapshot thread behind, merged snapshots: " + std::to_string(_snapshotMergedCount));
+        }
+        // confirmations deferred while the snapshot thread was behind
+        if (_isSnapshotPending)
+            logSnapshot();
+        _bars.onTimer(wsc::Time::getTimestamp());
+        _bars.dispatchClosedBars([this](size_t timeframe, const API2::COMMON::BarAggregator::Bar &bar)
+                                 { onBarClose(timeframe, bar); });
         onDefaultEvent();
     }
 
+    //Pin the callback thread on its first timer event, callbacks of this strategy are delivered on the same thread
+    void Template::placeStrategyThread()
+    {
+        DEBUG_PRINT;
+        _isThreadPlaced = true;
+        std::string error;
+        if (!wsc::appConfig::strategyThread.apply(error))
+            DEBUG_MESSAGE(debugLog(), "Thread placement: " + error);
+    }
+
+    //Scheduling jitter of the strategy cpus, measured at setup on a thread with the strategy placement before the strategy is started
+    void Template::calibrateStrategyJitter()
+    {
+        std::string error;
+        API2::COMMON::JitterReport report = API2::COMMON::calibrateJitter(wsc::appConfig::strategyThread, wsc::appConfig::jitterCalibrationMs * 1000LL, error);
+        if (!error.empty())
+            DEBUG_MESSAGE(debugLog(), "Jitter calibration thread placement: " + error);
+        std::stringstream ss;
+        ss << "Jitter calibration " << wsc::appConfig::jitterCalibrationMs << "ms, samples: " << report.samples
+           << ", max gap ns: " << report.maxGapNanos << ", p99 ns <= " << report.p99GapNanos
+           << ", p99.9 ns <= " << report.p999GapNanos << ", gaps over 10us: " << report.gapsOver10Micros;
+        DEBUG_PRINT << ss.str();
+        DEBUG_MESSAGE(debugLog(), ss.str());
+    }
+
+    //Called from onTimerEvent for every bar closed since previous timer event, oldest first
+    //Bar history of all timeframes is available through _bars.getBar
+    //A closed 1 minute bar wider than BAR_RANGE_PAUSE_TICKS pauses new positions until one closes within it, square off goes on
+    void Template::onBarClose(size_t timeframe, const API2::COMMON::BarAggregator::Bar &bar)
+    {
+        if (timeframe != BAR_RANGE_TIMEFRAME || _barRangePauseTicks <= 0)
+            return;
+        bool isPaused = bar.high - bar.low > (SIGNED_LONG)_barRangePauseTicks * _contract->getStaticData()->tickSize;
+        if (isPaused == _isBarRangePaused)
+            return;
+        _isBarRangePaused = isPaused;
+        _isRequotePending = true;
+        DEBUG_MESSAGE(debugLog(), std::string(isPaused ? "New positions paused" : "New positions resumed") + ", 1 minute bar range: " + std::to_string(bar.high - bar.low));
+    }
+
     //Strategy Driver event
     //onDefaultEvent Called as an event if Not configured to received marketData Event while Running strategy
     void Template::onDefaultEvent()
@@ -82,34 +396,39 @@ namespace SampleTemplate
     }
 
     //Method to do common work for all type of confirmations, confirmation status dependent work is done in specific methods
-    bool Template::processConfirmation(API2::COMMON::OrderWrapper &orderWrapper, API2::OrderConfirmation &confirmation, const API2::COMMON::OrderId *orderId)
+    //Nothing is formatted here, wrapper state after processing goes to the confirmation log record
+    //What happened to the order comes from the transition of the callback's event, the wrapper flags are read only for a transition not allowed
+    bool Template::processConfirmation(API2::COMMON::OrderWrapper &orderWrapper, API2::COMMON::OrderStateMachine &orderStates, size_t index, API2::COMMON::OrderEvent event, API2::OrderConfirmation &confirmation)
     {
-        DEBUG_PRINT;
-        reqQryDebugLog()->saveConfirmation(confirmation);
-        if (orderWrapper._orderId == orderId)
+        if (wsc::appConfig::saveConfirmationToDebugLog)
+            reqQryDebugLog()->saveConfirmation(confirmation);
+        API2::COMMON::OrderState previous = orderStates.getState(index);
+        API2::COMMON::OrderAction action = orderStates.onEvent(index, event);
+        auto ret = orderWrapper.processConfirmation(confirmation);
+        if (action == API2::COMMON::OrderAction_RESET)
+        {
+            if (!orderWrapper._isReset)
+                orderWrapper.reset();
+        }
+        else if (action == API2::COMMON::OrderAction_RESYNC)
         {
-            DEBUG_PRINT;
-            DEBUG_PRINT << getOrderStr(orderWrapper);
-            auto ret = orderWrapper.processConfirmation(confirmation);
-            DEBUG_PRINT << getOrderStr(orderWrapper);
-
             if (!orderWrapper._isReset && orderWrapper.getLastQuantity() == 0)
-            {
-                DEBUG_PRINT << getOrderStr(orderWrapper);
                 orderWrapper.reset();
-                DEBUG_PRINT << getOrderStr(orderWrapper);
-            }
-            return ret;
+            orderStates.setState(index, API2::COMMON::getOrderState(orderWrapper));
         }
-        return false;
+        updateOrderTimers(&orderStates == &_buyOrderStates, index, previous);
+        // order slot free again or position moved
+        if (orderWrapper._isReset || event == API2::COMMON::OrderEvent_PARTIAL_FILL)
+            _isRequotePending = true;
+        return ret;
     }
 
     //CallBack When a new Order gets confirmed by exchange
     //Here we typically update the corresponding order wrapper's state, update any strategy state variables
     void Template::onConfirmed(API2::OrderConfirmation &confirmation, API2::COMMON::OrderId *orderId)
     {
-        DEBUG_PRINT;
-        orderResHandler(confirmation, orderId);
+        ALLOCATION_SCOPE("onConfirmed");
+        orderResHandler(API2::COMMON::OrderEvent_CONFIRMED, confirmation, orderId);
         // if (!processConfirmation(_orderWrapper, confirmation, orderId))
         // {
         //     DEBUG_MESSAGE(reqQryDebugLog(), "Process Confirmation Failed");
@@ -119,8 +438,8 @@ namespace SampleTemplate
     //CallBack When a new order gets rejected by the exchange
     void Template::onNewReject(API2::OrderConfirmation &confirmation, API2::COMMON::OrderId *orderId)
     {
-        DEBUG_PRINT;
-        orderResHandler(confirmation, orderId);
+        ALLOCATION_SCOPE("onNewReject");
+        orderResHandler(API2::COMMON::OrderEvent_NEW_REJECT, confirmation, orderId);
         // if (!processConfirmation(_orderWrapper, confirmation, orderId))
         // {
         //     DEBUG_MESSAGE(reqQryDebugLog(), "Process Confirmation Failed");
@@ -130,8 +449,8 @@ namespace SampleTemplate
     //CallBack When an IOC order gets canceled by the exchange
     void Template::onIOCCanceled(API2::OrderConfirmation &confirmation, API2::COMMON::OrderId *orderId)
     {
-        DEBUG_PRINT;
-        orderResHandler(confirmation, orderId);
+        ALLOCATION_SCOPE("onIOCCanceled");
+        orderResHandler(API2::COMMON::OrderEvent_IOC_CANCELED, confirmation, orderId);
         // if (!processConfirmation(_orderWrapper, confirmation, orderId))
         // {
         //     DEBUG_MESSAGE(reqQryDebugLog(), "Process Confirmation Failed");
@@ -142,8 +461,8 @@ namespace SampleTemplate
     //Here we typically update the corresponding order wrapper's state, update any strategy member variables like self maintained custom positions etc
     void Template::onFilled(API2::OrderConfirmation &confirmation, API2::COMMON::OrderId *orderId)
     {
-        DEBUG_PRINT;
-        orderResHandler(confirmation, orderId);
+        ALLOCATION_SCOPE("onFilled");
+        orderResHandler(API2::COMMON::OrderEvent_FILLED, confirmation, orderId);
 
         // if (!processConfirmation(_orderWrapper, confirmation, orderId))
         // {
@@ -154,8 +473,8 @@ namespace SampleTemplate
     //CallBack When an Order gets Partially Filled at the exchange
     void Template::onPartialFill(API2::OrderConfirmation &confirmation, API2::COMMON::OrderId *orderId)
     {
-        DEBUG_PRINT;
-        orderResHandler(confirmation, orderId);
+        ALLOCATION_SCOPE("onPartialFill");
+        orderResHandler(API2::COMMON::OrderEvent_PARTIAL_FILL, confirmation, orderId);
         // if (!processConfirmation(_orderWrapper, confirmation, orderId))
         // {
         //     DEBUG_MESSAGE(reqQryDebugLog(), "Process Confirmation Failed");
@@ -165,8 +484,8 @@ namespace SampleTemplate
     //CallBack When a order is cancelled from exchange
     void Template::onCanceled(API2::OrderConfirmation &confirmation, API2::COMMON::OrderId *orderId)
     {
-        DEBUG_PRINT;
-        orderResHandler(confirmation, orderId);
+        ALLOCATION_SCOPE("onCanceled");
+        orderResHandler(API2::COMMON::OrderEvent_CANCELED, confirmation, orderId);
         // if (!processConfirmation(_orderWrapper, confirmation, orderId))
         // {
         //     DEBUG_MESSAGE(reqQryDebugLog(), "Process Confirmation Failed");
@@ -176,8 +495,8 @@ namespace SampleTemplate
     //CallBack When an Order gets Replaced successfully at the exchange
     void Template::onReplaced(API2::OrderConfirmation &confirmation, API2::COMMON::OrderId *orderId)
     {
-        DEBUG_PRINT;
-        orderResHandler(confirmation, orderId);
+        ALLOCATION_SCOPE("onReplaced");
+        orderResHandler(API2::COMMON::OrderEvent_REPLACED, confirmation, orderId);
         // if (!processConfirmation(_orderWrapper, confirmation, orderId))
         // {
         //     DEBUG_MESSAGE(reqQryDebugLog(), "Process Confirmation Failed");
@@ -187,8 +506,8 @@ namespace SampleTemplate
     //CallBack When an Order's Replace Request gets rejected by the exchange
     void Template::onReplaceRejected(API2::OrderConfirmation &confirmation, API2::COMMON::OrderId *orderId)
     {
-        DEBUG_PRINT;
-        orderResHandler(confirmation, orderId);
+        ALLOCATION_SCOPE("onReplaceRejected");
+        orderResHandler(API2::COMMON::OrderEvent_REPLACE_REJECTED, confirmation, orderId);
         // if (!processConfirmation(_orderWrapper, confirmation, orderId))
         // {
         //     DEBUG_MESSAGE(reqQryDebugLog(), "Process Confirmation Failed");
@@ -198,8 +517,8 @@ namespace SampleTemplate
     //CallBack for When an Order's Cancel Request gets rejected by the exchange
     void Template::onCancelRejected(API2::OrderConfirmation &confirmation, API2::COMMON::OrderId *orderId)
     {
-        DEBUG_PRINT;
-        orderResHandler(confirmation, orderId);
+        ALLOCATION_SCOPE("onCancelRejected");
+        orderResHandler(API2::COMMON::OrderEvent_CANCEL_REJECTED, confirmation, orderId);
         // if (!processConfirmation(_orderWrapper, confirmation, orderId))
         // {
         //     DEBUG_MESSAGE(reqQryDebugLog(), "Process Confirmation Failed");
@@ -210,7 +529,7 @@ namespace SampleTemplate
     void Template::onCMDTerminateStartegy()
     {
         DEBUG_PRINT;
-        DEBUG_MESSAGE(reqQryDebugLog(), "Strategy Ended From FrontEnd");
+        DEBUG_MESSAGE(debugLog(), "Strategy Ended From FrontEnd");
         terminateStrategyComment(API2::CONSTANTS::CMD_CommandCategory_TERMINATE_STRATEGY);
     }
 
@@ -233,7 +552,8 @@ namespace SampleTemplate
       * * @return
       */
 
-        obj->reqStartAlgo(true, false);
+        // trades of the contract arrive through onTradeTickEvent
+        obj->reqStartAlgo(true, wsc::appConfig::isTradeTickEvent);
         API2::SGContext::registerStrategy(obj);
         obj->reqTimerEvent(10000);
         DEBUG_MESSAGE(obj->reqQryDebugLog(), "Strategy Registered!");
@@ -262,7 +582,7 @@ namespace SampleTemplate
 
         if (!setModifiedInternalParameters(customParams, _modUserParams))
         {
-            DEBUG_MESSAGE(reqQryDebugLog(), "Parameters not set from front end");
+            DEBUG_MESSAGE(debugLog(), "Parameters not set from front end");
             terminateStrategyComment(API2::CONSTANTS::RSP_StrategyComment_STRATEGY_ERROR_STATE);
             return;
         }
@@ -299,6 +619,9 @@ namespace SampleTemplate
             return;
 
         _terminateCheck = true;
+        for (int side = 0; side < 2; side++)
+            if (_squareOffExecutors[side])
+                _squareOffExecutors[side]->cancel(_riskStatus);
 
         reqAddStrategyComment(comment);
         reqTerminateStrategy();
@@ -307,7 +630,7 @@ namespace SampleTemplate
     void Template::dump(FrontEndParameters &params)
     {
         DEBUG_PRINT;
-        DEBUG_VARSHOW(reqQryDebugLog(), "StgSymbolId", params.stgSymbolId);
+        DEBUG_VARSHOW(debugLog(), "StgSymbolId", params.stgSymbolId);
         // DEBUG_VARSHOW(reqQryDebugLog(), "Order Mode ", (API2::DATA_TYPES::OrderMode)params.orderMode);
     }
 
@@ -317,9 +640,78 @@ namespace SampleTemplate
     {
         DEBUG_PRINT;
         //Todo check userParams.strategyID already running or not
-        wsc::common::appConfigFilePath = "/root/work/uTrade-dev/src/templateAlgo/appConfig.ini";
+        if (wsc::common::appConfigFilePath.empty())
+            wsc::common::appConfigFilePath = "/root/work/uTrade-dev/src/templateAlgo/appConfig.ini";
         setAppConfig();
+        if (wsc::appConfig::jitterCalibrationMs > 0)
+            calibrateStrategyJitter();
+        if (!wsc::appConfig::debugLogDir.empty())
+        {
+            std::string error;
+            if (!_debugLog.open(wsc::appConfig::debugLogDir + "/STG_" + std::to_string(_userParams.stgSymbolId) + ".log", wsc::appConfig::debugLogThread, error))
+            {
+                DEBUG_MESSAGE(debugLog(), "Debug log file not used: " + error);
+            }
+            else if (!_debugLog.getPlacementError().empty())
+            {
+                DEBUG_MESSAGE(debugLog(), "Debug log thread placement: " + _debugLog.getPlacementError());
+            }
+        }
+        if (!wsc::appConfig::reportLogDir.empty())
+        {
+            std::string path = wsc::appConfig::reportLogDir + "/STG_" + std::to_string(_userParams.stgSymbolId) + ".report.log";
+            _reportLogFd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (_reportLogFd < 0)
+            {
+                DEBUG_MESSAGE(debugLog(), "Report log file not used: " + path + ": " + strerror(errno));
+            }
+        }
+        if (!wsc::appConfig::persistDir.empty())
+        {
+            API2::COMMON::RowWriterConfig persistConfig;
+            persistConfig.target = wsc::appConfig::persistTarget;
+            persistConfig.path = wsc::appConfig::persistDir + "/STG_" + std::to_string(_userParams.stgSymbolId) +
+                                 (persistConfig.target == API2::COMMON::RowWriterTarget_SQLITE ? ".db" : ".csv");
+            persistConfig.table = "confirmations";
+            persistConfig.columns = "stg_symbol_id INTEGER, timestamp INTEGER, callback TEXT, cl_order_id INTEGER, symbol_id INTEGER, order_mode TEXT, order_type INTEGER, "
+                                    "exchange_order_id TEXT, order_status INTEGER, error_code INTEGER, orig_order_price INTEGER, order_price INTEGER, order_quantity INTEGER, "
+                                    "orig_last_fill_price INTEGER, last_fill_price INTEGER, last_fill_quantity INTEGER, wrapper_index INTEGER, is_buy_wrapper INTEGER, "
+                                    "is_processed INTEGER, is_reset INTEGER, last_quoted_price INTEGER, last_quantity INTEGER, last_filled_quantity INTEGER";
+            persistConfig.maxRows = std::max(wsc::appConfig::persistMaxRows, 1);
+            persistConfig.maxBytes = std::max(wsc::appConfig::persistMaxBytes, 1);
+            persistConfig.flushIntervalMicros = wsc::appConfig::persistFlushMicros;
+            std::string error;
+            if (!_persistWriter.open(persistConfig, wsc::appConfig::persistThread, error))
+            {
+                DEBUG_MESSAGE(debugLog(), "Confirmations not persisted: " + error);
+            }
+            else if (!_persistWriter.getPlacementError().empty())
+            {
+                DEBUG_MESSAGE(debugLog(), "Persist writer thread placement: " + _persistWriter.getPlacementError());
+            }
+        }
+        _confirmationLog.start([this](const wsc::ConfirmationRecord &record)
+                               {
+                                   printConfirmation(record, _reportLogFd);
+                                   persistConfirmation(record);
+                               },
+                               wsc::appConfig::confirmationLogThread);
+        if (!_confirmationLog.getPlacementError().empty())
+            DEBUG_MESSAGE(debugLog(), "Confirmation log thread placement: " + _confirmationLog.getPlacementError());
+        _snapshotLog.start([this](const wsc::SnapshotRecord &record)
+                           { formatSnapshot(record); },
+                           wsc::appConfig::snapshotLogThread);
+        if (!_snapshotLog.getPlacementError().empty())
+            DEBUG_MESSAGE(debugLog(), "Snapshot thread placement: " + _snapshotLog.getPlacementError());
+        _timerEventInterval = wsc::appConfig::smConsumerInterval;
+        if (wsc::appConfig::orderTimerTickMicros > 0 && (wsc::appConfig::orderAckTimeoutMicros > 0 || wsc::appConfig::orderMaxRestingSec > 0))
+        {
+            _timerEventInterval = std::min(_timerEventInterval, wsc::appConfig::orderTimerTickMicros);
+            _orderTimers.reset(wsc::Time::getSystemTimestamp(), wsc::appConfig::orderTimerTickMicros * NANO_SECONDS_IN_MICRO_SEC);
+        }
         createOrders();
+        restoreCheckpoint();
+        saveCheckpoint();
 
         DEBUG_PRINT << "#SymbolId: " << _contract->getSymbolId() << ", instrument:  " << _contract->getStaticData()->scripName << ", strategyID: " << _userParams.strategyID << ", stgSymbolId: " << _userParams.stgSymbolId << ", clientId: " << _userParams.clientId << ", account: " << _userParams.account.getString();
         DEBUG_PRINT << "STG_SNAPSHOT,Timestamp,NetPos,GrossPnL,NetPnL,MidPrice,TSTQ,TSTV,TBTQ,TBTV,Contract,B/S,TradeQty,TradePrice,ExchOrderId,ExchTradeId,SentMsgCount,StrategyInputs,NoOfOrdersInBook,ActiveOrderBook,InternalOrderBook,BookSnapshotBid,BookSnapshotAsk,TicksCount,MsgSentCount,TickDiscardCount,ThrottlerErrorCount";
@@ -339,6 +731,82 @@ namespace SampleTemplate
         wsc::appConfig::tickToOrderLatencyFlag = boost::lexical_cast<bool>(appConfig["TICK_TO_ORDER_LATENCY_FLAG"]);
         wsc::appConfig::smConsumerInterval = boost::lexical_cast<int>(appConfig["SM_CONSUMER_INTERVAL"]) * MICRO_SECONDS_IN_SEC;
         wsc::appConfig::minValidObLevel = boost::lexical_cast<int>(appConfig["MIN_VALID_OB_LEVEL"]);
+        if (!appConfig["TRADE_FLOW_WINDOW_SEC"].empty())
+            _tradeFlow.setWindowLength(boost::lexical_cast<UNSIGNED_LONG>(appConfig["TRADE_FLOW_WINDOW_SEC"]) * NANO_SECONDS_IN_SEC);
+
+        readThreadPlacement(appConfig, "STRATEGY", wsc::appConfig::strategyThread);
+        readThreadPlacement(appConfig, "AUX", wsc::appConfig::auxThread);
+        readWorkerPlacement(appConfig, "DEBUG_LOG", wsc::appConfig::auxThread, wsc::appConfig::debugLogThread);
+        readWorkerPlacement(appConfig, "CONFIRMATION_LOG", wsc::appConfig::auxThread, wsc::appConfig::confirmationLogThread);
+        readWorkerPlacement(appConfig, "SNAPSHOT_LOG", wsc::appConfig::auxThread, wsc::appConfig::snapshotLogThread);
+        readWorkerPlacement(appConfig, "PERSIST", wsc::appConfig::auxThread, wsc::appConfig::persistThread);
+        readWorkerPlacement(appConfig, "IV_SURFACE", wsc::appConfig::auxThread, wsc::appConfig::ivSurfaceThread);
+        if (!appConfig["JITTER_CALIBRATION_MS"].empty())
+            wsc::appConfig::jitterCalibrationMs = boost::lexical_cast<int>(appConfig["JITTER_CALIBRATION_MS"]);
+        if (!appConfig["ALLOC_CHECK_WARMUP_CALLS"].empty())
+            API2::COMMON::AllocationScope::setWarmupCalls(boost::lexical_cast<uint64_t>(appConfig["ALLOC_CHECK_WARMUP_CALLS"]));
+        if (!appConfig["ALLOC_CHECK_FAIL"].empty())
+            API2::COMMON::AllocationScope::setFailOnAllocation(boost::lexical_cast<bool>(appConfig["ALLOC_CHECK_FAIL"]));
+        wsc::appConfig::checkpointDir = appConfig["CHECKPOINT_DIR"];
+        if (!appConfig["WARM_RESTART_MAX_AGE_SEC"].empty())
+            wsc::appConfig::checkpointMaxAgeSec = boost::lexical_cast<int>(appConfig["WARM_RESTART_MAX_AGE_SEC"]);
+        if (!appConfig["SAVE_CONFIRMATION_TO_DEBUG_LOG"].empty())
+            wsc::appConfig::saveConfirmationToDebugLog = boost::lexical_cast<bool>(appConfig["SAVE_CONFIRMATION_TO_DEBUG_LOG"]);
+        wsc::appConfig::debugLogDir = appConfig["DEBUG_LOG_DIR"];
+        wsc::appConfig::reportLogDir = appConfig["REPORT_LOG_DIR"];
+        if (!appConfig["SHARED_BOOK_CACHE"].empty())
+            wsc::appConfig::isSharedBookCache = boost::lexical_cast<bool>(appConfig["SHARED_BOOK_CACHE"]);
+        if (!appConfig["REQUOTE_ON_CONFIRMATION"].empty())
+            wsc::appConfig::isRequoteOnConfirmation = boost::lexical_cast<bool>(appConfig["REQUOTE_ON_CONFIRMATION"]);
+        if (!appConfig["TRADE_TICK_EVENT"].empty())
+            wsc::appConfig::isTradeTickEvent = boost::lexical_cast<bool>(appConfig["TRADE_TICK_EVENT"]);
+        if (!appConfig["REQUOTE_MAX_PER_WINDOW"].empty())
+            wsc::appConfig::requoteMaxPerWindow = boost::lexical_cast<int>(appConfig["REQUOTE_MAX_PER_WINDOW"]);
+        if (!appConfig["REQUOTE_WINDOW_MICROS"].empty())
+            wsc::appConfig::requoteWindowMicros = boost::lexical_cast<int>(appConfig["REQUOTE_WINDOW_MICROS"]);
+        if (!appConfig["ORDER_TIMER_TICK_MICROS"].empty())
+            wsc::appConfig::orderTimerTickMicros = boost::lexical_cast<int>(appConfig["ORDER_TIMER_TICK_MICROS"]);
+        if (!appConfig["ORDER_ACK_TIMEOUT_MICROS"].empty())
+            wsc::appConfig::orderAckTimeoutMicros = boost::lexical_cast<int>(appConfig["ORDER_ACK_TIMEOUT_MICROS"]);
+        if (!appConfig["ORDER_MAX_RESTING_SEC"].empty())
+            wsc::appConfig::orderMaxRestingSec = boost::lexical_cast<int>(appConfig["ORDER_MAX_RESTING_SEC"]);
+        if (!appConfig["SQUARE_OFF_SLICE_ORDERS"].empty())
+            wsc::appConfig::squareOffSliceOrders = boost::lexical_cast<int>(appConfig["SQUARE_OFF_SLICE_ORDERS"]);
+        if (!appConfig["SQUARE_OFF_SLICE_MAX_PER_WINDOW"].empty())
+            wsc::appConfig::squareOffSliceMaxPerWindow = boost::lexical_cast<int>(appConfig["SQUARE_OFF_SLICE_MAX_PER_WINDOW"]);
+        if (!appConfig["SQUARE_OFF_SLICE_WINDOW_MICROS"].empty())
+            wsc::appConfig::squareOffSliceWindowMicros = boost::lexical_cast<int>(appConfig["SQUARE_OFF_SLICE_WINDOW_MICROS"]);
+        wsc::appConfig::persistDir = appConfig["PERSIST_DIR"];
+        if (!appConfig["PERSIST_TARGET"].empty())
+        {
+            wsc::appConfig::persistTarget = API2::COMMON::getRowWriterTarget(appConfig["PERSIST_TARGET"]);
+            if (wsc::appConfig::persistTarget == API2::COMMON::RowWriterTarget_MAX)
+                throw std::string("Invalid PERSIST_TARGET");
+        }
+        if (!appConfig["PERSIST_MAX_ROWS"].empty())
+            wsc::appConfig::persistMaxRows = boost::lexical_cast<int>(appConfig["PERSIST_MAX_ROWS"]);
+        if (!appConfig["PERSIST_MAX_BYTES"].empty())
+            wsc::appConfig::persistMaxBytes = boost::lexical_cast<int>(appConfig["PERSIST_MAX_BYTES"]);
+        if (!appConfig["PERSIST_FLUSH_MICROS"].empty())
+            wsc::appConfig::persistFlushMicros = boost::lexical_cast<int>(appConfig["PERSIST_FLUSH_MICROS"]);
+
+        // threads that will run, workers sharing a cpu are only reported unless they are SCHED_FIFO and one busy polls
+        std::vector<API2::COMMON::ThreadPlacement> placements;
+        placements.push_back(wsc::appConfig::strategyThread);
+        if (!wsc::appConfig::debugLogDir.empty())
+            placements.push_back(wsc::appConfig::debugLogThread);
+        placements.push_back(wsc::appConfig::confirmationLogThread);
+        placements.push_back(wsc::appConfig::snapshotLogThread);
+        if (!wsc::appConfig::persistDir.empty())
+            placements.push_back(wsc::appConfig::persistThread);
+        if (!stgConfig["IV_SURFACE_STRIKES"].empty())
+            placements.push_back(wsc::appConfig::ivSurfaceThread);
+        std::vector<std::string> warnings;
+        bool isPlacementValid = API2::COMMON::validateThreadPlacements(placements, warnings);
+        for (size_t i = 0; i < warnings.size(); ++i)
+            DEBUG_MESSAGE(debugLog(), "Thread placement: " + warnings[i]);
+        if (!isPlacementValid)
+            throw std::string("Invalid thread placement");
 
         _stgSymbolConfig.source = boost::lexical_cast<std::string>(stgConfig["SOURCE"]);
         _stgSymbolConfig.exchange = boost::lexical_cast<std::string>(stgConfig["EXCHANGE"]);
@@ -347,10 +815,52 @@ namespace SampleTemplate
         _stgSymbolConfig.strikePrice = boost::lexical_cast<std::string>(stgConfig["STRIKE_PRICE"]);
         _stgSymbolConfig.optType = boost::lexical_cast<std::string>(stgConfig["OPT_TYPE"]);
 
-        _contract = createNewInstrument(getSymbolID(_stgSymbolConfig.source, _stgSymbolConfig.exchange, _stgSymbolConfig.symbol, _stgSymbolConfig.expiary, _stgSymbolConfig.strikePrice, _stgSymbolConfig.optType), true, true, false, false, BOOK_SNAPSHOT_PRICE_LEVELS);
+        // symbol lookup is skipped on warm restart, checkpoint of the same symbol name carries its id
+        _isWarmRestart = loadCheckpoint(getSymbolName(_stgSymbolConfig.source, _stgSymbolConfig.exchange, _stgSymbolConfig.symbol, _stgSymbolConfig.expiary, _stgSymbolConfig.strikePrice, _stgSymbolConfig.optType));
+        API2::DATA_TYPES::SYMBOL_ID symbolId = _isWarmRestart ? _checkpoint.symbolId : getSymbolID(_stgSymbolConfig.source, _stgSymbolConfig.exchange, _stgSymbolConfig.symbol, _stgSymbolConfig.expiary, _stgSymbolConfig.strikePrice, _stgSymbolConfig.optType);
+        _contract = createNewInstrument(symbolId, true, true, wsc::appConfig::isTradeTickEvent, false, BOOK_SNAPSHOT_PRICE_LEVELS);
         _mktData = reqQryUpdateMarketData(_contract->getSymbolId());
+        if (wsc::appConfig::isSharedBookCache)
+            _bookCacheEntry = wsc::BookSnapshotCache::shared().acquire(_contract->getSymbolId());
 
         _strategyInput.maxPos = boost::lexical_cast<int>(stgConfig["MAX_POS"]) * _contract->getStaticData()->marketLot;
+        if (!stgConfig["MAX_ORDER_VALUE"].empty())
+            _strategyInput.maxOrderValue = boost::lexical_cast<double>(stgConfig["MAX_ORDER_VALUE"]);
+        if (!stgConfig["MAX_OPEN_LOTS"].empty())
+            _strategyInput.maxOpenLots = boost::lexical_cast<int>(stgConfig["MAX_OPEN_LOTS"]);
+        if (!stgConfig["COLLAR_TICKS"].empty())
+            _strategyInput.collarTicks = boost::lexical_cast<int>(stgConfig["COLLAR_TICKS"]);
+        if (!stgConfig["BAR_RANGE_PAUSE_TICKS"].empty())
+            _barRangePauseTicks = boost::lexical_cast<int>(stgConfig["BAR_RANGE_PAUSE_TICKS"]);
+        if (!stgConfig["QUOTING_POLICY"].empty())
+        {
+            _quotingPolicyType = API2::COMMON::getQuotingPolicyType(stgConfig["QUOTING_POLICY"]);
+            if (_quotingPolicyType == API2::COMMON::QuotingPolicy_MAX)
+                throw std::string("Invalid QUOTING_POLICY " + stgConfig["QUOTING_POLICY"]);
+        }
+        _quotingParams.tickSize = _contract->getStaticData()->tickSize;
+        _quotingParams.maxPos = _strategyInput.maxPos;
+        if (!stgConfig["QUOTE_LEVEL"].empty())
+            _quotingParams.level = boost::lexical_cast<int>(stgConfig["QUOTE_LEVEL"]);
+        if (!stgConfig["QUOTE_CLOSE_LEVEL"].empty())
+            _quotingParams.closeLevel = boost::lexical_cast<int>(stgConfig["QUOTE_CLOSE_LEVEL"]);
+        if (_quotingParams.level < 0 || _quotingParams.level >= BOOK_SNAPSHOT_PRICE_LEVELS || _quotingParams.closeLevel < 0 || _quotingParams.closeLevel >= BOOK_SNAPSHOT_PRICE_LEVELS)
+            throw std::string("Invalid QUOTE_LEVEL / QUOTE_CLOSE_LEVEL");
+        if (!stgConfig["QUOTE_IMPROVE_TICKS"].empty())
+            _quotingParams.improveTicks = boost::lexical_cast<int>(stgConfig["QUOTE_IMPROVE_TICKS"]);
+        if (!stgConfig["QUOTE_SKEW_TICKS"].empty())
+            _quotingParams.skewTicks = boost::lexical_cast<int>(stgConfig["QUOTE_SKEW_TICKS"]);
+        if (!stgConfig["QUOTE_OFFSET_TICKS"].empty())
+            _quotingParams.offsetTicks = boost::lexical_cast<int>(stgConfig["QUOTE_OFFSET_TICKS"]);
+        DEBUG_MESSAGE(debugLog(), std::string("Quoting policy ") + API2::COMMON::QuotingPolicyTypeStr(_quotingPolicyType));
+        if (!_riskLimits.initialize(_contract->getStaticData(), _strategyInput.maxOrderValue, _strategyInput.maxOpenLots, _strategyInput.collarTicks))
+            throw std::string("Invalid static data for risk limits");
+        _calendarIndex = _calendar.registerInstrument(_contract->getStaticData());
+        _calendar.update(wsc::Time::getTimestamp());
+        if (!stgConfig["IV_EDGE_TICKS"].empty())
+            _ivEdgeTicks = boost::lexical_cast<int>(stgConfig["IV_EDGE_TICKS"]);
+        if (!stgConfig["IV_SURFACE_STRIKES"].empty())
+            setUpIvSurface(stgConfig["IV_SURFACE_STRIKES"], stgConfig["IV_INTEREST_RATE"].empty() ? 0 : boost::lexical_cast<double>(stgConfig["IV_INTEREST_RATE"]));
 
         _userParams.account.setPrimaryClientCode("PRO");
         _userParams.account.setTraderId(654987);
@@ -404,11 +914,17 @@ namespace SampleTemplate
         //             << _netPosition.totalSellTradedQty << ", " << _netPosition.totalSellTradedValue << ", ";
     }
 
+    //Depth of an update already published by another strategy on the same symbol is copied from the shared cache,
+    //otherwise it is read from MktData and published
     void Template::updateBookSnapshot()
     {
         //  DEBUG_PRINT;
+        int64_t updateTimestamp = _mktData->getTimeStamp();
+        uint64_t updateIndex = _bookCacheEntry ? _mktData->getLatestIndexCounter() : 0;
+        if (_bookCacheEntry && wsc::BookSnapshotCache::read(_bookCacheEntry, updateTimestamp, updateIndex, _bookSnapshot))
+            return;
         _bookSnapshot.contractId = _mktData->getSymbolId();
-        _bookSnapshot.timestamp = _mktData->getTimeStamp() > 0 ? _mktData->getTimeStamp() : wsc::Time::getSystemTimestamp();
+        _bookSnapshot.timestamp = updateTimestamp > 0 ? updateTimestamp : wsc::Time::getSystemTimestamp();
         for (int i = 0; i < BOOK_SNAPSHOT_PRICE_LEVELS; ++i)
         {
             _bookSnapshot.bidPriceLevels[i].price = _mktData->getBidPrice(i);
@@ -418,6 +934,8 @@ namespace SampleTemplate
             _bookSnapshot.askPriceLevels[i].quantity = _mktData->getAskQty(i);
             // _bookSnapshot.askPriceLevels[i].orderCount = _mktData->getNoOfAsks(i);
         }
+        if (_bookCacheEntry)
+            wsc::BookSnapshotCache::publish(_bookCacheEntry, updateTimestamp, updateIndex, _bookSnapshot);
         //  DEBUG_PRINT;
     }
 
@@ -440,17 +958,175 @@ namespace SampleTemplate
 
         // DEBUG_PRINT << source << "  " << exchange << "  " << symbol << "  " << expiary << "  " << strikePrice << "  " << optType;
 
-        std::string symbolName = source + " " + exchange + " " + symbol;
-        if (expiary.length() > 0)
-            symbolName += " " + expiary;
-        if (strikePrice.length() > 0)
-            symbolName += " " + strikePrice;
-        if (optType.length() > 0)
-            symbolName += " " + optType;
+        std::string symbolName = getSymbolName(source, exchange, symbol, expiary, strikePrice, optType);
         DEBUG_PRINT << reqQrySymbolID(symbolName) << "  " << symbolName;
         return reqQrySymbolID(symbolName);
     }
 
+    //Internal orders of policy, new position up to max position and square off of existing position
+    template <typename Policy>
+    void Template::quote()
+    {
+        API2::COMMON::QuoteTargets targets;
+        Policy(_quotingParams).computeTargets(_bookSnapshot, _netPosition.netPositionQty, targets);
+        if (std::is_same<Policy, API2::COMMON::JoinImproveQuoting>::value)
+            joinOtherOrders(targets);
+        applyIvFairValue(targets);
+
+        int _buyQty = std::max(std::min(_strategyInput.maxPos, _strategyInput.maxPos - _netPosition.netPositionQty), 0);
+        int _sellQty = std::min(std::max(-_strategyInput.maxPos, -_strategyInput.maxPos - _netPosition.netPositionQty), 0);
+        // no new position in a contract past its expiry day cutoff or in a too wide market, existing position is still squared off
+        if (_calendar.isPastExpiryCutoff(_calendarIndex) || _isBarRangePaused)
+            _buyQty = _sellQty = 0;
+
+        // Creating New position
+        if (_buyQty > 0)
+        {
+            _internalBuyOrderBook[0].price = targets.openBid;
+            _internalBuyOrderBook[0].qty = _buyQty;
+        }
+        if (_sellQty < 0)
+        {
+            _internalSellOrderBook[0].price = targets.openAsk;
+            _internalSellOrderBook[0].qty = std::abs(_sellQty);
+        }
+        // Square off  existing positions
+        if (_netPosition.netPositionQty > 0)
+        {
+            _internalSellOrderBook[1].price = targets.closeAsk;
+            _internalSellOrderBook[1].qty = _netPosition.netPositionQty;
+        }
+        else if (_netPosition.netPositionQty < 0)
+        {
+            _internalBuyOrderBook[1].price = targets.closeBid;
+            _internalBuyOrderBook[1].qty = std::abs(_netPosition.netPositionQty);
+        }
+    }
+
+    //JOIN_IMPROVE prices off the best level that is not only our own resting order, else an improving quote keeps improving on itself.
+    //Improved and joined prices of both sides come from getBestPrices in one pass over the book, improved ones are kept while the spread allows
+    void Template::joinOtherOrders(API2::COMMON::QuoteTargets &targets)
+    {
+        API2::COMMON::BestPriceRequest requests[4];
+        for (int i = 0; i < 4; i++)
+        {
+            bool isBuy = i % 2 == 0;
+            requests[i].orderWrapper = isBuy ? _buyOrderBook[0] : _sellOrderBook[0];
+            requests[i].side = isBuy ? API2::CONSTANTS::CMD_OrderMode_BUY : API2::CONSTANTS::CMD_OrderMode_SELL;
+            requests[i].tickFactor = i < 2 ? _quotingParams.improveTicks : 0;
+        }
+        // levels of the snapshot quote() works on, not MktData that may already hold a newer update
+        API2::COMMON::BestPriceBook book;
+        for (int i = 0; i < API2::COMMON::BestPriceBook::DEPTH; i++)
+        {
+            book.price[API2::CONSTANTS::CMD_OrderMode_BUY][i] = _bookSnapshot.bidPriceLevels[i].price;
+            book.qty[API2::CONSTANTS::CMD_OrderMode_BUY][i] = _bookSnapshot.bidPriceLevels[i].quantity;
+            book.price[API2::CONSTANTS::CMD_OrderMode_SELL][i] = _bookSnapshot.askPriceLevels[i].price;
+            book.qty[API2::CONSTANTS::CMD_OrderMode_SELL][i] = _bookSnapshot.askPriceLevels[i].quantity;
+        }
+        API2::COMMON::getBestPrices(book, requests, 4);
+
+        int first = requests[0].price < requests[1].price ? 0 : 2;
+        // no level left past our own order, policy prices stay
+        if (requests[first].price == 0 || requests[first + 1].price == 0)
+            return;
+        targets.openBid = targets.closeBid = requests[first].price;
+        targets.openAsk = targets.closeAsk = requests[first + 1].price;
+    }
+
+    //Option contract with IV_SURFACE_STRIKES: its expiry gets a smile fitted from the contract, calls and puts of the listed strikes
+    //and the future of the same expiry as underlying. Chain symbols are subscribed here, only their mids are stored on the strategy thread
+    void Template::setUpIvSurface(const std::string &strikes, double interestRate)
+    {
+        if (_stgSymbolConfig.optType.empty() || _stgSymbolConfig.strikePrice.empty())
+            throw std::string("IV_SURFACE_STRIKES needs an option contract");
+        _isContractCall = toupper(_stgSymbolConfig.optType[0]) == 'C';
+        _ivContractStrike = boost::lexical_cast<double>(_stgSymbolConfig.strikePrice);
+        _ivSurface.reset(new API2::COMMON::VolatilitySurface(interestRate, 0, wsc::appConfig::ivSurfaceThread));
+        _ivSurfaceExpiry = _ivSurface->addExpiry(_calendar.getFractionalTimeToExpire(_calendarIndex));
+        _ivContractNode = _ivSurface->addOption(_ivSurfaceExpiry, _isContractCall, _ivContractStrike);
+        addIvSurfaceSymbol(getSymbolID(_stgSymbolConfig.source, _stgSymbolConfig.exchange, _stgSymbolConfig.symbol, _stgSymbolConfig.expiary), true, 0);
+
+        std::stringstream list(strikes);
+        std::string strike;
+        while (std::getline(list, strike, ','))
+        {
+            strike.erase(0, strike.find_first_not_of(' '));
+            strike.erase(strike.find_last_not_of(' ') + 1);
+            if (strike.empty())
+                continue;
+            double strikeValue = boost::lexical_cast<double>(strike);
+            for (int isCall = 0; isCall < 2; isCall++)
+            {
+                if (strikeValue == _ivContractStrike && (isCall != 0) == _isContractCall)
+                    continue;
+                // same spelling as OPT_TYPE of the contract, only call / put differs
+                std::string optType = _stgSymbolConfig.optType;
+                optType[0] = isCall ? 'C' : 'P';
+                size_t node = _ivSurface->addOption(_ivSurfaceExpiry, isCall != 0, strikeValue);
+                addIvSurfaceSymbol(getSymbolID(_stgSymbolConfig.source, _stgSymbolConfig.exchange, _stgSymbolConfig.symbol, _stgSymbolConfig.expiary, strike, optType), false, node);
+            }
+        }
+        if (!_ivSurface->start())
+            throw std::string("IV surface not started");
+        if (!_ivSurface->getPlacementError().empty())
+        {
+            DEBUG_MESSAGE(debugLog(), "IV surface thread placement: " + _ivSurface->getPlacementError());
+        }
+        DEBUG_MESSAGE(debugLog(), "IV surface of " + std::to_string(_ivSurfaceSymbols.size() - 1) + " options and the contract, edge ticks: " + std::to_string(_ivEdgeTicks));
+    }
+
+    void Template::addIvSurfaceSymbol(API2::DATA_TYPES::SYMBOL_ID symbolId, bool isUnderlying, size_t node)
+    {
+        IvSurfaceSymbol symbol;
+        symbol.symbolId = createNewInstrument(symbolId, true, true, false, false, 1)->getSymbolId();
+        symbol.mktData = reqQryUpdateMarketData(symbol.symbolId);
+        symbol.node = node;
+        symbol.isUnderlying = isUnderlying;
+        _ivSurfaceSymbols.push_back(symbol);
+    }
+
+    //Market data event of a chain symbol, mid of best level goes to the surface, 0 marks a one sided book as unavailable
+    void Template::updateIvSurface(UNSIGNED_LONG symbolId)
+    {
+        for (size_t i = 0; i < _ivSurfaceSymbols.size(); i++)
+        {
+            const IvSurfaceSymbol &symbol = _ivSurfaceSymbols[i];
+            if (symbol.symbolId != symbolId)
+                continue;
+            API2::DATA_TYPES::PRICE bid = symbol.mktData->getBidPrice(0);
+            API2::DATA_TYPES::PRICE ask = symbol.mktData->getAskPrice(0);
+            double mid = bid > 0 && ask > bid ? 0.5 * (bid + ask) : 0;
+            if (!symbol.isUnderlying)
+                _ivSurface->onOptionTick(symbol.node, mid);
+            else if (mid > 0)
+                _ivSurface->onUnderlyingTick(mid);
+            return;
+        }
+    }
+
+    //Open quotes stay IV_EDGE_TICKS away from the fair value of the contract on the latest fitted smile, a bid is lowered, an ask raised.
+    //Square off prices are left to the policy
+    void Template::applyIvFairValue(API2::COMMON::QuoteTargets &targets)
+    {
+        if (!_ivSurface || !_ivSurface->getSnapshot(_ivSnapshot))
+            return;
+        double fairValue = _ivSnapshot.smiles[_ivSurfaceExpiry].getPrice(_isContractCall, _ivContractStrike);
+        if (fairValue <= 0)
+            return;
+        int tickSize = _quotingParams.tickSize > 0 ? _quotingParams.tickSize : 1;
+        int maxBid = (int)floor(fairValue / tickSize) * tickSize - _ivEdgeTicks * tickSize;
+        int minAsk = (int)ceil(fairValue / tickSize) * tickSize + _ivEdgeTicks * tickSize;
+        targets.openBid = std::min(targets.openBid, maxBid);
+        targets.openAsk = std::max(targets.openAsk, minAsk);
+    }
+
+    // one instantiation per QUOTING_POLICY, other translation units (bench) use them through the declaration
+    template void Template::quote<API2::COMMON::FixedLevelQuoting>();
+    template void Template::quote<API2::COMMON::JoinImproveQuoting>();
+    template void Template::quote<API2::COMMON::InventorySkewQuoting>();
+    template void Template::quote<API2::COMMON::MicropriceOffsetQuoting>();
+
     void Template::onBookSnapshot(UNSIGNED_LONG symbolId)
     {
         DEBUG_PRINT;
@@ -458,14 +1134,33 @@ namespace SampleTemplate
             _scopeLatency = wsc::Time::getSystemTimestamp();
         updateBookSnapshot();
         updateNetPosition();
+        processTradeTicks();
         wsc::Time::setTimestampUnsafeForLive(_bookSnapshot.timestamp);
 
         if (!isValidBookSnapshot())
         {
             return;
         }
+        _midPrice = (_bookSnapshot.bidPriceLevels[0].price + _bookSnapshot.askPriceLevels[0].price) / 2;
+        _bars.onMid(_midPrice, _bookSnapshot.timestamp);
+        if (_ivSurface)
+            _ivSurface->onOptionTick(_ivContractNode, _midPrice);
+
+        _isRequotePending = false;
+        updateInternalOrders();
+        manageSquareOff();
+        orderManager();
+        if (wsc::appConfig::tickToOrderLatencyFlag)
+            std::cout << (wsc::Time::getSystemTimestamp() - _scopeLatency) << std::endl;
+        // after requests are out, saving does not delay them
+        if (_msgSentCount != _lastMsgSentCount)
+            saveCheckpoint();
+    }
 
-        for (size_t i = 0; i < _ordersPoolSize; i++)
+    //Internal orders from the current book snapshot and net position
+    void Template::updateInternalOrders()
+    {
+        for (int i = 0; i < _ordersPoolSize; i++)
         {
             _internalBuyOrderBook[i].reset();
             _internalSellOrderBook[i].reset();
@@ -485,37 +1180,223 @@ namespace SampleTemplate
         //     }
         // }
         // else
+        switch (_quotingPolicyType)
         {
-            int _buyQty = std::max(std::min(_strategyInput.maxPos, _strategyInput.maxPos - _netPosition.netPositionQty), 0);
-            int _sellQty = std::min(std::max(-_strategyInput.maxPos, -_strategyInput.maxPos - _netPosition.netPositionQty), 0);
-
-            // Creating New position
-            if (_buyQty > 0)
+        case API2::COMMON::QuotingPolicy_JOIN_IMPROVE:
+            quote<API2::COMMON::JoinImproveQuoting>();
+            break;
+        case API2::COMMON::QuotingPolicy_INVENTORY_SKEW:
+            quote<API2::COMMON::InventorySkewQuoting>();
+            break;
+        case API2::COMMON::QuotingPolicy_MICROPRICE_OFFSET:
+            quote<API2::COMMON::MicropriceOffsetQuoting>();
+            break;
+        default:
+            quote<API2::COMMON::FixedLevelQuoting>();
+            break;
+        }
+        // an order of previous run may still fill until its cancel is confirmed, quoting next to it could double that side
+        if (_leftoverOrderCount[0] > 0 || _leftoverOrderCount[1] > 0)
+        {
+            for (int i = 0; i < _ordersPoolSize; i++)
             {
-                _internalBuyOrderBook[0].price = _bookSnapshot.bidPriceLevels[2].price;
-                _internalBuyOrderBook[0].qty = _buyQty;
+                if (_leftoverOrderCount[0] > 0)
+                    _internalBuyOrderBook[i].qty = 0;
+                if (_leftoverOrderCount[1] > 0)
+                    _internalSellOrderBook[i].qty = 0;
             }
-            if (_sellQty < 0)
+        }
+    }
+
+    //Recompute orders from the last book snapshot as soon as a confirmation freed an order or moved the position
+    //Book has not changed since it was last quoted, only position and open orders did
+    void Template::requote()
+    {
+        _isRequotePending = false;
+        if (_terminateCheck || !isValidBookSnapshot())
+            return;
+        _isRequoting = true;
+        updateNetPosition();
+        updateInternalOrders();
+        manageSquareOff();
+        orderManager();
+        _isRequoting = false;
+    }
+
+    //Square off above the freeze quantity goes out as freeze compliant slices instead of the order of index 1, which the risk check rejects
+    //The executor of a side keeps its square off until all its children are done, a moved price or a flat position cancels the rest
+    //and the square off restarts from the position left. It starts only once the book order of index 1 is gone, so both never rest together
+    void Template::manageSquareOff()
+    {
+        for (int side = 0; side < 2; ++side)
+        {
+            API2::COMMON::SlicedOrderExecutor *executor = _squareOffExecutors[side].get();
+            if (executor == NULL)
+                return;
+            wsc::OrderDetails &squareOff = side == 0 ? _internalBuyOrderBook[1] : _internalSellOrderBook[1];
+            API2::COMMON::OrderWrapper &bookOrder = side == 0 ? *_buyOrderBook[1] : *_sellOrderBook[1];
+            uint32_t msgSentCount = executor->getMsgSentCount();
+            executor->pump(_riskStatus);
+            bool isBusy = executor->isActive() || executor->hasOpenChildren();
+            if (!isBusy && squareOff.qty <= executor->getSliceQty())
             {
-                _internalSellOrderBook[0].price = _bookSnapshot.askPriceLevels[2].price;
-                _internalSellOrderBook[0].qty = std::abs(_sellQty);
+                _msgSentCount += executor->getMsgSentCount() - msgSentCount;
+                continue;
             }
-            // Square off  existing positions
-            if (_netPosition.netPositionQty > 0)
+
+            if (executor->isActive())
             {
-                _internalSellOrderBook[1].price = _bookSnapshot.askPriceLevels[2].price;
-                _internalSellOrderBook[1].qty = _netPosition.netPositionQty;
+                if (squareOff.qty == 0 || (squareOff.price != executor->getParentPrice() && abs(squareOff.price - executor->getParentPrice()) >= _minPriceDiff))
+                    executor->cancel(_riskStatus);
             }
-            else if (_netPosition.netPositionQty < 0)
+            else if (!isBusy && bookOrder._isReset)
             {
-                _internalBuyOrderBook[1].price = _bookSnapshot.bidPriceLevels[2].price;
-                _internalBuyOrderBook[1].qty = std::abs(_netPosition.netPositionQty);
+                // children only reduce the position, the open quantity limit does not apply to them
+                API2::COMMON::RiskLimits limits = _riskLimits;
+                limits.maxOpenQty[bookOrder._mode & 1] = 0;
+                API2::COMMON::RiskCheckResult result = API2::COMMON::checkRiskLimits(limits, bookOrder._mode, squareOff.price, executor->getSliceQty(), 0, _midPrice);
+                if (result != API2::COMMON::RiskCheck_OK)
+                    ++_riskRejectCount;
+                else if (executor->start(_riskStatus, squareOff.price, squareOff.qty))
+                    DEBUG_PRINT << "Square off sliced, B/S: " << wsc::BuySellTypeStr(bookOrder._mode) << ", Price: " << squareOff.price
+                                << ", Qty: " << squareOff.qty << ", SliceQty: " << executor->getSliceQty();
             }
+            _msgSentCount += executor->getMsgSentCount() - msgSentCount;
+            squareOff.qty = 0;
         }
+    }
 
-        orderManager();
-        if (wsc::appConfig::tickToOrderLatencyFlag)
-            std::cout << (wsc::Time::getSystemTimestamp() - _scopeLatency) << std::endl;
+    //Throttled slices and wrappers of finished children, on timer events
+    void Template::pumpSquareOff()
+    {
+        for (int side = 0; side < 2; ++side)
+        {
+            API2::COMMON::SlicedOrderExecutor *executor = _squareOffExecutors[side].get();
+            if (executor == NULL || !(executor->hasPendingSlices() || executor->hasOpenChildren()))
+                continue;
+            uint32_t msgSentCount = executor->getMsgSentCount();
+            executor->pump(_riskStatus);
+            _msgSentCount += executor->getMsgSentCount() - msgSentCount;
+        }
+    }
+
+    //Confirmation of a square off slice, processed into the child wrapper here, the executor then accounts it and sends the next slices
+    API2::COMMON::OrderWrapper *Template::processSliceConfirmation(API2::COMMON::OrderEvent event, API2::OrderConfirmation &confirmation, API2::COMMON::OrderId *orderId, int &index, bool &isBuy)
+    {
+        for (int side = 0; side < 2; ++side)
+        {
+            API2::COMMON::SlicedOrderExecutor *executor = _squareOffExecutors[side].get();
+            if (executor == NULL)
+                return NULL;
+            int child = executor->findChild(orderId);
+            if (child < 0)
+                continue;
+
+            API2::COMMON::OrderWrapper *wrapper = executor->getChildWrapper(child);
+            if (wsc::appConfig::saveConfirmationToDebugLog)
+                reqQryDebugLog()->saveConfirmation(confirmation);
+            wrapper->processConfirmation(confirmation);
+            if (!wrapper->_isReset && wrapper->getLastQuantity() == 0)
+                wrapper->reset();
+            uint32_t msgSentCount = executor->getMsgSentCount();
+            executor->onConfirmation(_riskStatus, orderId, event, confirmation.getLastFillQuantity());
+            _msgSentCount += executor->getMsgSentCount() - msgSentCount;
+            // position moved or the square off may be back to the book order
+            if (wrapper->_isReset || event == API2::COMMON::OrderEvent_PARTIAL_FILL)
+                _isRequotePending = true;
+            index = _ordersPoolSize + child;
+            isBuy = side == 0;
+            return wrapper;
+        }
+        return NULL;
+    }
+
+    //Requote throttle, fixed window count
+    bool Template::takeRequoteSlot()
+    {
+        if (wsc::appConfig::requoteMaxPerWindow <= 0)
+            return true;
+
+        int64_t now = wsc::Time::getSystemTimestamp();
+        if (now - _requoteWindowStart >= wsc::appConfig::requoteWindowMicros * NANO_SECONDS_IN_MICRO_SEC)
+        {
+            _requoteWindowStart = now;
+            _requoteWindowCount = 0;
+        }
+        if (_requoteWindowCount >= wsc::appConfig::requoteMaxPerWindow)
+            return false;
+        ++_requoteWindowCount;
+        return true;
+    }
+
+    //Follow the deadlines of an order wrapper to its new state, ack timeout while a request is pending, resting age from the first time it is open
+    //Wheel timers of a wrapper are cancelled here, O(1), so a timer that fires is always of the current state
+    void Template::updateOrderTimers(bool isBuy, size_t index, API2::COMMON::OrderState previous)
+    {
+        API2::COMMON::OrderState state = (isBuy ? _buyOrderStates : _sellOrderStates).getState(index);
+        if (state == previous)
+            return;
+        wsc::OrderTimers &timers = isBuy ? _buyOrderTimers[index] : _sellOrderTimers[index];
+        uint64_t data = ((uint64_t)isBuy << 32) | index;
+        int64_t now = wsc::Time::getSystemTimestamp();
+
+        _orderTimers.cancel(timers.ackTimerId);
+        timers.ackTimerId = 0;
+        timers.ackTimeoutCount = 0;
+        if (state != API2::COMMON::OrderState_IDLE && state != API2::COMMON::OrderState_OPEN && wsc::appConfig::orderAckTimeoutMicros > 0)
+            timers.ackTimerId = _orderTimers.schedule(now + wsc::appConfig::orderAckTimeoutMicros * NANO_SECONDS_IN_MICRO_SEC, wsc::OrderTimer_ACK, data);
+
+        if (state == API2::COMMON::OrderState_IDLE)
+        {
+            _orderTimers.cancel(timers.restingTimerId);
+            timers.restingTimerId = 0;
+        }
+        else if (state == API2::COMMON::OrderState_OPEN && timers.restingTimerId == 0 && wsc::appConfig::orderMaxRestingSec > 0)
+            timers.restingTimerId = _orderTimers.schedule(now + wsc::appConfig::orderMaxRestingSec * NANO_SECONDS_IN_SEC, wsc::OrderTimer_RESTING, data);
+    }
+
+    //Order deadline expired, called from onTimerEvent
+    //No confirmation in ack timeout, the order is canceled even while pending and reported again if that cancel is not confirmed either
+    //Open too long without fill, the order is canceled to be quoted again
+    void Template::onOrderTimer(uint32_t kind, uint64_t data)
+    {
+        bool isBuy = (data >> 32) != 0;
+        size_t index = (size_t)(data & 0xFFFFFFFF);
+        API2::COMMON::OrderWrapper &order = isBuy ? *_buyOrderBook[index] : *_sellOrderBook[index];
+        API2::COMMON::OrderStateMachine &orderStates = isBuy ? _buyOrderStates : _sellOrderStates;
+        wsc::OrderTimers &timers = isBuy ? _buyOrderTimers[index] : _sellOrderTimers[index];
+        API2::COMMON::OrderState state = orderStates.getState(index);
+
+        if (kind == wsc::OrderTimer_ACK)
+        {
+            timers.ackTimerId = 0;
+            ++_stuckOrderCount;
+            std::string message = std::string(isBuy ? "Buy" : "Sell") + " order " + std::to_string(index) + " " + API2::COMMON::OrderStateStr(state) + " past ack timeout";
+            if (++timers.ackTimeoutCount == 1 && !_terminateCheck && order._orderId != NULL)
+            {
+                // state stays pending, the cancel confirmation or the late one of the request moves it
+                if (reqCancelOrder(_riskStatus, order._orderId, true))
+                {
+                    ++_msgSentCount;
+                    message += ", cancel sent";
+                }
+                timers.ackTimerId = _orderTimers.schedule(wsc::Time::getSystemTimestamp() + wsc::appConfig::orderAckTimeoutMicros * NANO_SECONDS_IN_MICRO_SEC, wsc::OrderTimer_ACK, data);
+            }
+            DEBUG_MESSAGE(debugLog(), message);
+        }
+        else if (kind == wsc::OrderTimer_RESTING)
+        {
+            timers.restingTimerId = 0;
+            if (state != API2::COMMON::OrderState_OPEN || order._lastFilledQuantity != 0 || _terminateCheck)
+                return;
+            if (order.cancelOrder(_riskStatus))
+            {
+                ++_msgSentCount;
+                orderStates.onRequest(index, API2::COMMON::OrderEvent_CANCEL_REQUEST, order);
+                updateOrderTimers(isBuy, index, state);
+                DEBUG_MESSAGE(debugLog(), std::string(isBuy ? "Buy" : "Sell") + " order " + std::to_string(index) + " canceled, open longer than max resting time");
+            }
+        }
     }
 
     void Template::createOrders()
@@ -525,14 +1406,14 @@ namespace SampleTemplate
         for (int i = 0; i < _ordersPoolSize; i++)
         {
             _buyOrderBook.push_back(
-                API2::COMMON::OrderWrapper(
+                API2::COMMON::OrderWrapperPool::shared().acquire(
                     _contract,
                     API2::CONSTANTS::CMD_OrderMode_BUY,
                     this,
                     _userParams.account,
                     API2::CONSTANTS::CMD_OrderType_LIMIT));
             _sellOrderBook.push_back(
-                API2::COMMON::OrderWrapper(
+                API2::COMMON::OrderWrapperPool::shared().acquire(
                     _contract,
                     API2::CONSTANTS::CMD_OrderMode_SELL,
                     this,
@@ -540,8 +1421,38 @@ namespace SampleTemplate
                     API2::CONSTANTS::CMD_OrderType_LIMIT));
             _internalBuyOrderBook.push_back(wsc::OrderDetails{API2::CONSTANTS::CMD_OrderMode_BUY, 0, 0});
             _internalSellOrderBook.push_back(wsc::OrderDetails{API2::CONSTANTS::CMD_OrderMode_SELL, 0, 0});
-            _buyOrderBook[i].reset();
-            _sellOrderBook[i].reset();
+            _buyOrderBook[i]->reset();
+            _sellOrderBook[i]->reset();
+            _buyOrderStates.add();
+            _sellOrderStates.add();
+            _buyOrderTimers.push_back(wsc::OrderTimers());
+            _sellOrderTimers.push_back(wsc::OrderTimers());
+        }
+
+        // square off slices, an order at or above the freeze quantity is rejected
+        if (wsc::appConfig::squareOffSliceOrders > 0)
+        {
+            API2::SymbolStaticData *staticData = _contract->getStaticData();
+            for (int side = 0; side < 2; side++)
+            {
+                for (int i = 0; i < wsc::appConfig::squareOffSliceOrders; i++)
+                {
+                    _sliceOrderBook[side].push_back(
+                        API2::COMMON::OrderWrapperPool::shared().acquire(
+                            _contract,
+                            side == 0 ? API2::CONSTANTS::CMD_OrderMode_BUY : API2::CONSTANTS::CMD_OrderMode_SELL,
+                            this,
+                            _userParams.account,
+                            API2::CONSTANTS::CMD_OrderType_LIMIT));
+                    _sliceOrderBook[side][i]->reset();
+                }
+                _squareOffExecutors[side].reset(new API2::COMMON::SlicedOrderExecutor(_sliceOrderBook[side],
+                                                                                      staticData->freezeQuantity,
+                                                                                      staticData->marketLot,
+                                                                                      0,
+                                                                                      wsc::appConfig::squareOffSliceMaxPerWindow,
+                                                                                      wsc::appConfig::squareOffSliceWindowMicros));
+            }
         }
     }
 
@@ -562,14 +1473,33 @@ namespace SampleTemplate
         return isValid;
     }
 
+    void Template::processTradeTicks()
+    {
+        // called before mid is updated, so trades are signed against the quote prevailing when they happened
+        _tradeTicks.consume([this](const API2::COMMON::TradeTickEntry *ticks, size_t count)
+                            {
+                                _tradeFlow.onTrades(ticks, count, _midPrice);
+                                for (size_t i = 0; i < count; ++i)
+                                    _bars.onTrade(ticks[i].price, ticks[i].qty, ticks[i].timestamp);
+                            });
+    }
+
     void Template ::orderManager()
     {
+        ALLOCATION_SCOPE("orderManager");
         // DEBUG_PRINT;
         _lastMsgSentCount = _msgSentCount;
+        SIGNED_LONG buyOpenQty = 0;
+        SIGNED_LONG sellOpenQty = 0;
+        for (int i = 0; i < _ordersPoolSize; i++)
+        {
+            buyOpenQty += _buyOrderBook[i]->_lastQuantity - _buyOrderBook[i]->_lastFilledQuantity;
+            sellOpenQty += _sellOrderBook[i]->_lastQuantity - _sellOrderBook[i]->_lastFilledQuantity;
+        }
         // BUY Side
         for (int i = 0; i < _ordersPoolSize; i++)
         {
-            auto &_order = _buyOrderBook[i];
+            auto &_order = *_buyOrderBook[i];
             auto _internalOrder = _internalBuyOrderBook[i];
             //If Order present in InternalBook
             if (_internalOrder.qty > 0)
@@ -577,19 +1507,26 @@ namespace SampleTemplate
                 //If Order Not present in Book then send new Order
                 if (_order._isReset)
                 {
-                    if (_order.newOrder(_riskStatus, _internalOrder.price, _internalOrder.qty))
+                    if (isWithinRiskLimits(_order, _internalOrder, buyOpenQty) && _order.newOrder(_riskStatus, _internalOrder.price, _internalOrder.qty))
                     {
                         ++_msgSentCount;
+                        API2::COMMON::OrderState previous = _buyOrderStates.getState(i);
+                        _buyOrderStates.onRequest(i, API2::COMMON::OrderEvent_NEW_REQUEST, _order);
+                        updateOrderTimers(true, i, previous);
                     }
                 }
                 //If Order  present in Book then check for Modify Order
                 else if (_order.getLastQuantity())
                 {
-                    if ((_order._lastQuotedPrice != _internalOrder.price && abs(_order._lastQuotedPrice - _internalOrder.price) >= _minPriceDiff) || _order._lastQuantity != _internalOrder.qty)
+                    if (((_order._lastQuotedPrice != _internalOrder.price && abs(_order._lastQuotedPrice - _internalOrder.price) >= _minPriceDiff) || _order._lastQuantity != _internalOrder.qty) &&
+                        isWithinRiskLimits(_order, _internalOrder, buyOpenQty))
                     {
                         if (_order.replaceOrder(_riskStatus, _internalOrder.price, _internalOrder.qty))
                         {
                             ++_msgSentCount;
+                            API2::COMMON::OrderState previous = _buyOrderStates.getState(i);
+                            _buyOrderStates.onRequest(i, API2::COMMON::OrderEvent_REPLACE_REQUEST, _order);
+                            updateOrderTimers(true, i, previous);
                         }
                     }
                 }
@@ -600,6 +1537,9 @@ namespace SampleTemplate
                 if (_order.cancelOrder(_riskStatus))
                 {
                     ++_msgSentCount;
+                    API2::COMMON::OrderState previous = _buyOrderStates.getState(i);
+                    _buyOrderStates.onRequest(i, API2::COMMON::OrderEvent_CANCEL_REQUEST, _order);
+                    updateOrderTimers(true, i, previous);
                 }
             }
         }
@@ -607,7 +1547,7 @@ namespace SampleTemplate
         // SELL Side
         for (int i = 0; i < _ordersPoolSize; i++)
         {
-            auto &_order = _sellOrderBook[i];
+            auto &_order = *_sellOrderBook[i];
             auto _internalOrder = _internalSellOrderBook[i];
             //If Order present in InternalBook
             if (_internalOrder.qty > 0)
@@ -615,19 +1555,26 @@ namespace SampleTemplate
                 //If Order Not present in Book then send new Order
                 if (_order._isReset)
                 {
-                    if (_order.newOrder(_riskStatus, _internalOrder.price, _internalOrder.qty))
+                    if (isWithinRiskLimits(_order, _internalOrder, sellOpenQty) && _order.newOrder(_riskStatus, _internalOrder.price, _internalOrder.qty))
                     {
                         ++_msgSentCount;
+                        API2::COMMON::OrderState previous = _sellOrderStates.getState(i);
+                        _sellOrderStates.onRequest(i, API2::COMMON::OrderEvent_NEW_REQUEST, _order);
+                        updateOrderTimers(false, i, previous);
                     }
                 }
                 //If Order  present in Book then check for Modify Order
                 else if (_order.getLastQuantity())
                 {
-                    if ((_order._lastQuotedPrice != _internalOrder.price && abs(_order._lastQuotedPrice - _internalOrder.price) >= _minPriceDiff) || _order._lastQuantity != _internalOrder.qty)
+                    if (((_order._lastQuotedPrice != _internalOrder.price && abs(_order._lastQuotedPrice - _internalOrder.price) >= _minPriceDiff) || _order._lastQuantity != _internalOrder.qty) &&
+                        isWithinRiskLimits(_order, _internalOrder, sellOpenQty))
                     {
                         if (_order.replaceOrder(_riskStatus, _internalOrder.price, _internalOrder.qty))
                         {
                             ++_msgSentCount;
+                            API2::COMMON::OrderState previous = _sellOrderStates.getState(i);
+                            _sellOrderStates.onRequest(i, API2::COMMON::OrderEvent_REPLACE_REQUEST, _order);
+                            updateOrderTimers(false, i, previous);
                         }
                     }
                 }
@@ -638,6 +1585,9 @@ namespace SampleTemplate
                 if (_order.cancelOrder(_riskStatus))
                 {
                     ++_msgSentCount;
+                    API2::COMMON::OrderState previous = _sellOrderStates.getState(i);
+                    _sellOrderStates.onRequest(i, API2::COMMON::OrderEvent_CANCEL_REQUEST, _order);
+                    updateOrderTimers(false, i, previous);
                 }
             }
         }
@@ -646,45 +1596,163 @@ namespace SampleTemplate
         //     logPosition(nullptr);
     }
 
+    //Checked only for a new / replace that would be sent, a breach is printed when it differs from the last one of the side, the count is reported on timer events
+    bool Template::isWithinRiskLimits(API2::COMMON::OrderWrapper &order, const wsc::OrderDetails &internalOrder, SIGNED_LONG openQty)
+    {
+        SIGNED_LONG restingQty = order._lastQuantity - order._lastFilledQuantity;
+        API2::COMMON::RiskCheckResult result = API2::COMMON::checkRiskLimits(_riskLimits, order._mode, internalOrder.price, internalOrder.qty, openQty - restingQty, _midPrice);
+        API2::COMMON::RiskCheckResult &lastResult = _lastRiskCheckResult[order._mode == API2::CONSTANTS::CMD_OrderMode_BUY ? 0 : 1];
+        bool isChanged = result != lastResult;
+        lastResult = result;
+        if (result == API2::COMMON::RiskCheck_OK)
+            return true;
+
+        ++_riskRejectCount;
+        if (isChanged)
+            DEBUG_PRINT << API2::COMMON::RiskCheckResultStr(result) << ", B/S: " << wsc::BuySellTypeStr(order._mode)
+                    << ", Price: " << internalOrder.price << ", Qty: " << internalOrder.qty
+                    << ", OpenQty: " << openQty << ", MidPrice: " << _midPrice << ", RiskRejectCount: " << _riskRejectCount;
+        return false;
+    }
+
+    //Capture STG_SNAPSHOT state, the line is formatted by the snapshot thread
     void Template::logSnapshot()
     {
         _grossPnL = (_netPosition.totalSellTradedValue - _netPosition.totalBuyTradedValue) + (_netPosition.netPositionQty * _midPrice);
 
         _netPnL = _grossPnL;
 
-        std::stringstream ss;
+        captureSnapshot(_snapshotLog.claim());
+        _snapshotLog.publish();
+        _isSnapshotPending = false;
+    }
+
+    //Copy of everything STG_SNAPSHOT prints, no formatting and no allocation
+    void Template::captureSnapshot(wsc::SnapshotRecord &record)
+    {
+        record.timestamp = _bookSnapshot.timestamp;
+        record.netPosition = _netPosition;
+        record.grossPnL = _grossPnL;
+        record.netPnL = _netPnL;
+        record.midPrice = _midPrice;
+        record.contractName = _contract->getStaticData()->scripName.c_str();
+        record.msgSentCount = _msgSentCount;
+        record.maxPosLots = _strategyInput.maxPos / _contract->getStaticData()->marketLot;
+        record.ordersPoolSize = _ordersPoolSize;
+        record.orderCount = std::min(_ordersPoolSize, SNAPSHOT_MAX_ORDERS);
+        for (int i = 0; i < record.orderCount; i++)
+        {
+            const API2::COMMON::OrderWrapper *orders[2] = {_buyOrderBook[i], _sellOrderBook[i]};
+            wsc::SnapshotOrder *snapshotOrders[2] = {&record.buyOrders[i], &record.sellOrders[i]};
+            for (int side = 0; side < 2; side++)
+            {
+                const API2::COMMON::OrderWrapper &order = *orders[side];
+                wsc::SnapshotOrder &snapshotOrder = *snapshotOrders[side];
+                snapshotOrder.mode = order._mode;
+                snapshotOrder.orderType = order._orderType;
+                snapshotOrder.contractName = order._instrument->getStaticData()->scripName.c_str();
+                strncpy(snapshotOrder.exchangeOrderId, order._exchangeOrderId.c_str(), sizeof(snapshotOrder.exchangeOrderId) - 1);
+                snapshotOrder.exchangeOrderId[sizeof(snapshotOrder.exchangeOrderId) - 1] = 0;
+                snapshotOrder.isReset = order._isReset;
+                snapshotOrder.price = order._price;
+                snapshotOrder.lastQuotedPrice = order._lastQuotedPrice;
+                snapshotOrder.lastQuantity = order._lastQuantity;
+                snapshotOrder.lastFilledQuantity = order._lastFilledQuantity;
+            }
+            record.internalBuyOrders[i].buySell = _internalBuyOrderBook[i].buySell;
+            record.internalBuyOrders[i].price = _internalBuyOrderBook[i].price;
+            record.internalBuyOrders[i].qty = _internalBuyOrderBook[i].qty;
+            record.internalSellOrders[i].buySell = _internalSellOrderBook[i].buySell;
+            record.internalSellOrders[i].price = _internalSellOrderBook[i].price;
+            record.internalSellOrders[i].qty = _internalSellOrderBook[i].qty;
+        }
+        memcpy(record.bidPriceLevels, _bookSnapshot.bidPriceLevels, sizeof(record.bidPriceLevels));
+        memcpy(record.askPriceLevels, _bookSnapshot.askPriceLevels, sizeof(record.askPriceLevels));
+    }
+
+    //Logging thread, confirmation as a row of the confirmations table, no-op unless PERSIST_DIR is set
+    void Template::persistConfirmation(const wsc::ConfirmationRecord &record)
+    {
+        _persistWriter.append([this, &record](API2::COMMON::RowBuffer &row)
+                              {
+                                  row.addInt(_userParams.stgSymbolId);
+                                  row.addInt(record.timestamp);
+                                  row.addText(record.callback);
+                                  row.addUnsigned(record.clOrderId);
+                                  row.addInt(record.symbolId);
+                                  row.addText(wsc::BuySellTypeStr(record.orderMode));
+                                  row.addInt(record.orderType);
+                                  row.addText(record.exchangeOrderId);
+                                  row.addInt(record.orderStatus);
+                                  row.addUnsigned(record.errorCode);
+                                  row.addInt(record.origOrderPrice);
+                                  row.addInt(record.orderPrice);
+                                  row.addInt(record.orderQuantity);
+                                  row.addInt(record.origLastFillPrice);
+                                  row.addInt(record.lastFillPrice);
+                                  row.addInt(record.lastFillQuantity);
+                                  if (record.wrapperIndex < 0)
+                                  {
+                                      for (int i = 0; i < 7; ++i)
+                                          row.addNull();
+                                      return;
+                                  }
+                                  row.addInt(record.wrapperIndex);
+                                  row.addInt(record.isBuyWrapper);
+                                  row.addInt(record.isProcessed);
+                                  row.addInt(record.isReset);
+                                  row.addInt(record.lastQuotedPrice);
+                                  row.addInt(record.lastQuantity);
+                                  row.addInt(record.lastFilledQuantity);
+                              });
+    }
+
+    //Snapshot thread, one line per snapshot to the report log, see writeReportLine
+    void Template::formatSnapshot(const wsc::SnapshotRecord &record)
+    {
+        auto &ss = _snapshotStream;
+        ss.reset();
+        ss << __FILE__ << ":" << __LINE__ << ", logSnapshot  | ";
+        printSnapshot(ss, record);
+        ss << "\n";
+        const char *line = ss.c_str();
+        writeReportLine(_reportLogFd, line, strlen(line));
+    }
+
+    void Template::printSnapshot(std::ostream &ss, const wsc::SnapshotRecord &record)
+    {
         ss << "STG_SNAPSHOT,";
-        wsc::Time::printTimestamp(ss, _bookSnapshot.timestamp);
-        ss << "," << _netPosition.netPositionQty << "," << _grossPnL << "," << _netPnL << "," << _midPrice
-           << "," << _netPosition.totalSellTradedQty << "," << _netPosition.totalSellTradedValue
-           << "," << _netPosition.totalBuyTradedQty << "," << _netPosition.totalBuyTradedValue
-           << "," << _contract->getStaticData()->scripName;
+        wsc::Time::printTimestamp(ss, record.timestamp);
+        ss << "," << record.netPosition.netPositionQty << "," << record.grossPnL << "," << record.netPnL << "," << record.midPrice
+           << "," << record.netPosition.totalSellTradedQty << "," << record.netPosition.totalSellTradedValue
+           << "," << record.netPosition.totalBuyTradedQty << "," << record.netPosition.totalBuyTradedValue
+           << "," << record.contractName;
         ss << ",,,,,";
-        ss << "," << _msgSentCount << "," << (_strategyInput.maxPos / _contract->getStaticData()->marketLot)
-           << "," << _ordersPoolSize << ",\"[  ";
+        ss << "," << record.msgSentCount << "," << record.maxPosLots
+           << "," << record.ordersPoolSize << ",\"[  ";
 
-        for (size_t i = 0; i < _ordersPoolSize; i++)
+        for (int i = 0; i < record.orderCount; i++)
         {
             ss
                 << " { "
-                << getOrderStr(_buyOrderBook[i])
+                << record.buyOrders[i]
                 << " } , {"
-                << getOrderStr(_sellOrderBook[i])
+                << record.sellOrders[i]
                 << " } ,";
         }
         ss.seekp(-1, ss.cur);
         ss << " ]\",\"[  ";
-        for (size_t i = 0; i < _ordersPoolSize; i++)
+        for (int i = 0; i < record.orderCount; i++)
         {
             ss
                 << " {"
-                << " \"\"BuySellType\"\": \"\"" << wsc::BuySellTypeStr(_internalBuyOrderBook[i].buySell)
-                << "\"\", \"\"Price\"\": " << _internalBuyOrderBook[i].price
-                << ", \"\"Qty\"\": " << _internalBuyOrderBook[i].qty
+                << " \"\"BuySellType\"\": \"\"" << wsc::BuySellTypeStr(record.internalBuyOrders[i].buySell)
+                << "\"\", \"\"Price\"\": " << record.internalBuyOrders[i].price
+                << ", \"\"Qty\"\": " << record.internalBuyOrders[i].qty
                 << "} ,  {"
-                << " \"\"BuySellType\"\": \"\"" << wsc::BuySellTypeStr(_internalSellOrderBook[i].buySell)
-                << "\"\", \"\"Price\"\": " << _internalSellOrderBook[i].price
-                << ", \"\"Qty\"\": " << _internalSellOrderBook[i].qty
+                << " \"\"BuySellType\"\": \"\"" << wsc::BuySellTypeStr(record.internalSellOrders[i].buySell)
+                << "\"\", \"\"Price\"\": " << record.internalSellOrders[i].price
+                << ", \"\"Qty\"\": " << record.internalSellOrders[i].qty
                 << " } ,";
         }
         ss.seekp(-1, ss.cur);
@@ -692,77 +1760,291 @@ namespace SampleTemplate
 
         for (int i = BOOK_SNAPSHOT_PRICE_LEVELS - 1; i >= 0; i--)
             ss << " { "
-               << "\"\"BP\"\": " << _bookSnapshot.bidPriceLevels[i].price
-               << ", \"\"BQ\"\": " << _bookSnapshot.bidPriceLevels[i].quantity
+               << "\"\"BP\"\": " << record.bidPriceLevels[i].price
+               << ", \"\"BQ\"\": " << record.bidPriceLevels[i].quantity
                << "} ,";
         ss.seekp(-1, ss.cur);
         ss << " ]\",\"[  ";
 
         for (int i = 0; i < BOOK_SNAPSHOT_PRICE_LEVELS; i++)
             ss << " { "
-               << "\"\"BP\"\": " << _bookSnapshot.askPriceLevels[i].price
-               << ", \"\"BQ\"\": " << _bookSnapshot.askPriceLevels[i].quantity
+               << "\"\"BP\"\": " << record.askPriceLevels[i].price
+               << ", \"\"BQ\"\": " << record.askPriceLevels[i].quantity
                << "} ,";
         ss.seekp(-1, ss.cur);
         ss << " ]\"  ";
-        DEBUG_PRINT << ss.str();
     }
 
-    const std::string Template::getOrderStr(const API2::COMMON::OrderWrapper &order)
+    //Common handling of all confirmation callbacks, confirmation is only copied for the logging thread,
+    //STG_SNAPSHOT is captured unless the snapshot thread has not formatted the previous one, then it follows on a later confirmation or timer event
+    void Template::orderResHandler(API2::COMMON::OrderEvent event, API2::OrderConfirmation &confirmation, API2::COMMON::OrderId *orderId)
     {
-        std::stringstream ss;
-        ss << "\"\", \"\"BuySellType\"\": \"\"" << wsc::BuySellTypeStr(order._mode)
-           << "\"\", \"\"ContractName\"\": \"\"" << order._instrument->getStaticData()->scripName
-           << "\"\", \"\"OrderType\"\": \"\"" << order._orderType
-           << "\"\", \"\"ExchOrderId\"\": " << order._exchangeOrderId
-           << ", \"\"IsReset\"\": \"\"" << order._isReset
-           << "\"\", \"\"Price\"\": " << order._price
-           << "\"\", \"\"LastQuotedPrice\"\": " << order._lastQuotedPrice
-           << ", \"\"Quantity\"\": " << order._lastQuantity
-           << ", \"\"QuantityTraded\"\": " << order._lastFilledQuantity
-           << "\"\"";
-        return ss.str();
-    }
-
-    void Template::orderResHandler(API2::OrderConfirmation &confirmation, API2::COMMON::OrderId *orderId)
-    {
-        DEBUG_PRINT
-            << " BuySellType: " << wsc::BuySellTypeStr(confirmation.getOrderMode())
-            << ", ContractName: " << confirmation.getSymbolId()
-            << ", OrderType: " << (int16_t)confirmation.getOrderType()
-            << ", ExchOrderId: " << confirmation.getExchangeOrderId()
-            << ", OrderStatus: " << confirmation.getOrderStatus()
-            << ", OrigOrderPrice: " << confirmation.getOrigOrderPrice()
-            << ", OrderPrice: " << confirmation.getOrderPrice()
-            << ", Quantity: " << confirmation.getOrderQuantity()
-            << ", OrigLastFillPrice: " << confirmation.getOrigLastFillPrice()
-            << ", LastFillPrice: " << confirmation.getLastFillPrice()
-            << ", LastFillQuantity: " << confirmation.getLastFillQuantity();
+        wsc::ConfirmationRecord *record = _confirmationLog.claim();
+        if (record)
+        {
+            record->timestamp = wsc::Time::getSystemTimestamp();
+            record->callback = API2::COMMON::OrderEventStr(event);
+            record->clOrderId = confirmation.getClOrderId();
+            record->symbolId = confirmation.getSymbolId();
+            record->origOrderPrice = confirmation.getOrigOrderPrice();
+            record->orderPrice = confirmation.getOrderPrice();
+            record->origLastFillPrice = confirmation.getOrigLastFillPrice();
+            record->lastFillPrice = confirmation.getLastFillPrice();
+            record->orderQuantity = confirmation.getOrderQuantity();
+            record->lastFillQuantity = confirmation.getLastFillQuantity();
+            record->errorCode = confirmation.getErrorCode();
+            record->orderStatus = confirmation.getOrderStatus();
+            record->orderType = (int16_t)confirmation.getOrderType();
+            record->orderMode = confirmation.getOrderMode();
+            strncpy(record->exchangeOrderId, confirmation.getExchangeOrderIdCharPtr(), sizeof(record->exchangeOrderId) - 1);
+            record->exchangeOrderId[sizeof(record->exchangeOrderId) - 1] = 0;
+            record->wrapperIndex = -1;
+            record->isProcessed = false;
+        }
+
+        API2::COMMON::OrderWrapper *wrapper = NULL;
         for (int op = 0; op < _ordersPoolSize; ++op)
         {
-            DEBUG_PRINT << " orderId: " << orderId << " - " << _buyOrderBook[op]._orderId << " - " << _sellOrderBook[op]._orderId;
-            if (_buyOrderBook[op]._orderId == orderId)
+            API2::COMMON::OrderStateMachine *orderStates = NULL;
+            if (_buyOrderBook[op]->_orderId == orderId)
             {
-                DEBUG_PRINT;
-                if (!processConfirmation(_buyOrderBook[op], confirmation, orderId))
-                {
-                    // DEBUG_MESSAGE(reqQryDebugLog(), "Process Confirmation Failed");
-                    DEBUG_PRINT << "ProcessConfirmation Failed";
-                }
-                break;
+                wrapper = _buyOrderBook[op];
+                orderStates = &_buyOrderStates;
+            }
+            else if (_sellOrderBook[op]->_orderId == orderId)
+            {
+                wrapper = _sellOrderBook[op];
+                orderStates = &_sellOrderStates;
+            }
+            else
+                continue;
+
+            bool isProcessed = processConfirmation(*wrapper, *orderStates, op, event, confirmation);
+            if (record)
+            {
+                record->wrapperIndex = op;
+                record->isBuyWrapper = wrapper == _buyOrderBook[op];
+                record->isProcessed = isProcessed;
+            }
+            break;
+        }
+        if (wrapper == NULL)
+        {
+            int index = -1;
+            bool isBuy = false;
+            wrapper = processSliceConfirmation(event, confirmation, orderId, index, isBuy);
+            if (wrapper && record)
+            {
+                record->wrapperIndex = index;
+                record->isBuyWrapper = isBuy;
+                record->isProcessed = true;
+            }
+        }
+
+        if (record)
+        {
+            if (wrapper)
+            {
+                record->isReset = wrapper->_isReset;
+                record->lastQuotedPrice = wrapper->_lastQuotedPrice;
+                record->lastQuantity = wrapper->_lastQuantity;
+                record->lastFilledQuantity = wrapper->_lastFilledQuantity;
+            }
+            _confirmationLog.publish();
+        }
+        // a confirmation delivered inside a requote stays pending for the next tick or timer
+        if (_isRequotePending && wsc::appConfig::isRequoteOnConfirmation && !_isRequoting)
+        {
+            if (takeRequoteSlot())
+                requote();
+            else
+                ++_requoteThrottledCount;
+        }
+        saveCheckpoint();
+        _isSnapshotPending = true;
+        if (!_snapshotLog.hasUnread())
+            logSnapshot();
+        else
+            ++_snapshotDeferredCount;
+    }
+
+    //Map checkpoint file of this strategy, true if it holds a recent checkpoint of the same symbol
+    //Loaded checkpoint is applied by restoreCheckpoint once instrument and order wrappers exist
+    bool Template::loadCheckpoint(const std::string &symbolName)
+    {
+        DEBUG_PRINT;
+        if (wsc::appConfig::checkpointDir.empty())
+            return false;
+
+        std::string error;
+        std::string path = wsc::appConfig::checkpointDir + "/STG_" + std::to_string(_userParams.stgSymbolId) + ".ckpt";
+        if (!_checkpointFile.open(path, CHECKPOINT_VERSION, sizeof(_checkpointBuffer), error))
+        {
+            DEBUG_MESSAGE(debugLog(), "Checkpoint disabled: " + error);
+            return false;
+        }
+
+        bool isLoaded = _checkpointFile.load(_checkpointBuffer) &&
+                        API2::COMMON::FixedCodec<wsc::StrategyCheckpoint>::decode(_checkpointBuffer, sizeof(_checkpointBuffer), _checkpoint);
+        int64_t age = wsc::Time::getSystemTimestamp() - _checkpoint.timestamp;
+        bool isValid = isLoaded &&
+                       _checkpoint.stgSymbolId == _userParams.stgSymbolId &&
+                       symbolName.compare(0, std::string::npos, _checkpoint.symbolName, strnlen(_checkpoint.symbolName, sizeof(_checkpoint.symbolName))) == 0 &&
+                       age >= 0 && age <= wsc::appConfig::checkpointMaxAgeSec * NANO_SECONDS_IN_SEC;
+        if (isLoaded && !isValid)
+            DEBUG_MESSAGE(debugLog(), "Checkpoint of " + std::string(_checkpoint.symbolName, strnlen(_checkpoint.symbolName, sizeof(_checkpoint.symbolName))) + ", age sec " + std::to_string(age / NANO_SECONDS_IN_SEC) + " not used, cold start");
+        if (!isValid)
+        {
+            _checkpoint = wsc::StrategyCheckpoint();
+            strncpy(_checkpoint.symbolName, symbolName.c_str(), sizeof(_checkpoint.symbolName) - 1);
+        }
+        DEBUG_PRINT << "Checkpoint " << path << ", sequence: " << _checkpointFile.getSequence() << ", warm restart: " << isValid;
+        return isValid;
+    }
+
+    //Restore counters and internal books of previous run, order wrappers stay reset
+    //A wrapper can not be rebound to an order of previous run: OrderId is created by createNewOrderId for a new order only and
+    //the runtime has no lookup from client order id to OrderId, so replace / cancel / confirmations of such an order never reach
+    //a wrapper. Orders of previous run still working are cancelled instead, their side is not quoted until that is confirmed
+    void Template::restoreCheckpoint()
+    {
+        if (!_isWarmRestart)
+            return;
+        DEBUG_PRINT;
+
+        int savedOrders = 0;
+        int count = std::min(std::min(_ordersPoolSize, _checkpoint.ordersPoolSize), CHECKPOINT_MAX_ORDERS);
+        for (int i = 0; i < count; i++)
+        {
+            for (int side = 0; side < 2; side++)
+            {
+                const wsc::CheckpointOrder &savedOrder = side == 0 ? _checkpoint.buyOrders[i] : _checkpoint.sellOrders[i];
+                if (savedOrder.isReset || savedOrder.clOrderId == 0)
+                    continue;
+                savedOrders++;
+                if (getLeftoverOrder(savedOrder.clOrderId) == NULL)
+                    continue;
+                _leftoverOrders[side][i] = savedOrder.clOrderId;
+                _leftoverOrderCount[side]++;
+                std::stringstream ss;
+                ss << "Order of previous run still working, cancelling, clOrderId: " << savedOrder.clOrderId
+                   << ", ExchOrderId: " << savedOrder.exchangeOrderId << ", B/S: " << (side == 0 ? "B" : "S")
+                   << ", price: " << savedOrder.lastQuotedPrice << ", qty: " << savedOrder.lastQuantity;
+                DEBUG_PRINT << ss.str();
+                DEBUG_MESSAGE(debugLog(), ss.str());
             }
-            else if (_sellOrderBook[op]._orderId == orderId)
+            _internalBuyOrderBook[i].price = _checkpoint.buyOrders[i].internalPrice;
+            _internalBuyOrderBook[i].qty = _checkpoint.buyOrders[i].internalQty;
+            _internalSellOrderBook[i].price = _checkpoint.sellOrders[i].internalPrice;
+            _internalSellOrderBook[i].qty = _checkpoint.sellOrders[i].internalQty;
+        }
+        _msgSentCount = _lastMsgSentCount = _checkpoint.msgSentCount;
+        _riskRejectCount = _reportedRiskRejectCount = _checkpoint.riskRejectCount;
+
+        if (_checkpoint.maxPos != _strategyInput.maxPos || _checkpoint.maxOrderValue != _strategyInput.maxOrderValue ||
+            _checkpoint.maxOpenLots != _strategyInput.maxOpenLots || _checkpoint.collarTicks != _strategyInput.collarTicks)
+        {
+            DEBUG_MESSAGE(debugLog(), "Strategy inputs changed since checkpoint, config values are used");
+        }
+
+        // orders filled while the strategy was down show up here, position always comes from the runtime
+        _netPosition = _checkpoint.netPosition;
+        updateNetPosition();
+        std::stringstream ss;
+        ss << "Warm restart, checkpoint sequence: " << _checkpointFile.getSequence() << ", orders of previous run cancelled: "
+           << _leftoverOrderCount[0] + _leftoverOrderCount[1] << " of " << savedOrders << ", NetPos: " << _netPosition.netPositionQty
+           << " (checkpoint " << _checkpoint.netPosition.netPositionQty << ")";
+        DEBUG_PRINT << ss.str();
+        DEBUG_MESSAGE(debugLog(), ss.str());
+        checkLeftoverOrders();
+    }
+
+    //Order of previous run, found by client order id, NULL once it is in a final state and can not fill any more
+    API2::SingleOrder *Template::getLeftoverOrder(API2::DATA_TYPES::CLORDER_ID clOrderId)
+    {
+        API2::SingleOrder *liveOrder = reqQryOrder(clOrderId);
+        if (liveOrder == NULL || (UNSIGNED_LONG)liveOrder->getSymbolId() != _contract->getSymbolId() || isOrderStatusDone(liveOrder->getOrderStatus()))
+            return NULL;
+        return liveOrder;
+    }
+
+    //Timer event while orders of previous run are left, drops the ones that are done and cancels the rest
+    //No OrderId refers to them, the cancel goes out the way a front end cancel of a manual order does, repeated every
+    //LEFTOVER_CANCEL_RETRY_MICROS until the order is done. A side is quoted again once it has no leftover
+    void Template::checkLeftoverOrders()
+    {
+        if (_leftoverOrderCount[0] == 0 && _leftoverOrderCount[1] == 0)
+            return;
+        int64_t now = wsc::Time::getSystemTimestamp();
+        bool isCancelDue = now >= _leftoverCancelTimestamp + LEFTOVER_CANCEL_RETRY_MICROS * NANO_SECONDS_IN_MICRO_SEC;
+        for (int side = 0; side < 2; side++)
+        {
+            for (int i = 0; i < CHECKPOINT_MAX_ORDERS; i++)
             {
-                DEBUG_PRINT;
-                if (!processConfirmation(_sellOrderBook[op], confirmation, orderId))
+                if (_leftoverOrders[side][i] == 0)
+                    continue;
+                API2::SingleOrder *liveOrder = getLeftoverOrder(_leftoverOrders[side][i]);
+                if (liveOrder != NULL)
                 {
-                    // DEBUG_MESSAGE(reqQryDebugLog(), "Process Confirmation Failed");
-                    DEBUG_PRINT << "ProcessConfirmation Failed";
+                    if (isCancelDue)
+                        API2::SGContext::onPendingCancelOrder(liveOrder);
+                    continue;
+                }
+                DEBUG_PRINT << "Order of previous run done, clOrderId: " << _leftoverOrders[side][i];
+                _leftoverOrders[side][i] = 0;
+                if (--_leftoverOrderCount[side] == 0)
+                {
+                    DEBUG_MESSAGE(debugLog(), std::string("Orders of previous run done, quoting resumed on ") + (side == 0 ? "buy" : "sell") + " side");
+                    updateNetPosition();
+                    _isRequotePending = true;
                 }
-                break;
             }
         }
-        logSnapshot();
+        if (isCancelDue)
+            _leftoverCancelTimestamp = now;
+    }
+
+    //Encode strategy state into the checkpoint mapping, no allocation and no system call
+    void Template::saveCheckpoint()
+    {
+        // open orders are cancelled on terminate, a restart after it starts cold
+        if (!_checkpointFile.isOpen() || _terminateCheck)
+            return;
+
+        _checkpoint.timestamp = wsc::Time::getSystemTimestamp();
+        _checkpoint.stgSymbolId = _userParams.stgSymbolId;
+        _checkpoint.symbolId = _contract->getSymbolId();
+        _checkpoint.maxPos = _strategyInput.maxPos;
+        _checkpoint.maxOrderValue = _strategyInput.maxOrderValue;
+        _checkpoint.maxOpenLots = _strategyInput.maxOpenLots;
+        _checkpoint.collarTicks = _strategyInput.collarTicks;
+        _checkpoint.netPosition = _netPosition;
+        _checkpoint.msgSentCount = _msgSentCount;
+        _checkpoint.riskRejectCount = _riskRejectCount;
+        _checkpoint.ordersPoolSize = std::min(_ordersPoolSize, CHECKPOINT_MAX_ORDERS);
+        for (int i = 0; i < _checkpoint.ordersPoolSize; i++)
+        {
+            for (int side = 0; side < 2; side++)
+            {
+                API2::COMMON::OrderWrapper &order = side == 0 ? *_buyOrderBook[i] : *_sellOrderBook[i];
+                const wsc::OrderDetails &internalOrder = side == 0 ? _internalBuyOrderBook[i] : _internalSellOrderBook[i];
+                wsc::CheckpointOrder &savedOrder = side == 0 ? _checkpoint.buyOrders[i] : _checkpoint.sellOrders[i];
+                savedOrder.clOrderId = order._order ? order._order->getClOrdId() : 0;
+                // a leftover of previous run stays in the checkpoint until it is done, its slot is not quoted meanwhile
+                if (order._isReset && _leftoverOrders[side][i] != 0)
+                    savedOrder.clOrderId = _leftoverOrders[side][i];
+                savedOrder.lastQuotedPrice = order._lastQuotedPrice;
+                savedOrder.lastQuantity = order._lastQuantity;
+                savedOrder.lastFilledQuantity = order._lastFilledQuantity;
+                strncpy(savedOrder.exchangeOrderId, order._exchangeOrderId.c_str(), sizeof(savedOrder.exchangeOrderId) - 1);
+                savedOrder.internalPrice = internalOrder.price;
+                savedOrder.internalQty = internalOrder.qty;
+                savedOrder.isReset = order._isReset && _leftoverOrders[side][i] == 0;
+                savedOrder.isPending = order.isOrderPending();
+            }
+        }
+        if (API2::COMMON::FixedCodec<wsc::StrategyCheckpoint>::encode(_checkpoint, _checkpointBuffer, sizeof(_checkpointBuffer)) != 0)
+            _checkpointFile.save(_checkpointBuffer);
     }
 
 }
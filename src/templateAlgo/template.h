@@ -2,11 +2,28 @@
 #define TEMPLATE_H
 
 #include "../common/common.h"
+#include "../common/riskLimits.h"
+#include "../common/tradingCalendar.h"
+#include "../common/tradeTickStream.h"
+#include "../common/barAggregator.h"
+#include "../common/orderWrapperPool.h"
+#include "../common/allocationCounter.h"
+#include "../common/checkpointFile.h"
+#include "../common/deferredLog.h"
+#include "../common/slabLog.h"
+#include "../common/conflatingLog.h"
+#include "../common/quotingPolicy.h"
+#include "../common/orderStateMachine.h"
+#include "../common/timingWheel.h"
+#include "../common/slicedOrderExecutor.h"
+#include "../common/volatilitySurface.h"
 #include <api2UserCommands.h>
 #include <api2Exceptions.h>
 #include <orderWrapperAPI.h>
 #include <sgContext.h>
 #include <cmdDefines.h>
+#include <memory>
+#include <type_traits>
 #include "types.h"
 
 namespace SampleTemplate
@@ -25,6 +42,17 @@ namespace SampleTemplate
     }
   };
 
+  /**
+   * @brief streams order wrapper fields of STG_SNAPSHOT / confirmation logs without building a string
+   */
+  struct OrderStr
+  {
+    const API2::COMMON::OrderWrapper &order;
+  };
+  std::ostream &operator<<(std::ostream &os, const OrderStr &orderStr);
+
+  class TemplateBench;
+
   /**
  * @brief Derived from SGContext, this class Drives our strategy through callbacks
  * @brief Handle the Bidding leg
@@ -33,6 +61,8 @@ namespace SampleTemplate
  */
   class Template : public API2::SGContext
   {
+    // microbenchmarks drive private hot functions directly, see bench/templateBench.cpp
+    friend class TemplateBench;
 
     /**
      * @brief Save Parameters Received from FrontEnd
@@ -68,6 +98,7 @@ namespace SampleTemplate
 
     API2::COMMON::Instrument *_contract;
     API2::COMMON::MktData *_mktData;
+    wsc::BookSnapshotCache::Entry *_bookCacheEntry = NULL;
     wsc::BookSnapshot _bookSnapshot;
     wsc::NetPositionDetails _netPosition;
 
@@ -76,41 +107,169 @@ namespace SampleTemplate
     wsc::StrategyInput _strategyInput;
     int16_t _tickSleepCount = 0;
     int _minPriceDiff = 0;
-
-    // strategy pools objects
-    std::vector<API2::COMMON::OrderWrapper> _buyOrderBook;
-    std::vector<API2::COMMON::OrderWrapper> _sellOrderBook;
+    API2::COMMON::RiskLimits _riskLimits;
+    API2::COMMON::TradingCalendar _calendar;
+    size_t _calendarIndex = 0;
+    // quote prices come from the policy of QUOTING_POLICY, quote() is compiled once per policy
+    API2::COMMON::QuotingPolicyType _quotingPolicyType = API2::COMMON::QuotingPolicy_FIXED_LEVEL;
+    API2::COMMON::QuotingParams _quotingParams;
+
+    // trade ticks of onTradeTickEvent, consumed in one batch on market data / timer events
+    API2::COMMON::TradeTickRing<4096> _tradeTicks;
+    API2::COMMON::TradeFlowStats _tradeFlow{60 * NANO_SECONDS_IN_SEC};
+    uint64_t _tradeTickOverflowCount = 0;
+
+    // 1s / 5s / 1m / 5m bars from trade ticks and book mids, closed bars are delivered on timer event
+    API2::COMMON::BarAggregator _bars{{NANO_SECONDS_IN_SEC, 5 * NANO_SECONDS_IN_SEC, 60 * NANO_SECONDS_IN_SEC, 300 * NANO_SECONDS_IN_SEC}, 512};
+    // new positions pause while the last closed 1 minute bar is wider than BAR_RANGE_PAUSE_TICKS, 0 disables
+    static const size_t BAR_RANGE_TIMEFRAME = 2;
+    int _barRangePauseTicks = 0;
+    bool _isBarRangePaused = false;
+
+    // smile of the option contract's expiry when IV_SURFACE_STRIKES is set, chain mids are stored on market data events,
+    // IV solve and fit run on the IV surface worker, quote() reads the latest snapshot
+    struct IvSurfaceSymbol
+    {
+        UNSIGNED_LONG symbolId;
+        API2::COMMON::MktData *mktData;
+        size_t node;
+        bool isUnderlying;
+    };
+    std::unique_ptr<API2::COMMON::VolatilitySurface> _ivSurface;
+    std::vector<IvSurfaceSymbol> _ivSurfaceSymbols;
+    API2::COMMON::VolatilitySurface::Snapshot _ivSnapshot;
+    size_t _ivSurfaceExpiry = 0;
+    size_t _ivContractNode = 0;
+    double _ivContractStrike = 0;
+    bool _isContractCall = false;
+    // new positions are not quoted closer than IV_EDGE_TICKS to the fair value of the contract on the smile
+    int _ivEdgeTicks = 0;
+
+    // strategy pools objects, wrappers live in OrderWrapperPool::shared() so their addresses never change
+    std::vector<API2::COMMON::OrderWrapper *> _buyOrderBook;
+    std::vector<API2::COMMON::OrderWrapper *> _sellOrderBook;
     std::vector<wsc::OrderDetails> _internalBuyOrderBook;
     std::vector<wsc::OrderDetails> _internalSellOrderBook;
+    // lifecycle state of each wrapper, same index as _buyOrderBook / _sellOrderBook
+    API2::COMMON::OrderStateMachine _buyOrderStates;
+    API2::COMMON::OrderStateMachine _sellOrderStates;
+    uint64_t _illegalTransitionCount = 0;
+    // square off (internal book index 1) above the freeze quantity, sliced over wrappers of its own, index 0 buy / 1 sell
+    // the executor of a side owns its square off from start until all its children are done
+    std::vector<API2::COMMON::OrderWrapper *> _sliceOrderBook[2];
+    std::unique_ptr<API2::COMMON::SlicedOrderExecutor> _squareOffExecutors[2];
+    // requote on confirmation, counted per window so a reject / requote loop can not flood the exchange
+    bool _isRequotePending = false;
+    bool _isRequoting = false;
+    int64_t _requoteWindowStart = 0;
+    int _requoteWindowCount = 0;
+    uint64_t _requoteThrottledCount = 0;
+    uint64_t _reportedRequoteThrottledCount = 0;
+    // ack timeout / resting age of each wrapper, wheel is advanced on timer events which then run every ORDER_TIMER_TICK_MICROS
+    API2::COMMON::TimingWheel _orderTimers{4096, 10 * NANO_SECONDS_IN_MILI_SEC};
+    std::vector<wsc::OrderTimers> _buyOrderTimers;
+    std::vector<wsc::OrderTimers> _sellOrderTimers;
+    int _timerEventInterval = wsc::appConfig::smConsumerInterval;
+    int64_t _nextConsumerTimestamp = 0;
+    uint64_t _stuckOrderCount = 0;
+    uint64_t _reportedStuckOrderCount = 0;
+    uint64_t _orderTimerOverflowCount = 0;
 
 
     // strategy controller
     API2::DATA_TYPES::RiskStatus _riskStatus;
     uint32_t _lastMsgSentCount = 0;
     bool _isRunning = false;
+    bool _isThreadPlaced = false;
     int _lotSize = 0;
     int _ordersPoolSize = 0;
 
     uint32_t _msgSentCount = 0;
+    uint32_t _riskRejectCount = 0;
+    uint32_t _reportedRiskRejectCount = 0;
+    API2::COMMON::RiskCheckResult _lastRiskCheckResult[2] = {API2::COMMON::RiskCheck_OK, API2::COMMON::RiskCheck_OK}; // buy, sell
     int64_t _scopeLatency = -1;
     long _grossPnL = 0;
     long _netPnL = 0;
     long _midPrice = 0;
-
+    // STG_SNAPSHOT state is captured here, the snapshot thread formats the latest one into _snapshotStream
+    API2::COMMON::ConflatingLog<wsc::SnapshotRecord> _snapshotLog;
+    wsc::FixedBufferStream<16384> _snapshotStream;
+    uint64_t _snapshotDeferredCount = 0;
+    uint64_t _snapshotMergedCount = 0;
+    // STG_SNAPSHOT and CONFIRMATION lines, REPORT_LOG_DIR file or -1 for stdout
+    int _reportLogFd = -1;
+
+    // warm restart, state is saved on order requests, confirmations and timer events
+    API2::COMMON::CheckpointFile _checkpointFile;
+    wsc::StrategyCheckpoint _checkpoint = wsc::StrategyCheckpoint();
+    char _checkpointBuffer[API2::COMMON::FixedCodec<wsc::StrategyCheckpoint>::ENCODED_SIZE];
+    bool _isWarmRestart = false;
+    // orders of previous run still working at exchange by side and slot, cancelled on restart, a side is not quoted while one is left
+    static const int64_t LEFTOVER_CANCEL_RETRY_MICROS = 500000;
+    API2::DATA_TYPES::CLORDER_ID _leftoverOrders[2][CHECKPOINT_MAX_ORDERS] = {};
+    int _leftoverOrderCount[2] = {};
+    int64_t _leftoverCancelTimestamp = 0;
+
+    // confirmations are copied here by the callbacks and formatted on the logging thread
+    API2::COMMON::DeferredLog<wsc::ConfirmationRecord> _confirmationLog{4096};
+    uint64_t _confirmationOverflowCount = 0;
+    bool _isSnapshotPending = false;
+    // confirmations appended as table rows on the logging thread, written in batches by the writer thread when PERSIST_DIR is set
+    API2::COMMON::BatchedRowWriter _persistWriter;
+    uint64_t _persistBlockedCount = 0;
+    uint64_t _persistErrorCount = 0;
+
+    // debug log of this strategy, runtime debug log until DEBUG_LOG_DIR file is open
+    API2::COMMON::SlabLog _debugLog;
+    uint64_t _debugLogDropCount = 0;
+
+    void start();
     void initSetUp();
     void setAppConfig();
     void updateNetPosition();
     void updateBookSnapshot();
+    void processTradeTicks();
+    void placeStrategyThread();
+    void calibrateStrategyJitter();
+    void onBarClose(size_t timeframe, const API2::COMMON::BarAggregator::Bar &bar);
+
+    bool loadCheckpoint(const std::string &symbolName);
+    void restoreCheckpoint();
+    API2::SingleOrder *getLeftoverOrder(API2::DATA_TYPES::CLORDER_ID clOrderId);
+    void checkLeftoverOrders();
+    void saveCheckpoint();
 
     API2::DATA_TYPES::SYMBOL_ID getSymbolID(const std::string &source, const std::string &exchange, const std::string &symbol, const std::string &expiary = "", const std::string &strikePrice = "", const std::string &optType = "");
     void onBookSnapshot(UNSIGNED_LONG symbolId);
+    void updateInternalOrders();
+    void requote();
+    void manageSquareOff();
+    void pumpSquareOff();
+    API2::COMMON::OrderWrapper *processSliceConfirmation(API2::COMMON::OrderEvent event, API2::OrderConfirmation &confirmation, API2::COMMON::OrderId *orderId, int &index, bool &isBuy);
+    bool takeRequoteSlot();
+    void updateOrderTimers(bool isBuy, size_t index, API2::COMMON::OrderState previous);
+    void onOrderTimer(uint32_t kind, uint64_t data);
+    template <typename Policy>
+    void quote();
+    void joinOtherOrders(API2::COMMON::QuoteTargets &targets);
+    void setUpIvSurface(const std::string &strikes, double interestRate);
+    void addIvSurfaceSymbol(API2::DATA_TYPES::SYMBOL_ID symbolId, bool isUnderlying, size_t node);
+    void updateIvSurface(UNSIGNED_LONG symbolId);
+    void applyIvFairValue(API2::COMMON::QuoteTargets &targets);
 
     void createOrders();
     bool isValidBookSnapshot();
+    bool isWithinRiskLimits(API2::COMMON::OrderWrapper &order, const wsc::OrderDetails &internalOrder, SIGNED_LONG openQty);
     void orderManager();
     void logSnapshot();
-    const std::string getOrderStr(const API2::COMMON::OrderWrapper &order);
-    void orderResHandler(API2::OrderConfirmation &confirmation, API2::COMMON::OrderId *orderId);
+    void captureSnapshot(wsc::SnapshotRecord &record);
+    void formatSnapshot(const wsc::SnapshotRecord &record);
+    void persistConfirmation(const wsc::ConfirmationRecord &record);
+    static void printSnapshot(std::ostream &os, const wsc::SnapshotRecord &record);
+    OrderStr getOrderStr(const API2::COMMON::OrderWrapper &order) { return OrderStr{order}; }
+    API2::COMMON::SlabLog *debugLog() { return &_debugLog; }
+    void orderResHandler(API2::COMMON::OrderEvent event, API2::OrderConfirmation &confirmation, API2::COMMON::OrderId *orderId);
 
   public:
     /**
@@ -119,6 +278,30 @@ namespace SampleTemplate
      */
     Template(API2::StrategyParameters *params);
 
+    /**
+     * @brief Constructor with already parsed front end parameters, used to run the strategy without front end (e.g. templateAlgo_bench)
+     * @param pointer to StrategyParameters
+     * @param userParams
+     */
+    Template(API2::StrategyParameters *params, const FrontEndParameters &userParams);
+
+    /**
+     * @brief Destructor, returns order wrappers to the pool
+     */
+    ~Template();
+
+    /**
+     * @brief Template holds cache line aligned queues and counters, plain new of -std=c++0x does not honour alignof(Template)
+     */
+    static void *operator new(size_t size)
+    {
+        void *memory = NULL;
+        if (posix_memalign(&memory, alignof(Template), size) != 0)
+            throw std::bad_alloc();
+        return memory;
+    }
+    static void operator delete(void *memory) { free(memory); }
+
     /* ---------------------------------------------Implementation Functions --------------------------------------------------*/
 
     /**
@@ -163,13 +346,15 @@ namespace SampleTemplate
 
     /**
      * @type Implementation Function
-     * @brief process OrderConfirmation of a given order Wrapper
+     * @brief process OrderConfirmation of a given order Wrapper, state of the wrapper moves on event of the callback
      * @param orderWrapper
+     * @param orderStates - state machine of the wrapper's side
+     * @param index - index of the wrapper in its side
+     * @param event - event of the callback
      * @param Confirmation
-     * @param orderId
-     * @return void
+     * @return return value of OrderWrapper::processConfirmation
      */
-    bool processConfirmation(API2::COMMON::OrderWrapper &orderWrapper, API2::OrderConfirmation &confirmation, const API2::COMMON::OrderId *orderId);
+    bool processConfirmation(API2::COMMON::OrderWrapper &orderWrapper, API2::COMMON::OrderStateMachine &orderStates, size_t index, API2::COMMON::OrderEvent event, API2::OrderConfirmation &confirmation);
 
     /* ---------------------------------------------Workflow Functions --------------------------------------------------*/
 
@@ -181,6 +366,15 @@ namespace SampleTemplate
      */
     void onMarketDataEvent(UNSIGNED_LONG symbolId) override;
 
+    /**
+     * @type WorkFlow Function/CallBack Function
+     * @brief Receive a callback for every trade of a symbol subscribed to TBT, when started with trade tick events
+     * @param symbolId
+     * @param tradeTick
+     * @return void
+     */
+    void onTradeTickEvent(API2::DATA_TYPES::SYMBOL_ID symbolId, API2::COMMON::TradeTick tradeTick) override;
+
     /**
      * @type WorkFlow Function/CallBack Function
      * @brief Receive a callback whenever Timer has expired of reqTimerEvent
@@ -11,5 +11,34 @@ namespace wsc
     bool appConfig::tickToOrderLatencyFlag = false;
     int appConfig::smConsumerInterval = 0;
     int appConfig::minValidObLevel = 0;
+    API2::COMMON::ThreadPlacement appConfig::strategyThread("Strategy");
+    API2::COMMON::ThreadPlacement appConfig::auxThread("Aux");
+    API2::COMMON::ThreadPlacement appConfig::debugLogThread("DebugLog");
+    API2::COMMON::ThreadPlacement appConfig::confirmationLogThread("ConfirmationLog");
+    API2::COMMON::ThreadPlacement appConfig::snapshotLogThread("SnapshotLog");
+    API2::COMMON::ThreadPlacement appConfig::persistThread("PersistWriter");
+    API2::COMMON::ThreadPlacement appConfig::ivSurfaceThread("IvSurface");
+    int appConfig::jitterCalibrationMs = 0;
+    std::string appConfig::checkpointDir = "";
+    int appConfig::checkpointMaxAgeSec = 300;
+    bool appConfig::saveConfirmationToDebugLog = false;
+    std::string appConfig::debugLogDir = "";
+    std::string appConfig::reportLogDir = "";
+    bool appConfig::isSharedBookCache = false;
+    bool appConfig::isRequoteOnConfirmation = true;
+    bool appConfig::isTradeTickEvent = true;
+    int appConfig::requoteMaxPerWindow = 20;
+    int appConfig::requoteWindowMicros = 1000000;
+    int appConfig::orderTimerTickMicros = 10000;
+    int appConfig::orderAckTimeoutMicros = 2000000;
+    int appConfig::orderMaxRestingSec = 0;
+    int appConfig::squareOffSliceOrders = 4;
+    int appConfig::squareOffSliceMaxPerWindow = 20;
+    int appConfig::squareOffSliceWindowMicros = 1000000;
+    std::string appConfig::persistDir = "";
+    API2::COMMON::RowWriterTarget appConfig::persistTarget = API2::COMMON::RowWriterTarget_SQLITE;
+    int appConfig::persistMaxRows = 500;
+    int appConfig::persistMaxBytes = 1048576;
+    int appConfig::persistFlushMicros = 1000000;
 
 }
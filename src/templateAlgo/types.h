@@ -3,6 +3,11 @@
 #include "../wscCommon/util.h"
 #include "../wscCommon/sysZTime.h"
 #include "../wscCommon/util.h"
+#include "../common/threadPlacement.h"
+#include "../common/bookCache.h"
+#include "../common/batchedRowWriter.h"
+#include "../common/fixedLayout.h"
+#include <sharedDefines.h>
 
 namespace wsc
 {
@@ -17,6 +22,60 @@ namespace wsc
         static bool tickToOrderLatencyFlag;
         static int smConsumerInterval;
         static int minValidObLevel;
+
+        // thread placement, strategy callback thread and each worker thread spawned by strategy code,
+        // auxThread is the default of the workers, a worker with keys of its own takes them over it
+        static API2::COMMON::ThreadPlacement strategyThread;
+        static API2::COMMON::ThreadPlacement auxThread;
+        static API2::COMMON::ThreadPlacement debugLogThread;
+        static API2::COMMON::ThreadPlacement confirmationLogThread;
+        static API2::COMMON::ThreadPlacement snapshotLogThread;
+        static API2::COMMON::ThreadPlacement persistThread;
+        static API2::COMMON::ThreadPlacement ivSurfaceThread;
+        static int jitterCalibrationMs;
+
+        // warm restart, checkpoint file is <checkpointDir>/STG_<stgSymbolId>.ckpt, empty dir disables it
+        static std::string checkpointDir;
+        static int checkpointMaxAgeSec;
+
+        // confirmations are logged by a worker thread on confirmationLogThread, runtime debug log copy is optional
+        static bool saveConfirmationToDebugLog;
+
+        // debug log file is <debugLogDir>/STG_<stgSymbolId>.log written by a worker thread on debugLogThread, empty keeps the runtime debug log
+        static std::string debugLogDir;
+
+        // STG_SNAPSHOT and CONFIRMATION lines go to <reportLogDir>/STG_<stgSymbolId>.report.log, empty writes them to stdout
+        static std::string reportLogDir;
+
+        // depth of a symbol is read from MktData once per update and shared by the strategies trading it
+        static bool isSharedBookCache;
+
+        // orders are recomputed from the last book as soon as a confirmation frees an order or moves the position,
+        // at most requoteMaxPerWindow of them per requoteWindowMicros (0 no limit), a throttled one waits for the next tick or timer
+        static bool isRequoteOnConfirmation;
+        static bool isTradeTickEvent;
+        static int requoteMaxPerWindow;
+        static int requoteWindowMicros;
+
+        // order deadlines on a timing wheel advanced every orderTimerTickMicros by the timer event, 0 disables a deadline
+        // a request not confirmed in orderAckTimeoutMicros gets a cancel sent even while pending, an open order without fill is canceled after orderMaxRestingSec
+        static int orderTimerTickMicros;
+        static int orderAckTimeoutMicros;
+        static int orderMaxRestingSec;
+
+        // square off above the freeze quantity is sliced into freeze compliant children over squareOffSliceOrders wrappers per side,
+        // at most squareOffSliceMaxPerWindow new children per squareOffSliceWindowMicros (0 no limit), 0 wrappers leaves it to the risk check (rejected)
+        static int squareOffSliceOrders;
+        static int squareOffSliceMaxPerWindow;
+        static int squareOffSliceWindowMicros;
+
+        // confirmations are persisted as rows of <persistDir>/STG_<stgSymbolId>.db (SQLITE) or .csv (CSV) by a writer thread on persistThread, empty dir disables it
+        // a batch is written once it holds persistMaxRows rows, persistMaxBytes of text or is persistFlushMicros old
+        static std::string persistDir;
+        static API2::COMMON::RowWriterTarget persistTarget;
+        static int persistMaxRows;
+        static int persistMaxBytes;
+        static int persistFlushMicros;
     };
 
     struct StrategyInput
@@ -24,6 +83,257 @@ namespace wsc
 
         int maxPos = 0;
 
+        // pre-trade risk limits, 0 disables the limit
+        double maxOrderValue = 0;
+        int maxOpenLots = 0;
+        int collarTicks = 0;
+    };
+
+    enum OrderTimerKind
+    {
+        OrderTimer_ACK = 1,
+        OrderTimer_RESTING
+    };
+
+    // deadlines of one order wrapper on the strategy timing wheel
+    struct OrderTimers
+    {
+        uint64_t ackTimerId = 0;
+        uint64_t restingTimerId = 0;
+        int ackTimeoutCount = 0; // ack timeouts since the last state change
+    };
+
+    // confirmation as received plus state of the matched wrapper after processing, formatted later by the logging thread
+    struct ConfirmationRecord
+    {
+        int64_t timestamp;
+        const char *callback;
+        uint64_t clOrderId;
+        int64_t symbolId;
+        int64_t origOrderPrice;
+        int64_t orderPrice;
+        int64_t origLastFillPrice;
+        int64_t lastFillPrice;
+        int64_t orderQuantity;
+        int64_t lastFillQuantity;
+        uint32_t errorCode;
+        uint16_t orderStatus;
+        int16_t orderType;
+        API2::DATA_TYPES::OrderMode orderMode;
+        char exchangeOrderId[CONF_EXCHANGE_ORDERID_SIZE + 1];
+
+        // matched wrapper, index in buy or sell order book (square off slices follow the book), -1 if not an order of this strategy
+        int wrapperIndex;
+        bool isBuyWrapper;
+        bool isProcessed;
+        bool isReset;
+        int64_t lastQuotedPrice;
+        int64_t lastQuantity;
+        int64_t lastFilledQuantity;
     };
 
+    typedef API2::COMMON::BookCache<BookSnapshot> BookSnapshotCache;
+
+#define SNAPSHOT_MAX_ORDERS 8
+
+    // order wrapper fields of an STG_SNAPSHOT ActiveOrderBook entry
+    struct SnapshotOrder
+    {
+        API2::DATA_TYPES::OrderMode mode;
+        API2::DATA_TYPES::OrderType orderType;
+        const char *contractName;
+        char exchangeOrderId[32];
+        bool isReset;
+        int64_t price;
+        int64_t lastQuotedPrice;
+        int64_t lastQuantity;
+        int64_t lastFilledQuantity;
+    };
+
+    struct SnapshotInternalOrder
+    {
+        API2::DATA_TYPES::OrderMode buySell;
+        int price;
+        int qty;
+    };
+
+    // state printed in STG_SNAPSHOT, captured by the strategy thread and formatted by the snapshot thread
+    struct SnapshotRecord
+    {
+        int64_t timestamp;
+        NetPositionDetails netPosition;
+        long grossPnL;
+        long netPnL;
+        long midPrice;
+        const char *contractName;
+        uint32_t msgSentCount;
+        int maxPosLots;
+        int ordersPoolSize;
+        int orderCount; // entries captured, at most SNAPSHOT_MAX_ORDERS
+        SnapshotOrder buyOrders[SNAPSHOT_MAX_ORDERS];
+        SnapshotOrder sellOrders[SNAPSHOT_MAX_ORDERS];
+        SnapshotInternalOrder internalBuyOrders[SNAPSHOT_MAX_ORDERS];
+        SnapshotInternalOrder internalSellOrders[SNAPSHOT_MAX_ORDERS];
+        BookPriceLevel bidPriceLevels[BOOK_SNAPSHOT_PRICE_LEVELS];
+        BookPriceLevel askPriceLevels[BOOK_SNAPSHOT_PRICE_LEVELS];
+    };
+
+#define CHECKPOINT_VERSION 2
+#define CHECKPOINT_MAX_ORDERS 8
+
+    // order wrapper and internal book slot as saved in the checkpoint
+    struct CheckpointOrder
+    {
+        uint64_t clOrderId;
+        int64_t lastQuotedPrice;
+        int64_t lastQuantity;
+        int64_t lastFilledQuantity;
+        char exchangeOrderId[32];
+        int internalPrice;
+        int internalQty;
+        bool isReset;
+        bool isPending;
+    };
+
+    // strategy state saved by Template::saveCheckpoint, encoded with FixedCodec into the mapping
+    struct StrategyCheckpoint
+    {
+        int64_t timestamp;
+        int64_t stgSymbolId;
+        int64_t symbolId;
+        char symbolName[128];
+        int maxPos;
+        double maxOrderValue;
+        int maxOpenLots;
+        int collarTicks;
+        NetPositionDetails netPosition;
+        uint32_t msgSentCount;
+        uint32_t riskRejectCount;
+        int ordersPoolSize;
+        CheckpointOrder buyOrders[CHECKPOINT_MAX_ORDERS];
+        CheckpointOrder sellOrders[CHECKPOINT_MAX_ORDERS];
+    };
+
+    // type ids of the fixed layouts below, an encoded buffer of one type is refused by the codec of another
+    enum LayoutType
+    {
+        LayoutType_BOOK_PRICE_LEVEL = 1,
+        LayoutType_BOOK_SNAPSHOT,
+        LayoutType_NET_POSITION_DETAILS,
+        LayoutType_STG_SYMBOL_CONFIG,
+        LayoutType_ORDER_DETAILS,
+        LayoutType_CHECKPOINT_ORDER,
+        LayoutType_STRATEGY_CHECKPOINT
+    };
+
+}
+
+// wire layouts of the strategy structs for checkpoints, journals and messages between strategies, see fixedLayout.h
+// a field added, removed or resized needs the VERSION of its struct and of every struct containing it bumped
+namespace API2
+{
+    namespace COMMON
+    {
+        template <>
+        struct FixedLayout<wsc::BookPriceLevel>
+        {
+            static const uint32_t TYPE_ID = wsc::LayoutType_BOOK_PRICE_LEVEL;
+            static const uint32_t VERSION = 1;
+            typedef FixedFields<API2_FIXED_FIELD(wsc::BookPriceLevel, price),
+                                API2_FIXED_FIELD(wsc::BookPriceLevel, quantity),
+                                API2_FIXED_FIELD(wsc::BookPriceLevel, orderCount)>
+                Fields;
+        };
+
+        template <>
+        struct FixedLayout<wsc::BookSnapshot>
+        {
+            static const uint32_t TYPE_ID = wsc::LayoutType_BOOK_SNAPSHOT;
+            static const uint32_t VERSION = 1;
+            typedef FixedFields<API2_FIXED_FIELD(wsc::BookSnapshot, timestamp),
+                                API2_FIXED_FIELD(wsc::BookSnapshot, contractId),
+                                API2_FIXED_FIELD(wsc::BookSnapshot, bidPriceLevels),
+                                API2_FIXED_FIELD(wsc::BookSnapshot, askPriceLevels)>
+                Fields;
+        };
+
+        template <>
+        struct FixedLayout<wsc::NetPositionDetails>
+        {
+            static const uint32_t TYPE_ID = wsc::LayoutType_NET_POSITION_DETAILS;
+            static const uint32_t VERSION = 1;
+            typedef FixedFields<API2_FIXED_FIELD(wsc::NetPositionDetails, contractId),
+                                API2_FIXED_FIELD(wsc::NetPositionDetails, netPositionQty),
+                                API2_FIXED_FIELD(wsc::NetPositionDetails, totalBuyTradedValue),
+                                API2_FIXED_FIELD(wsc::NetPositionDetails, totalBuyTradedQty),
+                                API2_FIXED_FIELD(wsc::NetPositionDetails, totalSellTradedValue),
+                                API2_FIXED_FIELD(wsc::NetPositionDetails, totalSellTradedQty)>
+                Fields;
+        };
+
+        template <>
+        struct FixedLayout<wsc::StgSymbolConfig>
+        {
+            static const uint32_t TYPE_ID = wsc::LayoutType_STG_SYMBOL_CONFIG;
+            static const uint32_t VERSION = 1;
+            typedef FixedFields<API2_FIXED_STRING_FIELD(wsc::StgSymbolConfig, source, 32),
+                                API2_FIXED_STRING_FIELD(wsc::StgSymbolConfig, exchange, 32),
+                                API2_FIXED_STRING_FIELD(wsc::StgSymbolConfig, symbol, 64),
+                                API2_FIXED_STRING_FIELD(wsc::StgSymbolConfig, expiary, 16),
+                                API2_FIXED_STRING_FIELD(wsc::StgSymbolConfig, strikePrice, 16),
+                                API2_FIXED_STRING_FIELD(wsc::StgSymbolConfig, optType, 8)>
+                Fields;
+        };
+
+        template <>
+        struct FixedLayout<wsc::OrderDetails>
+        {
+            static const uint32_t TYPE_ID = wsc::LayoutType_ORDER_DETAILS;
+            static const uint32_t VERSION = 1;
+            typedef FixedFields<API2_FIXED_FIELD(wsc::OrderDetails, buySell),
+                                API2_FIXED_FIELD(wsc::OrderDetails, price),
+                                API2_FIXED_FIELD(wsc::OrderDetails, qty)>
+                Fields;
+        };
+
+        // order wrapper state
+        template <>
+        struct FixedLayout<wsc::CheckpointOrder>
+        {
+            static const uint32_t TYPE_ID = wsc::LayoutType_CHECKPOINT_ORDER;
+            static const uint32_t VERSION = 1;
+            typedef FixedFields<API2_FIXED_FIELD(wsc::CheckpointOrder, clOrderId),
+                                API2_FIXED_FIELD(wsc::CheckpointOrder, lastQuotedPrice),
+                                API2_FIXED_FIELD(wsc::CheckpointOrder, lastQuantity),
+                                API2_FIXED_FIELD(wsc::CheckpointOrder, lastFilledQuantity),
+                                API2_FIXED_FIELD(wsc::CheckpointOrder, exchangeOrderId),
+                                API2_FIXED_FIELD(wsc::CheckpointOrder, internalPrice),
+                                API2_FIXED_FIELD(wsc::CheckpointOrder, internalQty),
+                                API2_FIXED_FIELD(wsc::CheckpointOrder, isReset),
+                                API2_FIXED_FIELD(wsc::CheckpointOrder, isPending)>
+                Fields;
+        };
+
+        template <>
+        struct FixedLayout<wsc::StrategyCheckpoint>
+        {
+            static const uint32_t TYPE_ID = wsc::LayoutType_STRATEGY_CHECKPOINT;
+            static const uint32_t VERSION = CHECKPOINT_VERSION;
+            typedef FixedFields<API2_FIXED_FIELD(wsc::StrategyCheckpoint, timestamp),
+                                API2_FIXED_FIELD(wsc::StrategyCheckpoint, stgSymbolId),
+                                API2_FIXED_FIELD(wsc::StrategyCheckpoint, symbolId),
+                                API2_FIXED_FIELD(wsc::StrategyCheckpoint, symbolName),
+                                API2_FIXED_FIELD(wsc::StrategyCheckpoint, maxPos),
+                                API2_FIXED_FIELD(wsc::StrategyCheckpoint, maxOrderValue),
+                                API2_FIXED_FIELD(wsc::StrategyCheckpoint, maxOpenLots),
+                                API2_FIXED_FIELD(wsc::StrategyCheckpoint, collarTicks),
+                                API2_FIXED_FIELD(wsc::StrategyCheckpoint, netPosition),
+                                API2_FIXED_FIELD(wsc::StrategyCheckpoint, msgSentCount),
+                                API2_FIXED_FIELD(wsc::StrategyCheckpoint, riskRejectCount),
+                                API2_FIXED_FIELD(wsc::StrategyCheckpoint, ordersPoolSize),
+                                API2_FIXED_FIELD(wsc::StrategyCheckpoint, buyOrders),
+                                API2_FIXED_FIELD(wsc::StrategyCheckpoint, sellOrders)>
+                Fields;
+        };
+    }
 }
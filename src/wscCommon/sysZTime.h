@@ -59,10 +59,12 @@ namespace wsc
 
 			std::time_t t = timestamp / 1000000000LL;
 			// os << std::put_time(std::localtime(&t), "%Z %Y-%m-%d %T.") << std::setfill('0') << std::setw(9) << std::max(timestamp % 1000000000LL, 0LL);
-			os << std::localtime(&t)->tm_zone << " " << 1900 + std::localtime(&t)->tm_year << "-"
-			   << 1 + std::localtime(&t)->tm_mon << "-" << std::localtime(&t)->tm_mday << " "
-			   << std::localtime(&t)->tm_hour << ":" << std::localtime(&t)->tm_min << ":"
-			   << std::localtime(&t)->tm_sec 
+			std::tm tm;
+			localtime_r(&t, &tm);
+			os << tm.tm_zone << " " << 1900 + tm.tm_year << "-"
+			   << 1 + tm.tm_mon << "-" << tm.tm_mday << " "
+			   << tm.tm_hour << ":" << tm.tm_min << ":"
+			   << tm.tm_sec
 			   << std::setfill('0') << std::setw(9) << std::max(timestamp % 1000000000LL, 0LL);
 		}
 
@@ -155,11 +157,13 @@ namespace wsc
 
 		static const date::time_zone *getTimezoneIST()
 		{
-			return date::locate_zone("Asia/Kolkata");
+			static const date::time_zone *tz = date::locate_zone("Asia/Kolkata");
+			return tz;
 		}
 		static const date::time_zone *getTimezoneUTC()
 		{
-			return date::locate_zone("Etc/UTC");
+			static const date::time_zone *tz = date::locate_zone("Etc/UTC");
+			return tz;
 		}
 
 	private:
@@ -19,7 +19,8 @@ struct X
     ~X() { std::cout << std::endl; }
 };
 #define AT std::string(__FILE__) + ":" + std::to_string(__LINE__) + ", " + std::string(__FUNCTION__) + " "
-#define DEBUG_PRINT (X(), std::cout << AT << " | ")
+// streams location pieces directly, building AT would allocate on every call
+#define DEBUG_PRINT (X(), std::cout << __FILE__ << ":" << __LINE__ << ", " << __FUNCTION__ << "  | ")
 
 
 namespace wsc
@@ -120,6 +121,53 @@ namespace wsc
         }
     }
 
+    // streambuf over a fixed char array, writes past capacity fail instead of growing
+    template <size_t CAPACITY>
+    class FixedStreamBuffer : public std::streambuf
+    {
+        char _data[CAPACITY + 1];
+
+    public:
+        FixedStreamBuffer() { setp(_data, _data + CAPACITY); }
+
+        void reset() { setp(_data, _data + CAPACITY); }
+
+        const char *c_str()
+        {
+            *pptr() = '\0';
+            return _data;
+        }
+
+    protected:
+        // only relative moves of the put position are supported e.g. seekp(-1, ss.cur)
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+        {
+            if (dir != std::ios_base::cur || !(which & std::ios_base::out))
+                return pos_type(off_type(-1));
+            off_type pos = (pptr() - pbase()) + off;
+            if (pos < 0 || pos > epptr() - pbase())
+                return pos_type(off_type(-1));
+            pbump((int)off);
+            return pos_type(pos);
+        }
+    };
+
+    // std::stringstream replacement for hot paths, reuse it with reset() so no call allocates
+    template <size_t CAPACITY>
+    class FixedBufferStream : private FixedStreamBuffer<CAPACITY>, public std::ostream
+    {
+    public:
+        FixedBufferStream() : std::ostream(static_cast<FixedStreamBuffer<CAPACITY> *>(this)) {}
+
+        void reset()
+        {
+            FixedStreamBuffer<CAPACITY>::reset();
+            clear();
+        }
+
+        const char *c_str() { return FixedStreamBuffer<CAPACITY>::c_str(); }
+    };
+
     //*************
     struct MyPriceLevel
     {